@@ -6,6 +6,7 @@
 #include <string_view>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 struct Char
 {
     std::string_view utf8_value;
@@ -112,4 +113,5 @@ is_mix_char(NativeInt ch)
 
 using IsMixChar = IntValidatorToFunctor<is_mix_char>;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -8,6 +8,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 
 template <bool is_view, typename T>
@@ -333,4 +334,5 @@ using SliceMutable = Slice<false>;
 
 using SliceView = Slice<true>;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
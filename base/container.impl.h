@@ -1,9 +1,11 @@
 #pragma once
 #include <base/container.decl.h>
 #include <base/math.h>
+#include <cstdint>
 #include <utility>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 template <OwnershipKind kind, bool is_signed, size_t size>
 ValidatedInt<IsInClosedInterval<-1, 1>> IntegralContainer<kind, is_signed, size>::native_sign() const
 {
@@ -55,7 +57,18 @@ template <OwnershipKind kind, bool is_signed, size_t size>
         return ValidatedWord::constructor(native_sign() * accum);
     }
     else
-    {   ValidatedInt<IsInClosedInterval<0, lut[unsigned_size] - 1>> const unsigned_result = details::multiply_add<size_t(is_signed)>(container, std::make_index_sequence<unsigned_size>());
+    {   
+        ValidatedInt<IsInClosedInterval<0, lut[unsigned_size] - 1>> unsigned_result = deduce<IsInClosedInterval<0, lut[unsigned_size] - 1>>(to_interval(zero));
+        if constexpr (byte_size_is_power_of_2)
+        {
+            // The bytes are bit fields, so they are or-ed into place instead of being multiplied by powers of byte_size
+            std::uint64_t bits = 0;
+            for (size_t i = is_signed; i < size; i++)
+                bits = bits << bits_in_byte | std::uint64_t(container[i].byte.raw_unwrap());
+            unsigned_result = ValidatedUtils::from_bits<unsigned_size * bits_in_byte>(std::get<1>(ValidatedUtils::from_abs(NativeInt(bits))), 0);
+        }
+        else
+            unsigned_result = details::multiply_add<size_t(is_signed)>(container, std::make_index_sequence<unsigned_size>());
         if constexpr (!is_signed)
             return unsigned_result;
         else
@@ -63,4 +76,5 @@ template <OwnershipKind kind, bool is_signed, size_t size>
     }
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -7,6 +7,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <typename T>
 class VectorQueue
@@ -64,4 +65,5 @@ public:
     }
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
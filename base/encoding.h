@@ -4,6 +4,7 @@
 #include <string_view>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 // Converts utf8 string to mix string 
 class Decoder
@@ -23,4 +24,5 @@ class Encoder
     }
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
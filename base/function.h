@@ -3,6 +3,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <typename ReturnT, typename ArgT, ReturnT (*fn)(ArgT)>
 struct FuncToFunctor
@@ -20,4 +21,5 @@ using ValidatorToFunctor = FuncToFunctor<bool, ArgT, fn>;
 template <IntValidator fn>
 using IntValidatorToFunctor = ValidatorToFunctor<NativeInt, fn>;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
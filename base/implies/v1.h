@@ -5,6 +5,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 // v1 only supports tree-like graphs of implications
 // if we wish to avoid ambiguous implicit conversions.
@@ -56,4 +57,5 @@ IMPLIES(is_mix_positive_word, is_mix_word)
 
 #undef IMPLIES
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -6,6 +6,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 // v2 allows arbitrary DAGS
 // No cycles though.
 
@@ -73,4 +74,5 @@ consteval bool implies()
 
 
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
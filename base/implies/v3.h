@@ -8,6 +8,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 // https://stackoverflow.com/questions/25958259/how-do-i-find-out-if-a-tuple-contains-a-type
 template <typename T, typename Tuple>
@@ -298,5 +299,6 @@ static_assert(implies<
 static_assert(implies<IsRegisterIndex, IsInClosedInterval<0, 6>>());
 static_assert(implies<IsRegisterIndex, IsInClosedInterval<0, 3099>>());
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
 
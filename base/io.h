@@ -11,6 +11,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
     template <typename CharT, typename OstreamT>
     concept IsOstream = requires(OstreamT os)
@@ -93,5 +94,6 @@ namespace mix
         }
     };
     static_assert(IsOstream<char, StdOstream>);
+MIX_END_BYTE_SIZE_NAMESPACE
 }
 
@@ -2,12 +2,14 @@
 #include <base/types.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 // Instead of providing a generalized constexpr integral pow function,
 // let's only compute powers up to 11 due to rAX.
 // Higher powers are unnecessary.
+template <typename T = NativeInt, size_t size = numerical_bytes_in_word + 1>
 [[gnu::always_inline]] 
 static constexpr
-std::array<NativeInt, numerical_bytes_in_extended_word + 1> 
+std::array<T, size> 
 pow_lookup_table(NativeByte base);
 
 [[gnu::always_inline]] 
@@ -21,4 +23,5 @@ static constexpr
 NativeInt
 pow(NativeByte base);
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
\ No newline at end of file
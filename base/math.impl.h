@@ -1,17 +1,21 @@
 #pragma once
 #include "base/types.decl.h"
 #include <base/math.decl.h>
+
+#include <bit>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 // Instead of providing a generalized constexpr integral pow function,
 // let's only compute powers up to 11 due to rAX.
 // Higher powers are unnecessary.
+template <typename T, size_t size>
 constexpr 
-std::array<NativeInt, numerical_bytes_in_extended_word + 1> 
+std::array<T, size> 
 pow_lookup_table(NativeByte base)
 {
-    std::array<NativeInt, numerical_bytes_in_extended_word + 1> lut;
+    std::array<T, size> lut;
     lut[0] = 1;
     for (size_t i = 1; i < lut.size(); i++)
         lut[i] = lut[i - 1] * base;
@@ -30,10 +34,11 @@ constexpr
 NativeInt
 pow(NativeByte base)
 {
-    static_assert(0 <= exponent && exponent <= 2 * numerical_bytes_in_word);
+    static_assert(0 <= exponent && exponent <= numerical_bytes_in_word);
     return pow(base, exponent);
 }
 
+// Powers of byte_size up to a word
 constexpr auto lut = pow_lookup_table(byte_size);
 constexpr NativeInt mix_int_max = lut[numerical_bytes_in_word] - 1;
 constexpr NativeInt mix_int_min = -mix_int_max;
@@ -42,4 +47,46 @@ static_assert(-(lut.back() - 1) >= std::numeric_limits<NativeInt>::min());
 // Every positive MIX integral value must be representable by NativeInt
 static_assert(lut.back() - 1 <= std::numeric_limits<NativeInt>::max());
 
+// Powers of byte_size up to an extended word
+constexpr auto extended_lut = pow_lookup_table<NativeExtendedUInt, numerical_bytes_in_extended_word + 1>(byte_size);
+static_assert(extended_lut.back() / byte_size == extended_lut[numerical_bytes_in_extended_word - 1]);
+
+// When byte_size is a power of 2, moving a value by whole bytes is a bit shift
+constexpr bool byte_size_is_power_of_2 = std::has_single_bit(byte_size);
+constexpr size_t bits_in_byte = std::countr_zero(byte_size);
+
+// Multiplies a magnitude by byte_size^count
+template <typename T>
+[[gnu::always_inline]] inline constexpr
+T shift_bytes_up(T magnitude, size_t count)
+{
+    if constexpr (byte_size_is_power_of_2)
+        return magnitude << (count * bits_in_byte);
+    else
+        return magnitude * T(extended_lut[count]);
+}
+
+// Divides a magnitude by byte_size^count
+template <typename T>
+[[gnu::always_inline]] inline constexpr
+T shift_bytes_down(T magnitude, size_t count)
+{
+    if constexpr (byte_size_is_power_of_2)
+        return magnitude >> (count * bits_in_byte);
+    else
+        return magnitude / T(extended_lut[count]);
+}
+
+// Keeps the rightmost count bytes of a magnitude
+template <typename T>
+[[gnu::always_inline]] inline constexpr
+T low_bytes(T magnitude, size_t count)
+{
+    if constexpr (byte_size_is_power_of_2)
+        return magnitude & ((T(1) << (count * bits_in_byte)) - 1);
+    else
+        return magnitude % T(extended_lut[count]);
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
 }
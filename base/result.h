@@ -139,7 +139,10 @@ public:
             if constexpr (ResultTraits<decltype(std::declval<ValueTransformT>()(std::declval<ValueT>()))>::is_result)
                 return value_transform(value_);
             else if constexpr (std::is_void_v<typename ResultType::value_type>)
+            {
+                value_transform(value_);
                 return ResultType::success();
+            }
             else
                 return ResultType::success(value_transform(value_));
         }
@@ -148,7 +151,10 @@ public:
             if constexpr (ResultTraits<decltype(std::declval<ErrorTransformT>()(std::declval<ErrorT>()))>::is_result)
                 return error_transform(error_);
             else if constexpr (std::is_void_v<typename ResultType::error_type>)
+            {
+                error_transform(error_);
                 return ResultType::failure();
+            }
             else
                 return ResultType::failure(error_transform(error_));
         }
@@ -164,7 +170,10 @@ public:
             if constexpr (ResultTraits<decltype(std::declval<ValueTransformT>()(std::declval<ValueT>()))>::is_result)
                 return value_transform(value_);
             else if constexpr (std::is_void_v<typename ResultType::value_type>)
+            {
+                value_transform(value_);
                 return ResultType::success();
+            }
             else
                 return ResultType::success(value_transform(value_));
         }
@@ -352,7 +361,10 @@ public:
             if constexpr (ResultTraits<decltype(std::declval<ValueTransformT>()(std::declval<ValueT>()))>::is_result)
                 return std::forward<ValueTransformT>(value_transform)(value_);
             else if constexpr (std::is_void_v<typename ResultType::value_type>)
+            {
+                std::forward<ValueTransformT>(value_transform)(value_);
                 return ResultType::success();
+            }
             else
                 return ResultType::success(std::forward<ValueTransformT>(value_transform)(value_));
         }
@@ -375,7 +387,10 @@ public:
             if constexpr (ResultTraits<decltype(std::declval<ValueTransformT>()(std::declval<ValueT>()))>::is_result)
                 return value_transform(value_);
             else if constexpr (std::is_void_v<typename ResultType::value_type>)
+            {
+                value_transform(value_);
                 return ResultType::success();
+            }
             else
                 return ResultType::success(value_transform(value_));
         }
@@ -8,6 +8,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
     using string = std::basic_string<NativeByte>;
     using string_view = std::basic_string_view<NativeByte>;
     
@@ -98,4 +99,5 @@ namespace mix
         return ResultType::success(word_result.value());
     }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
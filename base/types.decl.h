@@ -20,6 +20,7 @@
 using namespace std::string_view_literals;
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 // The size of main memory of a MIX machine in terms of the number of MIX words
 constexpr size_t main_memory_size = 4000;
 
@@ -56,6 +57,10 @@ static_assert(representable_values_v<NativeByte> >= byte_size);
 // require that NativeInt is large enough to hold the largest value of 
 // any representable integral value.
 using NativeInt = long long;
+
+// A native unsigned integer type capable of representing the magnitude of rAX,
+// which is as large as the product of two MIX words and overflows NativeInt when byte_size is 100.
+__extension__ using NativeExtendedUInt = unsigned __int128;
 template <typename T>
 using PassByValueOrRef = std::conditional_t<std::is_trivially_copyable_v<T> && sizeof(T) <= 16, T, T const &>;
 template <typename T>
@@ -85,4 +90,5 @@ operator-(Sign sign)
     const_cast<std::remove_const_t<std::remove_reference_t<decltype(*ptr)>> *>(ptr)
 
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -2,6 +2,7 @@
 #include <base/types.decl.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 constexpr 
 Sign
@@ -12,4 +13,5 @@ sign(NativeInt value)
     return value > 0 ? s_plus : s_minus;
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
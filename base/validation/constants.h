@@ -2,6 +2,7 @@
 #include <base/validation/v2.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 constexpr ValidatedLiteral<0> zero = ValidatedLiteral<0>::constructor(0).value();
 constexpr ValidatedLiteral<1> one = ValidatedLiteral<1>::constructor(1).value();
@@ -12,4 +13,5 @@ constexpr ValidatedLiteral<5> five = ValidatedLiteral<5>::constructor(5).value()
 constexpr ValidatedLiteral<6> six = ValidatedLiteral<6>::constructor(6).value();
 constexpr ValidatedLiteral<byte_size> validated_byte_size = ValidatedLiteral<byte_size>::constructor(byte_size).value();
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
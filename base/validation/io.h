@@ -9,6 +9,7 @@
 #include <base/data_structures/vector_queue.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 constexpr size_t max_char_len = []{
     size_t max_char_len = 0;
@@ -156,4 +157,5 @@ struct MixOstream
 
 static_assert(IsOstream<Byte, MixOstream>);
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -5,6 +5,7 @@
 #include <base/validation/constants.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 union Byte
 {
     ValidatedByte byte;
@@ -48,51 +49,48 @@ as_bytes(NativeInt i)
         sign, 
         abs_value
     ] = ValidatedUtils::from_abs(i);
-    ValidatedNonNegative value = abs_value;
 
-    std::array<DeferredValue<Byte>, size> result;
-    for (size_t s = size; s --> 1;)
+    if constexpr (byte_size_is_power_of_2)
     {
-        ValidatedBounded<0, byte_size - 1> const residue = ValidatedUtils::from_mod<byte_size>(value);
-        result[s].construct(residue);
-        value = value / validated_byte_size;
+        // Each byte is a bit field of abs_value, so there is nothing to divide
+        std::array<Byte, size> bytes;
+        bytes[0] = sign;
+        for (size_t s = 1; s < size; s++)
+            bytes[s] = ValidatedByte(ValidatedUtils::from_bits<bits_in_byte>(abs_value, (size - 1 - s) * bits_in_byte));
+        return ByteConversionResult<size>{
+            .bytes = bytes,
+            .overflow = (std::uint64_t(abs_value.raw_unwrap()) >> ((size - 1) * bits_in_byte)) != 0
+        };
     }
+    else
+    {
+        ValidatedNonNegative value = abs_value;
+
+        std::array<DeferredValue<Byte>, size> result;
+        for (size_t s = size; s --> 1;)
+        {
+            ValidatedBounded<0, byte_size - 1> const residue = ValidatedUtils::from_mod<byte_size>(value);
+            result[s].construct(residue);
+            value = value / validated_byte_size;
+        }
 
-    result[0].construct(sign);
-    
-    return ByteConversionResult<size>{
-        .bytes = actualize_reinterpret(result),
-        .overflow = value > 0
-    };
+        result[0].construct(sign);
+        
+        return ByteConversionResult<size>{
+            .bytes = actualize_reinterpret(result),
+            .overflow = value > 0
+        };
+    }
 }
 
+// A word never overflows
 inline
 std::array<Byte, bytes_in_word> 
 as_bytes(ValidatedWord word)
 {
-    static constexpr auto validated_ten = deduce<IsNonNegative>(from_literal<10>());
-
-    auto const [
-        sign, 
-        abs_value
-    ] = ValidatedUtils::from_abs(word);
-    ValidatedNonNegative value = abs_value;
-
-    std::array<DeferredValue<Byte>, bytes_in_word> result;
-    for (size_t s = result.size(); s --> 1;)
-    {
-        ValidatedBounded<0, byte_size - 1> const residue = ValidatedUtils::from_mod<byte_size>(value);
-        result[s].construct(residue);
-        value = value / validated_ten;
-    }
-
-    result[0].construct(sign);
-
-    // As long as we use DeferredValue, 
-    // we will need to give up copy elision,
-    // which is unfortunate.
-    return actualize_reinterpret(result);
+    return as_bytes<bytes_in_word>(word).bytes;
 }
 
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -6,6 +6,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <bool (*validator)(NativeInt), typename ConversionT = NativeInt, typename ChildT = void>
 class ValidatedInt;
@@ -19,4 +20,5 @@ using ValidatedRegisterIndex = ValidatedInt<is_register_index, NativeByte>;
 class ValidatedWord;
 using ValidatedPositiveWord = ValidatedInt<is_mix_positive_word>;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
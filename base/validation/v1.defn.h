@@ -4,6 +4,7 @@
 #include <base/result.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <bool (*validator)(NativeInt), typename ConversionT, typename ChildT>
 class ValidatedInt
@@ -148,4 +149,5 @@ public:
     }
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
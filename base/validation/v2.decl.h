@@ -7,6 +7,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <typename StorageT, typename ValidatorT, typename ConversionT = StorageT, typename ChildT = void>
 class ValidatedObject;
@@ -32,4 +33,5 @@ template <typename ItemT, size_t size = std::dynamic_extent>
 using ValidatedNonEmptySpan = ValidatedObject<std::span<ItemT, size>, IsNonEmpty<std::span<ItemT, size>>>; 
 using ValidatedNonEmptyStringView = ValidatedObject<std::string_view, IsNonEmpty<std::string_view>>;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
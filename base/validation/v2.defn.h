@@ -4,10 +4,13 @@
 #include <base/implies/v3.h>
 #include <base/result.h>
 
+#include <cstdint>
+#include <cstdlib>
 #include <string_view>
 #include <type_traits>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 struct ValidatedUtils;
 template <typename StorageT, typename ValidatorT, typename ConversionT, typename ChildT>
 class ValidatedObject
@@ -66,6 +69,23 @@ public:
         return Result<child_type, void>::success(ValidatedObject(value));
     }
 
+    // For a value that the caller already knows to be valid, so that it never fails.
+    // A checked build aborts on a value that is not valid after all, and a trusted build (see config.h) assumes that it is.
+    [[gnu::always_inline]] 
+    static constexpr
+    Result<child_type, void> 
+    trusted_constructor(StorageT value)
+    {
+        if (!validator(value))
+        {
+            if constexpr (trusted_validation)
+                __builtin_unreachable();
+            else
+                std::abort();
+        }
+        return Result<child_type, void>::success(ValidatedObject(value));
+    }
+
     template <typename ...HintsT, typename OtherValidatorT, typename OtherConversionT, typename OtherChildT>
     requires (implies<OtherValidatorT, HintsT..., ValidatorT>())
     constexpr
@@ -209,7 +229,21 @@ static
 ValidatedInt<IsInClosedInterval<0, mod_class - 1>>
 from_mod(ValidatedNonNegative i)
 {
-    return ValidatedObject<NativeInt, IsInClosedInterval<0, mod_class - 1>>(i.raw_unwrap() % mod_class);
+    // i is non-negative, so an unsigned modulo gives the same result, and is a mask when mod_class is a power of 2
+    return ValidatedObject<NativeInt, IsInClosedInterval<0, mod_class - 1>>(NativeInt(std::uint64_t(i.raw_unwrap()) % std::uint64_t(mod_class)));
+}
+
+// The bit field of `count` bits at `offset`, which is how a byte is read when byte_size is a power of 2
+template <size_t count>
+requires (count < 63)
+[[gnu::always_inline, gnu::flatten]]
+static
+ValidatedInt<IsInClosedInterval<0, (NativeInt(1) << count) - 1>>
+from_bits(ValidatedNonNegative i, size_t offset)
+{
+    return ValidatedObject<NativeInt, IsInClosedInterval<0, (NativeInt(1) << count) - 1>>(
+        NativeInt((std::uint64_t(i.raw_unwrap()) >> offset) & ((std::uint64_t(1) << count) - 1))
+    );
 }
 
 static
@@ -235,7 +269,7 @@ static
 ValidatedInt<IsInClosedInterval<low + other_low, high + other_high>>
 add(ValidatedInt<IsInClosedInterval<low, high>> lhs, ValidatedInt<IsInClosedInterval<other_low, other_high>> rhs)
 {
-    return ValidatedObject<NativeInt, IsInClosedInterval<low + other_low, high + other_high>>(lhs + rhs);
+    return ValidatedObject<NativeInt, IsInClosedInterval<low + other_low, high + other_high>>(lhs.raw_unwrap() + rhs.raw_unwrap());
 }
 
 template <NativeInt low, NativeInt high, NativeInt other_low, NativeInt other_high>
@@ -251,28 +285,28 @@ static
 ValidatedNonNegative
 add(ValidatedNonNegative lhs, ValidatedNonNegative rhs)
 {
-    return ValidatedObject<NativeInt, IsNonNegative>(lhs + rhs);
+    return ValidatedObject<NativeInt, IsNonNegative>(lhs.raw_unwrap() + rhs.raw_unwrap());
 }
 
 static
 ValidatedNonNegative
 multiply(ValidatedNonNegative lhs, ValidatedNonNegative rhs)
 {
-    return ValidatedObject<NativeInt, IsNonNegative>(lhs * rhs);
+    return ValidatedObject<NativeInt, IsNonNegative>(lhs.raw_unwrap() * rhs.raw_unwrap());
 }
 
 static
 ValidatedNonNegative
 divide(ValidatedNonNegative lhs, ValidatedNonNegative rhs)
 {
-    return ValidatedObject<NativeInt, IsNonNegative>(lhs / rhs);
+    return ValidatedObject<NativeInt, IsNonNegative>(lhs.raw_unwrap() / rhs.raw_unwrap());
 }
 
 static
 ValidatedNonNegative
 modulo(ValidatedNonNegative lhs, ValidatedPositive rhs)
 {
-    return ValidatedObject<NativeInt, IsNonNegative>(lhs % rhs);
+    return ValidatedObject<NativeInt, IsNonNegative>(lhs.raw_unwrap() % rhs.raw_unwrap());
 }
 
 template <typename Func1, typename Func2, typename StorageT, typename ValidatorT1, typename ValidatorT2, typename ConversionT, typename ChildT>
@@ -406,4 +440,5 @@ inline constexpr bool is_trivial_for_purposes_of_calls =
 
 static_assert(is_trivial_for_purposes_of_calls<ValidatedObject<std::string_view, CustomSizePredicate<std::string_view, IsExactValue<5>>>>);
 static_assert(is_trivial_for_purposes_of_calls<ValidatedWord>);
+MIX_END_BYTE_SIZE_NAMESPACE
 }
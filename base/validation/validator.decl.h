@@ -6,6 +6,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <NativeInt value>
 [[gnu::always_inline]]
@@ -120,4 +121,5 @@ bool
 custom_size_predicate(ContainerT const &container);
 
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
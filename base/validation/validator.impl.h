@@ -5,6 +5,7 @@
 #include <base/math.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <NativeInt value>
 constexpr
@@ -138,4 +139,5 @@ requires has_size_method<ContainerT>
 struct CustomSizePredicate : public ValidatorToFunctor<ContainerT, custom_size_predicate<ContainerT, ValidatorT>> {};
 
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
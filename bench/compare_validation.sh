@@ -0,0 +1,18 @@
+#!/bin/bash
+# Builds bench/interpreter.cpp with checked and with trusted validation, and runs both.
+# Usage: bench/compare_validation.sh [instruction budget]
+set -e
+script_dir=$(realpath "$(dirname "${BASH_SOURCE[0]}")")
+build_dir=$(mktemp -d)
+trap 'rm -rf "$build_dir"' EXIT
+
+for validation in checked trusted
+do
+    mkdir -p "$build_dir/$validation"
+    make -s -C "$script_dir/.." BUILD_DIR="$build_dir/$validation" CXXFLAGS="-std=c++20 -Werror -O2 -DNDEBUG" MIX_VALIDATION="$validation" benchmark
+done
+
+for validation in checked trusted
+do
+    "$build_dir/$validation/benchmark" "$@"
+done
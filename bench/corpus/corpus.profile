@@ -0,0 +1,72 @@
+100000 h_add_indexed_full h_dec1_direct
+100000 h_add_indexed_full h_dec1_direct h_dec2_direct
+100000 h_mul_direct_full h_slax_direct
+100000 h_mul_direct_full h_slax_direct h_add_indexed_full
+57960 h_div_direct_full h_jxz_direct
+95380 h_div_indexed_full h_jxz_direct
+100000 h_slax_direct h_add_indexed_full
+100000 h_slax_direct h_add_indexed_full h_dec1_direct
+52960 h_lda_direct_full h_sta_direct_full
+5000 h_lda_indexed_full h_mul_direct_full
+5000 h_lda_indexed_full h_mul_direct_full h_slax_direct
+10000 h_lda_indexed_full h_sta_direct_full
+2990 h_lda_indexed_full h_ent2_indexed
+2990 h_lda_indexed_full h_ent2_indexed h_cmpa_indexed_full
+1400 h_lda_indexed_full h_dec3_direct
+1400 h_lda_indexed_full h_dec3_direct h_j3p_direct
+10 h_ld1_direct_full h_lda_indexed_full
+10 h_ld1_direct_full h_lda_indexed_full h_ent2_indexed
+10 h_ld1_direct_full h_ent2_direct
+10 h_ld1_direct_full h_ent2_direct h_inc1_direct
+57960 h_ldx_direct_full h_div_direct_full
+57960 h_ldx_direct_full h_div_direct_full h_jxz_direct
+218960 h_ldx_indexed_full h_stx_indexed_full
+57960 h_enta_direct h_ldx_direct_full
+57960 h_enta_direct h_ldx_direct_full h_div_direct_full
+95380 h_enta_direct h_entx_indexed
+95380 h_enta_direct h_entx_indexed h_div_indexed_full
+4990 h_inc1_direct h_st2_indexed_full
+2990 h_inc1_direct h_j1np_direct
+5000 h_dec1_direct h_j1nn_direct
+100000 h_dec1_direct h_dec2_direct
+100000 h_dec1_direct h_dec2_direct h_j2nn_direct
+10 h_ent1_direct h_move_direct
+5 h_ent1_direct h_lda_indexed_full
+5 h_ent1_direct h_lda_indexed_full h_sta_direct_full
+200 h_ent1_direct h_jmp_direct
+5000 h_ent1_indexed h_ent2_direct
+5000 h_ent1_indexed h_ent2_direct h_lda_indexed_full
+17840 h_inc2_direct h_ent3_direct
+17840 h_inc2_direct h_ent3_direct h_enta_direct
+218960 h_dec2_direct h_j2p_direct
+100000 h_dec2_direct h_j2nn_direct
+5000 h_ent2_direct h_lda_indexed_full
+5000 h_ent2_direct h_lda_indexed_full h_mul_direct_full
+10 h_ent2_direct h_inc1_direct
+10 h_ent2_direct h_inc1_direct h_st2_indexed_full
+1400 h_ent2_indexed h_lda_indexed_full
+1400 h_ent2_indexed h_lda_indexed_full h_dec3_direct
+2990 h_ent2_indexed h_cmpa_indexed_full
+2990 h_ent2_indexed h_cmpa_indexed_full h_jge_direct
+82520 h_inc3_direct h_jg_direct
+200000 h_dec3_direct h_j3p_direct
+17840 h_ent3_direct h_enta_direct
+17840 h_ent3_direct h_enta_direct h_entx_indexed
+200 h_ent3_indexed h_jmp_direct
+325 h_dec4_direct h_j4p_direct
+1 h_ent4_direct h_ld1_direct_full
+1 h_ent4_direct h_ld1_direct_full h_ent2_direct
+3 h_ent4_direct h_ent1_direct
+1 h_ent4_direct h_ent1_direct h_move_direct
+1 h_ent4_direct h_ent1_direct h_lda_indexed_full
+1 h_ent4_direct h_ent1_direct h_jmp_direct
+1 h_ent4_direct h_ent5_direct
+1 h_ent4_direct h_ent5_direct h_ent1_indexed
+5000 h_dec5_direct h_j5nn_direct
+100 h_ent5_direct h_ent1_indexed
+100 h_ent5_direct h_ent1_indexed h_ent2_direct
+95380 h_entx_indexed h_div_indexed_full
+95380 h_entx_indexed h_div_indexed_full h_jxz_direct
+421680 h_cmpa_indexed_full h_jge_direct
+82520 h_cmpa_indexed_full h_inc3_direct
+82520 h_cmpa_indexed_full h_inc3_direct h_jg_direct
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+# Writes the MIX binaries of the superinstruction corpus, for a byte size of 64, into the current directory.
+# Each program is a textbook algorithm run a number of times over fixed pseudo-random data, and halts.
+# The loop of bench/interpreter.cpp is deliberately not one of them, so that the benchmark does not grade its own list.
+import random
+
+B = 64
+ORIGIN = 100
+
+# Op codes, with the field that selects the variant where there is one
+ADD, MUL, DIV, HLT, SLAX, MOVE = (1, 5), (3, 5), (4, 5), (5, 2), (6, 2), (7, None)
+LDA, LDX, STA, STX, STJ = (8, 5), (15, 5), (24, 5), (31, 5), (32, 2)
+JMP, JG, JGE = (39, 0), (39, 6), (39, 7)
+CMPA = (56, 5)
+
+
+def LD(i): return (8 + i, 5)
+def ST(i): return (24 + i, 5)
+def J(i, f): return (40 + i, f)          # f: 0 N, 1 Z, 2 P, 3 NN, 4 NZ, 5 NP; i 0 for rA, 7 for rX
+def INC(i): return (48 + i, 0)
+def DEC(i): return (48 + i, 1)
+def ENT(i): return (48 + i, 2)           # i 0 for rA, 7 for rX
+
+
+def num(v):
+    sign = 1 if v < 0 else 0
+    v = abs(v)
+    out = []
+    for _ in range(5):
+        out.append(v % B)
+        v //= B
+    return [sign] + out[::-1]
+
+
+def assemble(name, code, data):
+    # code: (label or None, op, address or label, index, field override)
+    labels = {label: ORIGIN + k for k, (label, *_) in enumerate(code) if label}
+    words = {}
+    for k, (_, (c, f), a, i, field) in enumerate(code):
+        a = labels.get(a, a)
+        sign = 1 if a < 0 else 0
+        a = abs(a)
+        words[ORIGIN + k] = [sign, a // B, a % B, i, field if field is not None else f, c]
+    for address, value in data.items():
+        words[address] = num(value)
+    size = max(words) + 1
+    header = [num(3), num(0), num(1), num(1), num(7), num(2), num(ORIGIN), num(0), num(ORIGIN), num(size - ORIGIN)]
+    image = header + [[0] * 6] * (ORIGIN - len(header))
+    image += [words.get(address, [0] * 6) for address in range(ORIGIN, size)]
+    with open(name, 'wb') as file:
+        file.write(b'MIX_MAGIC' + bytes(sum(image, [])))
+
+
+def op(o, a=0, i=0, f=None, label=None):
+    return (label, o, a, i, f)
+
+
+random.seed(1)
+
+# Algorithm M (TAOCP 1.3.2, Program M): the maximum of X[1..1000], found 200 times
+X = 2000
+assemble('max.mix', [
+    op(ENT(4), 200),
+    op(ENT(1), 1000, label='again'),
+    op(JMP, 'max'),
+    op(DEC(4), 1),
+    op(J(4, 2), 'again'),
+    op(HLT),
+    op(STJ, 'exit', label='max'),
+    op(ENT(3), 0, 1),
+    op(JMP, 'changem'),
+    op(CMPA, X, 3, label='loop'),
+    op(JGE, 'dec'),
+    op(ENT(2), 0, 3, label='changem'),
+    op(LDA, X, 3),
+    op(DEC(3), 1, label='dec'),
+    op(J(3, 2), 'loop'),
+    op(JMP, 0, label='exit'),
+], {X + 1 + k: random.randint(-10000, 10000) for k in range(1000)})
+
+# Program P (TAOCP 1.3.2): the first 500 primes, found 10 times, without printing them.
+# Negative start values are loaded from constants, as the book does, since ENT traps on a negative M here.
+L, PRIME, CONSTANT = 500, 1999, 1990
+assemble('primes.mix', [
+    op(ENT(4), 10),
+    op(LD(1), CONSTANT, label='start'),
+    op(ENT(2), 3),
+    op(INC(1), 1, label='p2'),
+    op(ST(2), PRIME + L, 1),
+    op(J(1, 1), 'done'),
+    op(INC(2), 2, label='p4'),
+    op(ENT(3), 2),
+    op(ENT(0), 0, label='p6'),
+    op(ENT(7), 0, 2),
+    op(DIV, PRIME, 3),
+    op(J(7, 1), 'p4'),
+    op(CMPA, PRIME, 3),
+    op(INC(3), 1),
+    op(JG, 'p6'),
+    op(JMP, 'p2'),
+    op(DEC(4), 1, label='done'),
+    op(J(4, 2), 'start'),
+    op(HLT),
+], {PRIME + 1: 2, CONSTANT: 1 - L})
+
+# Program S (TAOCP 5.2.1): straight insertion of 300 keys, copied in by MOVE and sorted 10 times
+N, INPUT, KEYS = 300, 2000, 3000
+assemble('sort.mix', [
+    op(ENT(4), 10),
+    op(ENT(1), INPUT + 1, label='start'),
+    *[op(MOVE, KEYS + 1 + 50 * k, f=50) for k in range(N // 50)],
+    op(LD(1), CONSTANT),
+    op(LDA, INPUT + N, 1, label='s2'),
+    op(ENT(2), N - 1, 1),
+    op(CMPA, INPUT, 2, label='s3'),
+    op(JGE, 's5'),
+    op(LDX, INPUT, 2),
+    op(STX, INPUT + 1, 2),
+    op(DEC(2), 1),
+    op(J(2, 2), 's3'),
+    op(STA, INPUT + 1, 2, label='s5'),
+    op(INC(1), 1),
+    op(J(1, 5), 's2'),
+    op(DEC(4), 1),
+    op(J(4, 2), 'start'),
+    op(HLT),
+], {CONSTANT: 2 - N, **{KEYS + 1 + k: random.randint(-100000, 100000) for k in range(N)}})
+
+# Algorithm E (TAOCP 1.1): the greatest common divisor of each of 1000 pairs, 5 times
+PAIRS, A, M, R = 1000, 2000, 1990, 1991
+assemble('gcd.mix', [
+    op(ENT(4), 5),
+    op(ENT(1), 2 * PAIRS - 2, label='start'),
+    op(LDA, A, 1, label='pair'),
+    op(STA, M),
+    op(LDA, A + 1, 1),
+    op(STA, R),
+    op(ENT(0), 0, label='e1'),
+    op(LDX, M),
+    op(DIV, R),
+    op(J(7, 1), 'next'),
+    op(LDA, R),
+    op(STA, M),
+    op(STX, R),
+    op(JMP, 'e1'),
+    op(DEC(1), 2, label='next'),
+    op(J(1, 3), 'pair'),
+    op(DEC(4), 1),
+    op(J(4, 2), 'start'),
+    op(HLT),
+], {A + k: random.randint(1, 1000000) for k in range(2 * PAIRS)})
+
+# Horner's rule: a polynomial of degree 20 at x = 2, for each of 50 coefficient vectors, 100 times
+DEGREE, POLYS, COEFFICIENTS, XVALUE = 20, 50, 2000, 1990
+assemble('horner.mix', [
+    op(ENT(4), 100),
+    op(ENT(5), (POLYS - 1) * (DEGREE + 1), label='start'),
+    op(ENT(1), DEGREE - 1, 5, label='poly'),
+    op(ENT(2), DEGREE - 1),
+    op(LDA, COEFFICIENTS + DEGREE, 5),
+    op(MUL, XVALUE, label='h'),
+    op(SLAX, 5),
+    op(ADD, COEFFICIENTS, 1),
+    op(DEC(1), 1),
+    op(DEC(2), 1),
+    op(J(2, 3), 'h'),
+    op(DEC(5), DEGREE + 1),
+    op(J(5, 3), 'poly'),
+    op(DEC(4), 1),
+    op(J(4, 2), 'start'),
+    op(HLT),
+], {XVALUE: 2, **{COEFFICIENTS + k: random.randint(0, 9) for k in range(POLYS * (DEGREE + 1))}})
+
+# The programs below are not part of the superinstruction corpus, but are run with it by bench/differential.sh.
+
+# Self-modifying code: a subroutine, entered by JMP and left through the JMP that its STJ patches,
+# stores rI4 into the address of a load further on in its own straight-line code before running it, 2000 times
+SUM = 3999
+assemble('selfmod.mix', [
+    op(ENT(4), 2000),
+    op(JMP, 'sub', label='again'),
+    op(DEC(4), 1),
+    op(J(4, 2), 'again'),
+    op(HLT),
+    op(STJ, 'exit', label='sub'),
+    op(ST(4), 'load', f=2),
+    op(LDA, 0, label='load'),
+    op(ADD, SUM),
+    op(STA, SUM),
+    op(JMP, 0, label='exit'),
+], {})
+
+# A trap: sums every word of memory with an indexed load, until the index takes the address past the end of memory
+assemble('trap.mix', [
+    op(ENT(1), 0),
+    op(LDA, 0, 1, label='loop'),
+    op(ADD, SUM),
+    op(STA, SUM),
+    op(INC(1), 1),
+    op(JMP, 'loop'),
+], {})
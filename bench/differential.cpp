@@ -0,0 +1,229 @@
+// Runs a MIX binary with each dispatch engine, translated ahead of time, restored from a snapshot, and on every lane
+// of a MachineBatch, and checks that every run ends in the same state as the jump table: the stop reason, trap,
+// instruction count, execution time, pc, registers, indicators and every word of memory.
+// Each engine also runs the binary again in short slices of its budget, which have to stop exactly where the jump table does.
+// Prints how fast each run went. Exits with 1 on a mismatch.
+//
+//     differential <binary> [budget]
+//
+// Compiled together with the output of mix_aot for the binary, which defines aot_program, see bench/differential.sh.
+#include <binary/reader.cpp>
+#include <vm/machine_batch.cpp>
+#include <vm/aot.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace mix;
+
+namespace
+{
+
+// Instructions in each slice of a sliced run, a prime so that slices end at every offset of a loop
+constexpr size_t slice_budget = 997;
+
+struct Outcome
+{
+    RunResult result;
+    MachineSnapshot state;
+};
+
+// The words of a segment, whose bytes read_binary has checked
+std::vector<std::array<Byte, bytes_in_word>> to_words(std::vector<RawWord> const &raw)
+{
+    std::vector<std::array<Byte, bytes_in_word>> words(raw.size());
+    for (size_t i = 0; i < raw.size(); i++)
+    {
+        words[i][0] = Sign(raw[i][0]);
+        for (size_t b = 1; b < bytes_in_word; b++)
+            words[i][b].byte = ValidatedByte::trusted_constructor(raw[i][b]).value();
+    }
+    return words;
+}
+
+// Loads every segment of the image through load_program, which leaves pc at the entry point
+template <class Target>
+void load_image(BinaryImage const &image, Target &target)
+{
+    for (BinarySegment const &segment : image.segments)
+        (void)target.load_program(ValidatedAddress::trusted_constructor(segment.origin).value(), to_words(segment.words),
+                                  ValidatedAddress::trusted_constructor(image.entry_point).value());
+}
+
+// Runs until the machine stops, or the budget runs out, in runs of at most slice instructions
+RunResult run_sliced(Machine &machine, size_t const budget, size_t const slice)
+{
+    RunResult total{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    while (total.instructions < budget)
+    {
+        RunResult const result = machine.run(std::min(slice, budget - total.instructions));
+        total.instructions += result.instructions;
+        total.cycles += result.cycles;
+        if (result.reason != StopReason::budget)
+        {
+            total.reason = result.reason;
+            total.trap = result.trap;
+            break;
+        }
+    }
+    return total;
+}
+
+Outcome run_machine(BinaryImage const &image, DispatchEngine const engine, size_t const budget, size_t const slice)
+{
+    Machine machine;
+    machine.set_dispatch_engine(engine);
+    load_image(image, machine);
+    RunResult const result = run_sliced(machine, budget, slice);
+    return {result, machine.snapshot()};
+}
+
+Outcome run_aot(size_t const budget, size_t const slice)
+{
+    Machine machine;
+    AotRuntime runtime(machine, aot_program);
+    if (!runtime.load())
+    {
+        std::fprintf(stderr, "the translated program does not load\n");
+        std::exit(EXIT_FAILURE);
+    }
+    RunResult const result = run_sliced(machine, budget, slice);
+    return {result, machine.snapshot()};
+}
+
+// Runs the program, restores the snapshot taken when it was loaded, and runs it again on the same machine,
+// so that only the cells written by the first run are copied back
+Outcome run_restored(BinaryImage const &image, size_t const budget, size_t const slice)
+{
+    Machine machine;
+    machine.set_dispatch_engine(DispatchEngine::threaded);
+    load_image(image, machine);
+    MachineSnapshot const loaded = machine.snapshot();
+    (void)run_sliced(machine, budget, slice);
+    machine.restore(loaded);
+    RunResult const result = run_sliced(machine, budget, slice);
+    return {result, machine.snapshot()};
+}
+
+// The batch runs every lane on the same input, and only in one run, since a lane that stops sits out the rest of it
+std::vector<Outcome> run_batch(BinaryImage const &image, size_t const budget)
+{
+    auto const batch = std::make_unique<MachineBatch>();
+    load_image(image, *batch);
+    std::array<RunResult, batch_lanes> const results = batch->run(budget);
+    std::vector<Outcome> outcomes;
+    for (size_t lane = 0; lane < batch_lanes; lane++)
+        outcomes.push_back({results[lane], batch->snapshot(lane)});
+    return outcomes;
+}
+
+int sign_of(std::strong_ordering const comparison)
+{
+    return comparison < 0 ? -1 : comparison > 0 ? 1 : 0;
+}
+
+// Prints every difference of outcome from expected, and returns whether there are none
+bool matches(char const *name, Outcome const &expected, Outcome const &outcome)
+{
+    bool same = true;
+    auto const check = [&](char const *what, auto const expected_value, auto const value) {
+        if (expected_value == value)
+            return;
+        std::printf("%s: %s is %lld instead of %lld\n", name, what, static_cast<long long>(value), static_cast<long long>(expected_value));
+        same = false;
+    };
+    RunResult const &a = expected.result;
+    RunResult const &b = outcome.result;
+    check("stop reason", int(a.reason), int(b.reason));
+    if (a.reason == StopReason::trap)
+    {
+        check("trap code", int(a.trap.code), int(b.trap.code));
+        check("trap pc", a.trap.pc, b.trap.pc);
+    }
+    check("instruction count", a.instructions, b.instructions);
+    check("execution time", a.cycles, b.cycles);
+
+    MachineSnapshot const &s = expected.state;
+    MachineSnapshot const &t = outcome.state;
+    check("pc", s.pc, t.pc);
+    check("rA", s.rA.packed_word(), t.rA.packed_word());
+    for (size_t i = 0; i < s.index_registers.size(); i++)
+        check(("rI" + std::to_string(i + 1)).c_str(), s.index_registers[i].packed_word(), t.index_registers[i].packed_word());
+    check("rX", s.rX.packed_word(), t.rX.packed_word());
+    check("rJ", s.rJ.packed_word(), t.rJ.packed_word());
+    check("overflow", s.overflow, t.overflow);
+    check("comparison", sign_of(s.comparison), sign_of(t.comparison));
+    check("pending I/O", s.pending_io.has_value(), t.pending_io.has_value());
+    for (NativeByte address = 0; address < main_memory_size; address++)
+    {
+        ValidatedAddress const cell = ValidatedAddress::trusted_constructor(address).value();
+        check(("memory cell " + std::to_string(address)).c_str(), s.memory.load(cell), t.memory.load(cell));
+    }
+    return same;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <binary> [budget]\n", argv[0]);
+        return 2;
+    }
+    size_t const budget = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100'000'000;
+    std::ifstream input(argv[1], std::ios::binary);
+    std::vector<std::uint8_t> const bytes{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    Result<BinaryImage, Error> const image = read_binary(bytes);
+    if (!image)
+    {
+        std::fprintf(stderr, "%s: %s is not a valid MIX binary for a byte size of %zu\n", argv[0], argv[1], size_t(byte_size));
+        return 2;
+    }
+
+    std::pair<char const *, DispatchEngine> const engines[] = {
+        {"jump table", DispatchEngine::jump_table},
+        {"threaded", DispatchEngine::threaded},
+        {"jit", DispatchEngine::jit},
+        {"tiered", DispatchEngine::tiered},
+    };
+    std::vector<std::pair<std::string, std::function<Outcome(size_t)>>> runs;
+    for (auto const &[name, engine] : engines)
+        runs.emplace_back(name, [&, engine](size_t slice) { return run_machine(image.value(), engine, budget, slice); });
+    runs.emplace_back("aot", [&](size_t slice) { return run_aot(budget, slice); });
+    runs.emplace_back("restored", [&](size_t slice) { return run_restored(image.value(), budget, slice); });
+
+    Outcome const expected = run_machine(image.value(), DispatchEngine::jump_table, budget, budget);
+    std::printf("%s: %zu instructions\n", argv[1], expected.result.instructions);
+    bool same = true;
+    for (auto const &[name, run] : runs)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        Outcome const outcome = run(budget);
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        same &= matches(name.c_str(), expected, outcome);
+        same &= matches((name + " in slices").c_str(), expected, run(slice_budget));
+        std::printf("%-10s %.1f million instructions/s\n", name.c_str(), outcome.result.instructions / elapsed.count() / 1e6);
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<Outcome> const lanes = run_batch(image.value(), budget);
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    size_t instructions = 0;
+    for (size_t lane = 0; lane < lanes.size(); lane++)
+    {
+        same &= matches(("batch lane " + std::to_string(lane)).c_str(), expected, lanes[lane]);
+        instructions += lanes[lane].result.instructions;
+    }
+    std::printf("%-10s %.1f million instructions/s over %zu lanes\n", "batch", instructions / elapsed.count() / 1e6, lanes.size());
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
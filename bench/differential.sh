@@ -0,0 +1,31 @@
+#!/bin/bash
+# Translates every binary of bench/corpus with mix_aot, and runs it through bench/differential.cpp,
+# which fails if any engine, the translation, a restored snapshot or a lane of a batch ends in another state than the jump table.
+# Usage: bench/differential.sh [compiler flags...], e.g. -DMIX_PACKED_MEMORY=1
+set -e
+script_dir=$(realpath "$(dirname "${BASH_SOURCE[0]}")")
+build_dir=$(mktemp -d)
+trap 'rm -rf "$build_dir"' EXIT
+
+flags=(-std=c++20 -Werror -O2 -DNDEBUG -I"$script_dir/.." "$@")
+make -s -C "$script_dir/.." BUILD_DIR="$build_dir" CXXFLAGS="${flags[*]}" mix_aot
+
+pids=()
+for binary in "$script_dir"/corpus/*.mix
+do
+    name=$(basename "$binary" .mix)
+    "$build_dir/mix_aot" "$binary" "$build_dir/$name.cpp"
+    g++ "${flags[@]}" -o "$build_dir/$name" "$script_dir/differential.cpp" "$build_dir/$name.cpp" &
+    pids+=($!)
+done
+for pid in "${pids[@]}"
+do
+    wait "$pid"
+done
+
+status=0
+for binary in "$script_dir"/corpus/*.mix
+do
+    "$build_dir/$(basename "$binary" .mix)" "$binary" || status=1
+done
+exit "$status"
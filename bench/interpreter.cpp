@@ -0,0 +1,103 @@
+// Measures how fast the simulator runs a small loop of loads, arithmetic, stores, comparisons and jumps,
+// with each dispatch engine, and on every lane of a MachineBatch at once. See bench/compare_validation.sh for comparing checked and trusted builds.
+#include <vm/instruction.cpp>
+#include <vm/register.cpp>
+#include <vm/machine.cpp>
+#include <vm/code_cache.cpp>
+#include <vm/jit.cpp>
+#include <vm/aot.cpp>
+#include <vm/machine_batch.cpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+
+using namespace mix;
+
+namespace
+{
+
+std::array<Byte, bytes_in_word> make_word(Sign sign, std::array<NativeByte, numerical_bytes_in_word> bytes)
+{
+    std::array<Byte, bytes_in_word> word;
+    word[0] = sign;
+    for (size_t i = 1; i < bytes_in_word; i++)
+        word[i] = ValidatedByte::constructor(bytes[i - 1]).value();
+    return word;
+}
+
+std::array<Byte, bytes_in_word> make_instruction(NativeByte A, NativeByte I, NativeByte F, NativeByte C)
+{
+    return make_word(s_plus, {NativeByte(A / byte_size), NativeByte(A % byte_size), I, F, C});
+}
+
+ValidatedAddress address(NativeByte a)
+{
+    return ValidatedAddress::constructor(a).value();
+}
+
+std::array<Byte, bytes_in_word> const program[] = {
+        make_instruction(1000, 0, 2, op_ent1),       // 0: ENT1 1000
+        make_instruction(3000, 0, 13, op_lda),       // 1: LDA 3000(1:5)
+        make_instruction(3001, 0, 5, op_add),        // 2: ADD 3001
+        make_instruction(3002, 0, 5, op_sta),        // 3: STA 3002
+        make_instruction(2000, 1, 3, op_cmpa),       // 4: CMPA 2000,1(0:3)
+        make_instruction(1, 0, 1, op_dec1),          // 5: DEC1 1
+        make_instruction(1, 0, 2, op_j1p),           // 6: J1P 1
+        make_instruction(0, 0, 0, op_jmp),           // 7: JMP 0
+};
+
+RunResult run(DispatchEngine engine, size_t budget)
+{
+    Machine machine;
+    machine.set_dispatch_engine(engine);
+    machine.load_word(address(3000), make_word(s_plus, {0, 1, 2, 3, 4}));
+    machine.load_word(address(3001), make_word(s_minus, {0, 0, 0, 0, 1}));
+    (void)machine.load_program(address(0), program, address(0));
+    return machine.run(budget);
+}
+
+// The loop on every lane for budget instructions in all, with different data in each lane
+RunResult run_batch(size_t budget)
+{
+    auto const batch = std::make_unique<MachineBatch>();
+    (void)batch->load_program(address(0), program, address(0));
+    for (size_t lane = 0; lane < batch_lanes; lane++)
+    {
+        batch->load_word(lane, address(3000), make_word(s_plus, {0, 1, 2, 3, NativeByte(4 + lane)}));
+        batch->load_word(lane, address(3001), make_word(s_minus, {0, 0, 0, 0, NativeByte(1 + lane)}));
+    }
+    RunResult total{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    for (RunResult const &result : batch->run(budget / batch_lanes))
+    {
+        if (result.reason != StopReason::budget)
+            total.reason = result.reason;
+        total.instructions += result.instructions;
+        total.cycles += result.cycles;
+    }
+    return total;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    size_t const budget = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+
+    std::printf("byte size %zu, %s validation, %zu batch lanes\n", byte_size, trusted_validation ? "trusted" : "checked", batch_lanes);
+    for (auto const [engine, name] : {std::pair{std::optional(DispatchEngine::jump_table), "jump table"}, std::pair{std::optional(DispatchEngine::threaded), "threaded"}, std::pair{std::optional(DispatchEngine::jit), "jit"}, std::pair{std::optional(DispatchEngine::tiered), "tiered"}, std::pair{std::optional<DispatchEngine>(), "batch"}})
+    {
+        auto const start = std::chrono::steady_clock::now();
+        RunResult const result = engine ? run(*engine, budget) : run_batch(budget);
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+        if (result.reason != StopReason::budget)
+        {
+            std::printf("%s: stopped early\n", name);
+            return EXIT_FAILURE;
+        }
+        std::printf("%-10s %12zu instructions in %.3f s, %.1f million instructions/s\n", name, result.instructions, elapsed.count(), result.instructions / elapsed.count() / 1e6);
+    }
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include <variant>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <bool is_peek, typename T>
 __attribute__((always_inline))
@@ -616,4 +617,5 @@ Assembler::assemble()
         ;
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -13,6 +13,7 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 struct Cursor
 {
@@ -319,4 +320,5 @@ public:
     assemble();
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
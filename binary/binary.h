@@ -1,6 +1,9 @@
 #pragma once
 #include <base/base.h>
 #include <stdexcept>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 struct BinaryMagic 
 {
@@ -62,4 +65,7 @@ struct Binary
     Header header;
     ProgramHeader program_header;
     NativeByte padding[main_memory_size];
-};
\ No newline at end of file
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,114 @@
+#include <base/base.h>
+#include <binary/binary.h>
+#include <binary/reader.h>
+
+#include <bitset>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+// The binary after its magic, as words
+class BinaryWords
+{
+    std::span<std::uint8_t const> bytes;
+
+public:
+    explicit BinaryWords(std::span<std::uint8_t const> bytes)
+        : bytes(bytes)
+    {}
+
+    size_t size() const
+    {
+        return bytes.size() / bytes_in_word;
+    }
+
+    RawWord operator[](size_t index) const
+    {
+        RawWord word;
+        for (size_t i = 0; i < bytes_in_word; i++)
+            word[i] = bytes[index * bytes_in_word + i];
+        return word;
+    }
+
+    // Reads the word at index as an UnsignedInteger
+    Result<NativeByte, Error> unsigned_integer(size_t index) const
+    {
+        if (index >= size())
+            return Result<NativeByte, Error>::failure(err_invalid_input);
+        RawWord const word = (*this)[index];
+        if (word[0] != s_plus)
+            return Result<NativeByte, Error>::failure(err_invalid_input);
+        NativeInt value = 0;
+        for (size_t i = 1; i < bytes_in_word; i++)
+        {
+            if (word[i] >= byte_size)
+                return Result<NativeByte, Error>::failure(err_invalid_input);
+            value = value * byte_size + word[i];
+        }
+        if (value >= NativeInt(main_memory_size))
+            return Result<NativeByte, Error>::failure(err_invalid_input);
+        return Result<NativeByte, Error>::success(NativeByte(value));
+    }
+};
+
+}
+
+Result<BinaryImage, Error> read_binary(std::span<std::uint8_t const> bytes)
+{
+    using ResultType = Result<BinaryImage, Error>;
+    constexpr std::string_view magic = "MIX_MAGIC";
+    if (bytes.size() < magic.size() || !std::equal(magic.begin(), magic.end(), bytes.begin()))
+        return ResultType::failure(err_invalid_input);
+    BinaryWords const words(bytes.subspan(magic.size()));
+
+    // The Header table starts with its number of records, each of which is a type and a value
+    Result<NativeByte, Error> const header_size = words.unsigned_integer(0);
+    if (!header_size)
+        return ResultType::failure(header_size.error());
+    std::array<std::optional<NativeByte>, hr_max> header;
+    for (NativeByte i = 0; i < header_size.value(); i++)
+    {
+        Result<NativeByte, Error> const type = words.unsigned_integer(1 + 2 * i);
+        Result<NativeByte, Error> const value = words.unsigned_integer(2 + 2 * i);
+        if (!type || !value || type.value() >= hr_max || header[type.value()])
+            return ResultType::failure(err_invalid_input);
+        header[type.value()] = value.value();
+    }
+    if (!header[hr_program_header_size] || !header[hr_program_header_offset] || !header[hr_entry_point])
+        return ResultType::failure(err_invalid_input);
+
+    // Each ProgramHeader record is a type, an offset and a size
+    BinaryImage image{.segments = {}, .entry_point = *header[hr_entry_point]};
+    std::bitset<main_memory_size> loaded;
+    for (NativeByte i = 0; i < *header[hr_program_header_size]; i++)
+    {
+        size_t const record = *header[hr_program_header_offset] + 3 * i;
+        Result<NativeByte, Error> const type = words.unsigned_integer(record);
+        Result<NativeByte, Error> const offset = words.unsigned_integer(record + 1);
+        Result<NativeByte, Error> const size = words.unsigned_integer(record + 2);
+        if (!type || !offset || !size || type.value() != phr_load)
+            return ResultType::failure(err_invalid_input);
+        if (offset.value() + size.value() > std::min(words.size(), main_memory_size))
+            return ResultType::failure(err_invalid_input);
+        BinarySegment segment{.origin = offset.value(), .words = {}};
+        for (NativeByte address = offset.value(); address < offset.value() + size.value(); address++)
+        {
+            RawWord const word = words[address];
+            if (loaded[address] || (word[0] != s_plus && word[0] != s_minus))
+                return ResultType::failure(err_invalid_input);
+            for (size_t b = 1; b < bytes_in_word; b++)
+                if (word[b] >= byte_size)
+                    return ResultType::failure(err_invalid_input);
+            loaded.set(address);
+            segment.words.push_back(word);
+        }
+        image.segments.push_back(std::move(segment));
+    }
+    return ResultType::success(std::move(image));
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
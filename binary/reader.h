@@ -0,0 +1,34 @@
+#pragma once
+#include <base/base.h>
+#include <base/error.h>
+#include <vm/engine.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// A load segment of a MIX binary.
+// A binary is laid out as the memory image that it loads, so a segment is loaded at the address equal to its offset.
+struct BinarySegment
+{
+    NativeByte origin;
+    std::vector<RawWord> words;
+};
+
+// What a MIX binary loads into memory (see README.md)
+struct BinaryImage
+{
+    std::vector<BinarySegment> segments;
+    NativeByte entry_point;
+};
+
+// Reads a MIX binary, given as its bytes.
+// Fails with err_invalid_input on a bad magic, a missing header record, a pointer out of the binary,
+// a segment that overlaps another one, or a byte that does not fit in a MIX byte.
+Result<BinaryImage, Error> read_binary(std::span<std::uint8_t const> bytes);
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -223,7 +223,7 @@ endef
 
 define make_executable_targets
 $(call prepend_build_dir,$($(TARGET)_BINARY)):
-	$(CXX) -o $$@ $(FLAGS) $(LDFLAGS) $(EXECUTABLE_LDFLAGS) $($(TARGET)_OBJECTS) $(foreach DEP,$($(TARGET)_DEPS),$($(DEP)_BINARY))
+	$(CXX) -o $$@ $(FLAGS) $(LDFLAGS) $(EXECUTABLE_LDFLAGS) $(call prepend_build_dir,$($(TARGET)_OBJECTS)) $(foreach DEP,$($(TARGET)_DEPS),$($(DEP)_BINARY))
 
 endef
 
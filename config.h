@@ -4,4 +4,28 @@
 #   define MIX_BYTE_SIZE 64
 #endif
 
+// Set to 1 (make MIX_PACKED_MEMORY=1) to store each word of main memory as one packed 64-bit integer instead of as 6 MIX bytes
+#ifndef MIX_PACKED_MEMORY
+#   define MIX_PACKED_MEMORY 0
+#endif
+
+// Set to 1 (make MIX_VALIDATION=trusted) to assume, instead of checking at runtime and aborting on one that is not,
+// that values the simulator has already proven valid are valid.
+// The validated types and their compile time checks are unaffected.
+#ifndef MIX_TRUSTED_VALIDATION
+#   define MIX_TRUSTED_VALIDATION 0
+#endif
+
+// Set to the number of machines that a MachineBatch runs side by side (make MIX_BATCH_LANES=4), a power of 2,
+// or leave at 0 for as many words as a vector of the target holds (see vm/machine_batch.defn.h)
+#ifndef MIX_BATCH_LANES
+#   define MIX_BATCH_LANES 0
+#endif
+
+// Set to 0 (make MIX_BATCH_VECTORS=0) to run the lanes of a MachineBatch in turn on one Machine
+// even where the target has vectors that they would run as (see vm/machine_batch.defn.h)
+#ifndef MIX_BATCH_VECTORS
+#   define MIX_BATCH_VECTORS 1
+#endif
+
 #include <config.impl.h>
@@ -7,4 +7,30 @@
 // The actual configured size of a MIX byte
 constexpr size_t byte_size = MIX_BYTE_SIZE;
 
-#undef MIX_BYTE_SIZE
+// Whatever depends on byte_size is declared in an inline namespace named after it, e.g. mix::byte_size_64,
+// so that simulators built for different byte sizes can be linked into one program (see vm/engine.h).
+// MIX_BYTE_SIZE is therefore kept defined.
+#define MIX_BYTE_SIZE_NAMESPACE_IMPL(size) byte_size_##size
+#define MIX_BYTE_SIZE_NAMESPACE(size) MIX_BYTE_SIZE_NAMESPACE_IMPL(size)
+#define MIX_BEGIN_BYTE_SIZE_NAMESPACE inline namespace MIX_BYTE_SIZE_NAMESPACE(MIX_BYTE_SIZE) {
+#define MIX_END_BYTE_SIZE_NAMESPACE }
+
+// Whether main memory is stored as packed words
+constexpr bool packed_memory = MIX_PACKED_MEMORY;
+
+#undef MIX_PACKED_MEMORY
+
+// Whether ValidatedObject::trusted_constructor assumes its argument to be valid
+constexpr bool trusted_validation = MIX_TRUSTED_VALIDATION;
+
+#undef MIX_TRUSTED_VALIDATION
+
+// The lanes of a MachineBatch, or 0 to leave them to the target
+constexpr size_t configured_batch_lanes = MIX_BATCH_LANES;
+
+#undef MIX_BATCH_LANES
+
+// Whether a MachineBatch runs its lanes as vectors where the target has AVX2 or AVX-512
+constexpr bool configured_batch_vectors = MIX_BATCH_VECTORS;
+
+#undef MIX_BATCH_VECTORS
@@ -20,6 +20,8 @@ local num_threads=
 local config_cflags=
 config_cxxflags=
 config_ldflags=
+local config_validation=
+local config_packed_memory=
 while test $# -gt 0
 do
     local shift_by
@@ -44,6 +46,15 @@ do
         config_ldflags=$2
         : $((shift_by++))
         ;;
+    --validation)
+        # checked or trusted, see config.h
+        config_validation=$2
+        : $((shift_by++))
+        ;;
+    --packed-memory)
+        # see config.h
+        config_packed_memory=1
+        ;;
     --)
         shift
         break
@@ -79,6 +90,16 @@ then
     make_args+=(LDFLAGS="$config_ldflags")
 fi
 
+if test -n "$config_validation"
+then
+    make_args+=(MIX_VALIDATION="$config_validation")
+fi
+
+if test -n "$config_packed_memory"
+then
+    make_args+=(MIX_PACKED_MEMORY="$config_packed_memory")
+fi
+
 set -x
 
 echo "Configuring in $script_invocation_dir"
@@ -0,0 +1,300 @@
+// Translates a MIX binary ahead of time to a C++ translation unit with one function per basic block (see vm/aot.h).
+//
+//     mix_aot [--main] <binary> <output.cpp>
+//
+// The output is compiled with the same MIX_BYTE_SIZE as mix_aot, and defines mix::aot_program (see vm/aot.h).
+// With --main it also defines a main function that runs the program, see mix::aot_main.
+//
+// Control flow is recovered from the entry point by following fall-through and jumps with I = 0.
+// The instruction after every jump starts a block too, since it is where a subroutine called with JMP returns to through rJ.
+// Jumps that are indexed, or that land on an address that no block starts at, go through the runtime's dispatch table.
+// Cells that an unindexed store writes into are never translated, so self-modifying code such as a subroutine's exit
+// (STJ into the address of its own return jump) runs in the interpreter.
+#include <binary/reader.cpp>
+#include <vm/instruction.cpp>
+#include <vm/register.cpp>
+#include <vm/machine.cpp>
+#include <vm/code_cache.cpp>
+#include <vm/jit.cpp>
+#include <vm/aot.cpp>
+
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+using namespace mix;
+
+namespace
+{
+
+// Longest block, in instructions
+constexpr NativeByte max_block_length = 256;
+
+// An instruction word split into the parts that control flow recovery looks at
+struct Word
+{
+    RawWord raw;
+    OpHandler handler;
+    NativeByte I;
+    // M for I = 0, if it is an address
+    std::optional<NativeByte> direct_M;
+
+    explicit Word(RawWord const &raw)
+        : raw(raw)
+        // As the runtime decodes it, since the decoded word is what the translated block runs
+        , handler(AotRuntime::decode(raw).handler)
+        , I(raw[3])
+    {
+        NativeInt const A = NativeInt(raw[1]) * byte_size + raw[2];
+        if (I == 0 && raw[0] == s_plus && A < NativeInt(main_memory_size))
+            direct_M = NativeByte(A);
+    }
+
+    NativeByte C() const
+    {
+        return raw[5];
+    }
+
+    // Jumps, HLT and I/O end a block: they are where the machine may go somewhere other than the next cell, or stop
+    bool ends_block() const
+    {
+        return (C() >= op_jbus && C() <= op_jxn) || handler == h_hlt;
+    }
+
+    // HLT does not: a halted machine only goes on if it is started again, and the cell after it is usually data
+    bool may_fall_through() const
+    {
+        return handler != h_hlt && handler != h_jmp_direct && handler != h_jmp_indexed && handler != h_jsj_direct && handler != h_jsj_indexed;
+    }
+
+    // The cell that the instruction jumps to, if it is known ahead of time
+    std::optional<NativeByte> jump_target() const
+    {
+        bool const jumps = (C() >= op_jmp && C() <= op_jxn) || C() == op_jbus || C() == op_jred;
+        return jumps ? direct_M : std::nullopt;
+    }
+
+    // The cell that the instruction stores into, if it is known ahead of time
+    std::optional<NativeByte> store_target() const
+    {
+        return C() >= op_sta && C() <= op_stz ? direct_M : std::nullopt;
+    }
+};
+
+struct Block
+{
+    NativeByte start;
+    NativeByte length;
+};
+
+class Translator
+{
+    BinaryImage const &image;
+
+    std::array<std::optional<Word>, main_memory_size> words;
+
+    std::bitset<main_memory_size> reachable;
+    std::bitset<main_memory_size> leaders;
+    std::bitset<main_memory_size> stored_into;
+
+    std::vector<Block> blocks;
+
+    bool translatable(NativeByte address) const
+    {
+        return reachable[address] && !stored_into[address] && words[address]->handler != h_invalid;
+    }
+
+    void recover_control_flow()
+    {
+        std::vector<NativeByte> worklist;
+        leaders.set(image.entry_point);
+        auto const reach = [&](NativeByte address) {
+            if (address < main_memory_size && words[address] && !reachable[address])
+            {
+                reachable.set(address);
+                worklist.push_back(address);
+            }
+        };
+        reach(image.entry_point);
+        while (!worklist.empty())
+        {
+            NativeByte const address = worklist.back();
+            worklist.pop_back();
+            Word const &word = *words[address];
+            if (word.handler == h_invalid)
+                continue;
+            if (std::optional<NativeByte> const store = word.store_target())
+                stored_into.set(*store);
+            if (std::optional<NativeByte> const target = word.jump_target())
+            {
+                leaders.set(*target);
+                reach(*target);
+            }
+            if (word.ends_block() && address + 1 < main_memory_size)
+                leaders.set(address + 1);
+            // The cell after an unconditional jump is reached by returning from the jump, unless it is a JSJ
+            if (word.may_fall_through() || word.handler == h_jmp_direct || word.handler == h_jmp_indexed)
+                reach(NativeByte(address + 1));
+        }
+    }
+
+    void form_blocks()
+    {
+        for (NativeByte start = 0; start < main_memory_size; start++)
+        {
+            // A block also starts after a cell that is left to the interpreter
+            bool const starts = leaders[start] || (start > 0 && !translatable(start - 1));
+            if (!starts || !translatable(start))
+                continue;
+            NativeByte length = 0;
+            while (length < max_block_length && start + length < main_memory_size && translatable(start + length)
+                   && (length == 0 || !leaders[start + length]))
+            {
+                length++;
+                if (words[start + length - 1]->ends_block())
+                    break;
+            }
+            blocks.push_back({start, length});
+            // Resume after the block, which then starts the next one
+            leaders.set(start + length < main_memory_size ? start + length : start);
+            start += length - 1;
+        }
+    }
+
+    static void print_raw(std::FILE *out, RawWord const &raw)
+    {
+        std::fprintf(out, "{%u, %u, %u, %u, %u, %u}",
+                     unsigned(raw[0]), unsigned(raw[1]), unsigned(raw[2]), unsigned(raw[3]), unsigned(raw[4]), unsigned(raw[5]));
+    }
+
+    // As a constant, so that the runtime can specialise the instruction on each of its parts
+    void print_decoded(std::FILE *out, NativeByte address) const
+    {
+        DecodedInstruction const decoded = AotRuntime::decode(words[address]->raw);
+        std::string_view const handler = handler_names[decoded.handler];
+        std::fprintf(out, "constexpr DecodedInstruction decoded_%u{%.*s, %u, %u, %d, %u, %u, %u};\n", unsigned(address),
+                     int(handler.size()), handler.data(), unsigned(decoded.cycles), unsigned(decoded.instructions),
+                     int(decoded.raw_A), unsigned(decoded.raw_I), unsigned(decoded.raw_F), unsigned(decoded.raw_sign));
+    }
+
+public:
+    explicit Translator(BinaryImage const &image)
+        : image(image)
+    {
+        for (BinarySegment const &segment : image.segments)
+            for (size_t i = 0; i < segment.words.size(); i++)
+                words[segment.origin + i].emplace(segment.words[i]);
+        recover_control_flow();
+        form_blocks();
+    }
+
+    void emit(std::FILE *out, char const *source, bool with_main) const
+    {
+        std::fprintf(out, "// Translated from %s by mix_aot. Do not edit.\n", source);
+        std::fprintf(out, "#include <vm/instruction.cpp>\n#include <vm/register.cpp>\n#include <vm/machine.cpp>\n#include <vm/code_cache.cpp>\n#include <vm/jit.cpp>\n#include <vm/aot.cpp>\n\n");
+        std::fprintf(out, "static_assert(MIX_BYTE_SIZE == %zu, \"compile with the MIX_BYTE_SIZE that the binary was translated for\");\n\n", size_t(byte_size));
+        std::fprintf(out, "namespace\n{\n\nusing namespace mix;\n\n");
+
+        for (size_t s = 0; s < image.segments.size(); s++)
+        {
+            BinarySegment const &segment = image.segments[s];
+            std::fprintf(out, "constexpr RawWord segment_%zu[] = {\n", s);
+            for (RawWord const &raw : segment.words)
+            {
+                std::fprintf(out, "    ");
+                print_raw(out, raw);
+                std::fprintf(out, ",\n");
+            }
+            std::fprintf(out, "};\n\n");
+        }
+        std::fprintf(out, "constexpr AotSegment segments[] = {\n");
+        for (size_t s = 0; s < image.segments.size(); s++)
+            std::fprintf(out, "    {%u, segment_%zu},\n", unsigned(image.segments[s].origin), s);
+        std::fprintf(out, "};\n\n");
+
+        // Leaves the block with the status of its instruction at index k, unless the block carries on
+        std::fprintf(out, "#define MIX_AOT_STEP(k, address) \\\n"
+                          "    switch (runtime.execute<address, decoded_##address>()) \\\n"
+                          "    { \\\n"
+                          "    case JitStatus::trap: \\\n"
+                          "        return {JitStatus::trap, k}; \\\n"
+                          "    case JitStatus::leave: \\\n"
+                          "        return {JitStatus::leave, k + 1}; \\\n"
+                          "    case JitStatus::next: \\\n"
+                          "        break; \\\n"
+                          "    }\n\n");
+
+        for (Block const &block : blocks)
+        {
+            for (NativeByte address = block.start; address < block.start + block.length; address++)
+                print_decoded(out, address);
+            std::fprintf(out, "\nAotExit block_%u(AotRuntime &runtime)\n{\n", unsigned(block.start));
+            for (NativeByte k = 0; k < block.length; k++)
+            {
+                NativeByte const address = block.start + k;
+                std::fprintf(out, "    MIX_AOT_STEP(%u, %u)\n", unsigned(k), unsigned(address));
+            }
+            std::fprintf(out, "    return {JitStatus::next, %u};\n}\n\n", unsigned(block.length));
+        }
+        std::fprintf(out, "#undef MIX_AOT_STEP\n\n");
+
+        std::fprintf(out, "constexpr AotBlock blocks[] = {\n");
+        for (Block const &block : blocks)
+            std::fprintf(out, "    {%u, %u, block_%u},\n", unsigned(block.start), unsigned(block.length), unsigned(block.start));
+        std::fprintf(out, "};\n\n}\n\n");
+
+        std::fprintf(out, "mix::AotProgram const mix::aot_program{segments, %u, blocks};\n", unsigned(image.entry_point));
+        if (with_main)
+            std::fprintf(out, "\nint main(int argc, char **argv)\n{\n    return mix::aot_main(mix::aot_program, argc, argv);\n}\n");
+    }
+
+    size_t block_count() const
+    {
+        return blocks.size();
+    }
+};
+
+}
+
+int main(int argc, char **argv)
+{
+    bool const with_main = argc == 4 && std::strcmp(argv[1], "--main") == 0;
+    if (argc != 3 && !with_main)
+    {
+        std::fprintf(stderr, "usage: %s [--main] <binary> <output.cpp>\n", argv[0]);
+        return 2;
+    }
+    char const *const input_path = argv[argc - 2];
+    char const *const output_path = argv[argc - 1];
+
+    std::ifstream input(input_path, std::ios::binary);
+    if (!input)
+    {
+        std::fprintf(stderr, "%s: cannot open %s\n", argv[0], input_path);
+        return 1;
+    }
+    std::vector<std::uint8_t> const bytes{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    Result<BinaryImage, Error> const image = read_binary(bytes);
+    if (!image)
+    {
+        std::fprintf(stderr, "%s: %s is not a valid MIX binary for a byte size of %zu\n", argv[0], input_path, size_t(byte_size));
+        return 1;
+    }
+
+    Translator const translator(image.value());
+    std::FILE *const output = std::fopen(output_path, "w");
+    if (output == nullptr)
+    {
+        std::fprintf(stderr, "%s: cannot write %s\n", argv[0], output_path);
+        return 1;
+    }
+    translator.emit(output, input_path, with_main);
+    std::fclose(output);
+    std::printf("%zu blocks\n", translator.block_count());
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Generates the superinstructions of the simulator from profiled runs (see vm/superinstruction.h).
+//
+//     mix_superinstructions profile <profile> <binary>...
+//         Runs each MIX binary from its entry point until it stops, and adds the handler sequences that it executes to the
+//         profile, which is created if need be. Run it over a corpus of the programs that the simulator should be fast on.
+//     mix_superinstructions generate <count> <output.h> <profile>...
+//         Writes the count sequences that save the most dispatches across the profiles, as vm/superinstruction_list.h.
+//
+// The simulator has to be rebuilt for a new list to take effect.
+#include <binary/reader.cpp>
+#include <vm/instruction.cpp>
+#include <vm/register.cpp>
+#include <vm/machine.cpp>
+#include <vm/code_cache.cpp>
+#include <vm/jit.cpp>
+#include <vm/aot.cpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace mix;
+
+namespace
+{
+
+// Instructions that a profiled program may run before it is stopped
+constexpr size_t profile_budget = 100'000'000;
+
+Result<void> read_profile(char const *path, SequenceProfile &profile)
+{
+    std::FILE *const file = std::fopen(path, "r");
+    if (file == nullptr)
+        return Result<void>::failure();
+    Result<void> const result = profile.read(file);
+    std::fclose(file);
+    return result;
+}
+
+Result<void> load_binary(char const *path, Machine &machine)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+        return Result<void>::failure();
+    std::vector<std::uint8_t> const bytes{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    Result<BinaryImage, Error> const image = read_binary(bytes);
+    if (!image)
+        return Result<void>::failure();
+    for (BinarySegment const &segment : image.value().segments)
+    {
+        for (size_t i = 0; i < segment.words.size(); i++)
+        {
+            std::array<Byte, bytes_in_word> word;
+            word[0] = Sign(segment.words[i][0]);
+            for (size_t b = 1; b < bytes_in_word; b++)
+                word[b].byte = ValidatedByte::trusted_constructor(segment.words[i][b]).value();
+            machine.load_word(ValidatedAddress::trusted_constructor(segment.origin + i).value(), word);
+        }
+    }
+    ValidatedAddress const entry_point = ValidatedAddress::trusted_constructor(image.value().entry_point).value();
+    return machine.load_program(entry_point, {}, entry_point);
+}
+
+int profile(int argc, char **argv)
+{
+    char const *const profile_path = argv[2];
+    SequenceProfile profile;
+    if (std::FILE *const existing = std::fopen(profile_path, "r"))
+    {
+        std::fclose(existing);
+        if (!read_profile(profile_path, profile))
+        {
+            std::fprintf(stderr, "%s: %s is not a profile\n", argv[0], profile_path);
+            return 1;
+        }
+    }
+
+    for (int i = 3; i < argc; i++)
+    {
+        Machine machine;
+        machine.set_sequence_profile(&profile);
+        if (!load_binary(argv[i], machine))
+        {
+            std::fprintf(stderr, "%s: %s is not a valid MIX binary for a byte size of %zu\n", argv[0], argv[i], size_t(byte_size));
+            return 1;
+        }
+        RunResult const result = machine.run(profile_budget);
+        std::printf("%s: %zu instructions\n", argv[i], result.instructions);
+    }
+
+    std::FILE *const file = std::fopen(profile_path, "w");
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "%s: cannot write %s\n", argv[0], profile_path);
+        return 1;
+    }
+    profile.write(file);
+    std::fclose(file);
+    return 0;
+}
+
+int generate(int argc, char **argv)
+{
+    size_t const count = std::strtoull(argv[2], nullptr, 10);
+    char const *const output_path = argv[3];
+    SequenceProfile profile;
+    for (int i = 4; i < argc; i++)
+    {
+        if (!read_profile(argv[i], profile))
+        {
+            std::fprintf(stderr, "%s: %s is not a profile\n", argv[0], argv[i]);
+            return 1;
+        }
+    }
+
+    // A superinstruction of length n saves n - 1 dispatches each time it runs
+    std::vector<std::pair<std::uint64_t, SequenceProfile::Sequence>> ranked;
+    for (auto const &[sequence, runs] : profile.counts)
+        ranked.emplace_back(runs * (sequence.size() - 1), sequence);
+    std::sort(ranked.begin(), ranked.end(), [](auto const &a, auto const &b) { return a.first > b.first; });
+    ranked.resize(std::min(count, ranked.size()));
+    // Longest first, so that the predecoder tries them first
+    std::stable_sort(ranked.begin(), ranked.end(), [](auto const &a, auto const &b) { return a.second.size() > b.second.size(); });
+
+    std::FILE *const output = std::fopen(output_path, "w");
+    if (output == nullptr)
+    {
+        std::fprintf(stderr, "%s: cannot write %s\n", argv[0], output_path);
+        return 1;
+    }
+    std::fprintf(output, "#pragma once\n// Generated by tools/mix_superinstructions.cpp. Do not edit.\n\n");
+    std::fprintf(output, "// Expands IT(NAME, HANDLERS...) for every superinstruction, longest first\n");
+    std::fprintf(output, "#define SUPERINSTRUCTION_LIST(IT)");
+    for (auto const &[saved, sequence] : ranked)
+    {
+        std::string name = "fused";
+        char const *separator = "_";
+        std::string handlers;
+        for (OpHandler const handler : sequence)
+        {
+            std::string_view const handler_name = handler_names[handler];
+            name += separator;
+            name += handler_name.substr(2);
+            separator = "__";
+            handlers += ", ";
+            handlers += handler_name;
+        }
+        std::fprintf(output, " \\\n    /* saves %llu dispatches */ IT(%s%s)",
+                     static_cast<unsigned long long>(saved), name.c_str(), handlers.c_str());
+    }
+    std::fprintf(output, "\n");
+    std::fclose(output);
+    return 0;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && std::strcmp(argv[1], "profile") == 0)
+        return profile(argc, argv);
+    if (argc >= 5 && std::strcmp(argv[1], "generate") == 0)
+        return generate(argc, argv);
+    std::fprintf(stderr,
+                 "usage: %s profile <profile> <binary>...\n"
+                 "       %s generate <count> <output.h> <profile>...\n",
+                 argv[0], argv[0]);
+    return 2;
+}
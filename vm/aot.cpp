@@ -0,0 +1,171 @@
+#include <base/base.h>
+#include <vm/aot.h>
+#include <vm/machine.h>
+#include <vm/raw_word.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+char const *stop_reason_name(StopReason reason)
+{
+    switch (reason)
+    {
+    case StopReason::halted:
+        return "halted";
+    case StopReason::trap:
+        return "trap";
+    case StopReason::breakpoint:
+        return "breakpoint";
+    case StopReason::io_wait:
+        return "io_wait";
+    case StopReason::budget:
+        return "budget";
+    }
+    return "unknown";
+}
+
+}
+
+AotRuntime::AotRuntime(Machine &m, AotProgram const &program)
+    : m(m)
+    , program(program)
+{
+    block_starting.fill(no_block);
+    block_spanning.fill(no_block);
+    for (size_t i = 0; i < program.blocks.size(); i++)
+    {
+        AotBlock const &block = program.blocks[i];
+        block_starting[block.start] = NativeByte(i);
+        for (NativeByte address = block.start; address < block.start + block.length; address++)
+            block_spanning[address] = NativeByte(i);
+    }
+    NativeByte next = main_memory_size;
+    for (NativeByte address = main_memory_size; address --> 0;)
+    {
+        next_block_start[address] = next;
+        if (block_starting[address] != no_block)
+            next = address;
+    }
+}
+
+AotRuntime::~AotRuntime()
+{
+    if (m.aot == this)
+        m.aot = nullptr;
+}
+
+Result<void> AotRuntime::load()
+{
+    // Loaded before attaching, so that loading does not disable every block
+    m.aot = nullptr;
+    for (AotSegment const &segment : program.segments)
+    {
+        if (segment.words.size() > main_memory_size - segment.origin)
+            return Result<void>::failure();
+        for (size_t i = 0; i < segment.words.size(); i++)
+        {
+            Result<std::array<Byte, bytes_in_word>> const word = to_word(segment.words[i]);
+            if (!word)
+                return Result<void>::failure();
+            m.load_word(ValidatedAddress::trusted_constructor(segment.origin + i).value(), word.value());
+        }
+    }
+    Result<ValidatedAddress> const entry_point = ValidatedAddress::constructor(program.entry_point);
+    if (!entry_point)
+        return Result<void>::failure();
+    m.pc = entry_point.value();
+    disabled.reset();
+    m.aot = this;
+    return Result<void>::success();
+}
+
+DecodedInstruction AotRuntime::decode(RawWord const &word)
+{
+    return decode_instruction(pack(to_word(word).value()));
+}
+
+void AotRuntime::invalidate(ValidatedAddress address)
+{
+    NativeByte const block = block_spanning[address];
+    if (block == no_block)
+        return;
+    disabled.set(block);
+    m.translated_code_invalidated = true;
+}
+
+RunResult AotRuntime::run(size_t const budget)
+{
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    size_t remaining = budget;
+    cycles = 0;
+    while (remaining > 0)
+    {
+        NativeByte const index = m.pc < main_memory_size && !m.breakpoints[m.pc] ? block_starting[m.pc] : no_block;
+        AotBlock const *const block = index != no_block && !disabled[index] ? &program.blocks[index] : nullptr;
+        if (block != nullptr && block->length <= remaining) [[likely]]
+        {
+            m.translated_code_invalidated = false;
+            AotExit const exit = block->run(*this);
+            remaining -= exit.completed;
+            if (exit.status == JitStatus::trap) [[unlikely]]
+            {
+                result.reason = StopReason::trap;
+                result.trap = m.record_trap();
+                break;
+            }
+        }
+        else
+        {
+            // Not the start of a live block, on a breakpoint, or the budget ends partway through the block.
+            // Interpreted up to the next block start, which code that runs straight on reaches with the run.
+            size_t const interpreted = block != nullptr || m.pc >= main_memory_size
+                ? remaining
+                : std::min<size_t>(remaining, next_block_start[m.pc] - m.pc);
+            RunResult const interpreted_run = m.run_jump_table(interpreted);
+            remaining -= interpreted_run.instructions;
+            cycles += interpreted_run.cycles;
+            if (interpreted_run.reason != StopReason::budget)
+            {
+                result.reason = interpreted_run.reason;
+                result.trap = interpreted_run.trap;
+                break;
+            }
+        }
+        if (m.pending_stop) [[unlikely]]
+        {
+            result.reason = *m.pending_stop;
+            break;
+        }
+    }
+    result.instructions = budget - remaining;
+    result.cycles = cycles;
+    return result;
+}
+
+int aot_main(AotProgram const &program, int argc, char **argv)
+{
+    size_t const budget = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::numeric_limits<size_t>::max();
+    Machine machine;
+    AotRuntime runtime(machine, program);
+    if (!runtime.load())
+    {
+        std::fprintf(stderr, "%s: the program does not fit in memory\n", argv[0]);
+        return 2;
+    }
+    RunResult const result = machine.run(budget);
+    std::printf("%s after %zu instructions, %zu u\n", stop_reason_name(result.reason), result.instructions, result.cycles);
+    if (result.reason == StopReason::trap)
+        std::printf("trap %u at %u\n", unsigned(result.trap.code), unsigned(result.trap.pc));
+    return result.reason == StopReason::halted ? 0 : 1;
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
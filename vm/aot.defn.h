@@ -0,0 +1,131 @@
+#pragma once
+#include <base/base.h>
+#include <vm/engine.h>
+#include <vm/instruction.defn.h>
+#include <vm/jit.decl.h>
+#include <vm/machine.decl.h>
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <optional>
+#include <span>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// How far a block translated ahead of time got before it returned
+struct AotExit
+{
+    JitStatus status;
+    // Instructions of the block that completed
+    NativeByte completed;
+};
+
+// A basic block of a program translated ahead of time, see tools/mix_aot.cpp
+struct AotBlock
+{
+    NativeByte start;
+    NativeByte length;
+    AotExit (*run)(AotRuntime &runtime);
+};
+
+// A load segment of a program translated ahead of time, as it was in the binary
+struct AotSegment
+{
+    NativeByte origin;
+    std::span<RawWord const> words;
+};
+
+// What tools/mix_aot.cpp generates for a MIX binary
+struct AotProgram
+{
+    std::span<AotSegment const> segments;
+    NativeByte entry_point;
+    // Sorted by start, and never overlapping
+    std::span<AotBlock const> blocks;
+};
+
+// Runs a program translated ahead of time on a Machine, in place of its dispatch engine.
+//
+// A block whose start is reached runs as its translated function, which runs its instructions one after another through execute:
+// loads, stores, ADD, SUB, CMP, address transfers and jumps inline, with every part of the instruction a constant,
+// and the other instructions through their handlers.
+// Everything else, i.e. instructions that the translator could not reach or that it found being stored into,
+// breakpoints and the tail of a run whose budget ends partway through a block, is left to the interpreter,
+// which runs up to the next block start at a time.
+// A write into a translated block, by the program or the host, disables the block for as long as the runtime is attached,
+// so a program that modifies itself anyway runs correctly, only interpreted.
+class AotRuntime
+{
+    static constexpr NativeByte no_block = NativeByte(-1);
+
+    Machine &m;
+    AotProgram const &program;
+
+    // Index into program.blocks of the block starting at each address, or no_block
+    std::array<NativeByte, main_memory_size> block_starting;
+    // Index into program.blocks of the block spanning each address, or no_block
+    std::array<NativeByte, main_memory_size> block_spanning;
+    // The first address after each address that a block starts at, or main_memory_size
+    std::array<NativeByte, main_memory_size> next_block_start;
+
+    // Blocks that have been written into since the program was loaded, by index into program.blocks
+    std::bitset<main_memory_size> disabled;
+
+    // Execution time of the current run in units of u, kept up to date by execute
+    size_t cycles = 0;
+
+    // Executes the instruction at address through its handler
+    [[gnu::always_inline]] inline
+    JitStatus call_handler(NativeByte address, DecodedInstruction const &decoded);
+
+    // Fails the instruction at address, with TrapCode::none if record_trap is to work out why
+    [[gnu::always_inline]] inline
+    JitStatus trap(NativeByte address, DecodedInstruction const &decoded, TrapCode code);
+
+    // M of an instruction whose handler execute runs inline, or nothing if the instruction traps on it
+    template <DecodedInstruction decoded>
+    [[gnu::always_inline]] inline
+    std::optional<NativeByte> operand() const;
+
+public:
+    AotRuntime(Machine &m, AotProgram const &program);
+    // Detaches from the machine
+    ~AotRuntime();
+
+    AotRuntime(AotRuntime const &) = delete;
+    AotRuntime &operator=(AotRuntime const &) = delete;
+
+    // Loads the program into the machine, sets pc to its entry point, and attaches to the machine,
+    // so that Machine::run runs through the runtime from then on.
+    // Fails if the program does not fit in memory, or has a byte that does not fit in a MIX byte.
+    Result<void> load();
+
+    // Same as Machine::run, from wherever Machine::run leaves off
+    RunResult run(size_t budget);
+
+    // Called whenever a cell is written to, or has a breakpoint set or cleared
+    void invalidate(ValidatedAddress address);
+
+    // Decodes a word of the program, for the decoded instructions of translated blocks.
+    // The translator only emits words whose bytes fit in a MIX byte.
+    static DecodedInstruction decode(RawWord const &word);
+
+    // Executes the instruction at address, decoded ahead of time, for a translated block.
+    // The common instructions run inline, specialised for the instruction, and the others call their handler directly.
+    template <NativeByte address, DecodedInstruction decoded>
+    [[gnu::always_inline]] inline
+    JitStatus execute();
+};
+
+// The program translated by tools/mix_aot.cpp, defined by its output
+extern AotProgram const aot_program;
+
+// The main function of an executable generated with mix_aot --main.
+// Runs the program from its entry point until it stops, with the budget given as the only argument or no budget,
+// and prints why it stopped. Returns 0 if the program halted.
+int aot_main(AotProgram const &program, int argc, char **argv);
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,3 @@
+#pragma once
+#include <vm/aot.defn.h>
+#include <vm/aot.impl.h>
@@ -0,0 +1,186 @@
+#pragma once
+#include <base/base.h>
+#include <vm/aot.defn.h>
+#include <vm/machine.h>
+
+#include <compare>
+#include <utility>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+JitStatus AotRuntime::call_handler(NativeByte address, DecodedInstruction const &decoded)
+{
+    m.pc = address;
+    m.inst.decoded = &decoded;
+    JitStatus const status = Machine::jit_thunks[decoded.handler](m);
+    if (status != JitStatus::trap) [[likely]]
+        cycles += decoded.cycles;
+    return status;
+}
+
+JitStatus AotRuntime::trap(NativeByte address, DecodedInstruction const &decoded, TrapCode code)
+{
+    m.pc = address;
+    m.inst.decoded = &decoded;
+    m.trap_record.code = code;
+    return JitStatus::trap;
+}
+
+template <DecodedInstruction decoded>
+std::optional<NativeByte> AotRuntime::operand() const
+{
+    if constexpr (decoded.raw_I == 0)
+        return NativeByte(decoded.raw_A);
+    else
+    {
+        NativeInt const M = decoded.raw_A + NativeInt(m.index_registers[decoded.raw_I - 1].native_value());
+        if (M < 0 || M >= NativeInt(main_memory_size)) [[unlikely]]
+            return std::nullopt;
+        return NativeByte(M);
+    }
+}
+
+// Mirrors the handlers that it stands in for, which vm/machine.cpp defines, and falls back on them for everything else
+template <NativeByte address, DecodedInstruction decoded>
+JitStatus AotRuntime::execute()
+{
+    constexpr OpHandler handler = decoded.handler;
+    constexpr NativeByte C = handler < h_invalid ? handler_op_codes[handler] : 0;
+    constexpr NativeByte F = decoded.raw_F;
+    constexpr PackedField field = packed_fields[F];
+    constexpr bool reads_field = handler < h_invalid && handler_reads_field[handler];
+    // As verified_handler has it, except that an indexed instruction with an invalid I is left to its handler
+    constexpr bool inline_operand = decoded.raw_I == 0
+        ? decoded.raw_A >= 0 && decoded.raw_A < NativeInt(main_memory_size) && (!reads_field || field.valid)
+        : decoded.raw_I <= 6 && (!reads_field || field.valid);
+
+    constexpr bool is_load = C >= op_lda && C <= op_ldxn;
+    constexpr bool is_store = C >= op_sta && C <= op_stz;
+    constexpr bool is_arithmetic = (C == op_add || C == op_sub) && reads_field;
+    constexpr bool is_compare = C >= op_cmpa && C <= op_cmpx && reads_field;
+    constexpr bool is_address_transfer = C >= op_inca && C <= op_incx && F <= 3;
+    constexpr bool is_jump = (C == op_jmp && F <= 9) || (C >= op_jan && C <= op_jxn && F <= 5);
+
+    if constexpr (!inline_operand || !(is_load || is_store || is_arithmetic || is_compare || is_address_transfer || is_jump))
+        return call_handler(address, decoded);
+    else
+    {
+        std::optional<NativeByte> const M = operand<decoded>();
+        if (!M) [[unlikely]]
+            return trap(address, decoded, TrapCode::none);
+        auto const word_at = [this](NativeByte cell) {
+            return m.memory.load(ValidatedAddress::trusted_constructor(cell).value());
+        };
+
+        if constexpr (is_load)
+        {
+            constexpr bool negated = C >= op_ldan;
+            auto &reg = m.get_register<Machine::RegisterIdx(C - (negated ? op_ldan : op_lda))>();
+            PackedWord const word = word_at(*M);
+            Sign const sign = packed_field_sign(word, field);
+            if (reg.load(negated ? -sign : sign, packed_field_magnitude(word, field)))
+                return trap(address, decoded, TrapCode::index_overflow);
+        }
+        else if constexpr (is_store)
+        {
+            auto const &reg = m.get_register<Machine::RegisterIdx(C - op_sta)>();
+            ValidatedAddress const cell = ValidatedAddress::trusted_constructor(*M).value();
+            m.memory.store(cell, packed_store_field(m.memory.load(cell), reg.packed_word(), field));
+            m.invalidate_decoded_instruction(cell);
+        }
+        else if constexpr (is_arithmetic)
+        {
+            NativeInt const V = packed_field_value(word_at(*M), field);
+            if (m.rA.load(C == op_add ? m.rA.native_value() + V : m.rA.native_value() - V))
+                m.overflow = true;
+        }
+        else if constexpr (is_compare)
+        {
+            auto const &reg = m.get_register<Machine::RegisterIdx(C - op_cmpa)>();
+            m.comparison = packed_field_value(reg.packed_word(), field) <=> packed_field_value(word_at(*M), field);
+        }
+        else if constexpr (is_address_transfer)
+        {
+            constexpr Machine::RegisterIdx reg_idx = Machine::RegisterIdx(C - op_inca);
+            auto &reg = m.get_register<reg_idx>();
+            if constexpr (F <= 1)
+            {
+                if (reg.increment(F == 0 ? NativeInt(*M) : -NativeInt(*M)))
+                {
+                    if constexpr (reg_idx != Machine::idx_rA && reg_idx != Machine::idx_rX)
+                        return trap(address, decoded, TrapCode::index_overflow);
+                    m.overflow = true;
+                }
+            }
+            else if (*M == 0)
+                reg.load_zero(F == 2 ? decoded.sign() : -decoded.sign());
+            else
+                reg.load(F == 2 ? NativeInt(*M) : -NativeInt(*M));
+        }
+        else if constexpr (is_jump)
+        {
+            bool taken;
+            if constexpr (C == op_jmp)
+            {
+                switch (F)
+                {
+                case 2:
+                    taken = std::exchange(m.overflow, false);
+                    break;
+                case 3:
+                    taken = !std::exchange(m.overflow, false);
+                    break;
+                case 4:
+                    taken = m.comparison < 0;
+                    break;
+                case 5:
+                    taken = m.comparison == 0;
+                    break;
+                case 6:
+                    taken = m.comparison > 0;
+                    break;
+                case 7:
+                    taken = m.comparison >= 0;
+                    break;
+                case 8:
+                    taken = m.comparison != 0;
+                    break;
+                case 9:
+                    taken = m.comparison <= 0;
+                    break;
+                default:
+                    // JMP and JSJ
+                    taken = true;
+                }
+            }
+            else
+            {
+                // -0 counts as zero
+                NativeInt const value = m.get_register<Machine::RegisterIdx(C - op_jan)>().native_value();
+                constexpr bool on_negative = F == 0 || F == 4 || F == 5;
+                constexpr bool on_zero = F == 1 || F == 3 || F == 5;
+                constexpr bool on_positive = F == 2 || F == 3 || F == 4;
+                taken = value < 0 ? on_negative : value == 0 ? on_zero : on_positive;
+            }
+            cycles += decoded.cycles;
+            if (!taken)
+            {
+                m.pc = address + 1;
+                return JitStatus::next;
+            }
+            // JSJ leaves rJ alone
+            if constexpr (C != op_jmp || F != 1)
+                m.rJ.load(NativeInt(address + 1));
+            m.pc = *M;
+            return JitStatus::next;
+        }
+
+        cycles += decoded.cycles;
+        m.pc = address + 1;
+        return is_store && m.translated_code_invalidated ? JitStatus::leave : JitStatus::next;
+    }
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <base/base.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+namespace mix
+{
+
+// Writes bytes to a temporary file of its own next to path, and renames it to path, so that other threads and processes
+// only ever see a whole file, even when two of them write the same path at once.
+// Returns whether path was written; the temporary file is removed if it was not.
+inline bool write_file_atomically(std::filesystem::path const &path, std::span<std::byte const> const bytes)
+{
+    std::string temporary = path.string() + ".XXXXXX";
+    int const fd = mkstemp(temporary.data());
+    if (fd < 0)
+        return false;
+    std::error_code error;
+    std::FILE *const file = fdopen(fd, "wb");
+    if (file == nullptr)
+    {
+        close(fd);
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    bool const written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    if (std::fclose(file) == 0 && written)
+    {
+        std::filesystem::rename(temporary, path, error);
+        if (!error)
+            return true;
+    }
+    std::filesystem::remove(temporary, error);
+    return false;
+}
+
+}
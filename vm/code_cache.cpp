@@ -0,0 +1,188 @@
+#include <base/base.h>
+#include <vm/atomic_file.h>
+#include <vm/code_cache.h>
+#include <vm/fnv1a.h>
+#include <vm/idiom.h>
+#include <vm/superinstruction.h>
+
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+// A segment as a file of a cache directory, in native byte order: the header, the words of the segment,
+// and then a CachedCell for each word
+struct CodeCacheFileHeader
+{
+    static constexpr char expected_magic[8] = {'M', 'I', 'X', 'C', 'O', 'D', 'E', '\0'};
+    // Changed whenever the layout of a file, or what a file means, changes
+    static constexpr std::uint32_t current_version = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_size;
+    // Of the handlers that this build has (see code_cache_fingerprint)
+    std::uint64_t fingerprint;
+    std::uint64_t origin;
+    std::uint64_t count;
+    // fnv1a over the header, with checksum 0, and then the rest of the file
+    std::uint64_t checksum;
+};
+
+// Identifies the superinstructions and idioms that a build predecodes to, since a file names them by OpHandler
+constexpr std::uint64_t code_cache_fingerprint()
+{
+    std::uint64_t h = fnv1a_basis;
+    auto const mix = [&h](std::uint64_t value) {
+        h ^= value;
+        h *= 0x100000001b3;
+    };
+    mix(h_invalid);
+    mix(h_idiom);
+    mix(max_idiom_length);
+    for (Superinstruction const &superinstruction : superinstructions)
+    {
+        mix(superinstruction.handler);
+        for (NativeByte k = 0; k < superinstruction.length; k++)
+            mix(superinstruction.handlers[k]);
+    }
+    return h;
+}
+
+std::uint64_t checksum(CodeCacheFileHeader header, std::span<std::byte const> body)
+{
+    header.checksum = 0;
+    return fnv1a(fnv1a(fnv1a_basis, std::as_bytes(std::span(&header, 1))), body);
+}
+
+}
+
+bool is_predecoded_form(CachedCell const &cell, std::span<PackedWord const> words, size_t i)
+{
+    DecodedInstruction const decoded = decode_instruction(words[i]);
+    if (cell.handler == decoded.handler)
+        return cell.cycles == decoded.cycles && cell.instructions == decoded.instructions;
+    // do_idiom matches the loop again before running it in bulk
+    if (cell.handler == h_idiom)
+        return cell.cycles == 0 && cell.instructions == 0;
+    if (cell.handler <= h_idiom || cell.handler > h_idiom + superinstruction_count)
+        return false;
+    Superinstruction const &superinstruction = superinstructions[cell.handler - h_idiom - 1];
+    if (cell.instructions != superinstruction.length || i + superinstruction.length > words.size())
+        return false;
+    NativeByte cycles = 0;
+    for (NativeByte k = 0; k < superinstruction.length; k++)
+    {
+        DecodedInstruction const component = decode_instruction(words[i + k]);
+        if (component.handler != superinstruction.handlers[k])
+            return false;
+        cycles += component.cycles;
+    }
+    return cell.cycles == cycles;
+}
+
+std::filesystem::path CodeCache::file_path(std::uint64_t key) const
+{
+    char name[40];
+    std::snprintf(name, sizeof name, "%016llx-%u.mixcode", static_cast<unsigned long long>(key), NativeByte(byte_size));
+    return directory / name;
+}
+
+std::shared_ptr<SharedSegment const> CodeCache::read_file(std::filesystem::path const &path, NativeByte origin, std::span<PackedWord const> words)
+{
+    int const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    struct stat status;
+    size_t const expected_size = sizeof(CodeCacheFileHeader) + words.size() * (sizeof(PackedWord) + sizeof(CachedCell));
+    void *const mapping = fstat(fd, &status) == 0 && size_t(status.st_size) == expected_size
+        ? mmap(nullptr, expected_size, PROT_READ, MAP_PRIVATE, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    std::shared_ptr<SharedSegment> segment;
+    std::span<std::byte const> const file(static_cast<std::byte const *>(mapping), expected_size);
+    CodeCacheFileHeader header;
+    std::memcpy(&header, file.data(), sizeof header);
+    std::span<std::byte const> const body = file.subspan(sizeof header);
+    std::span<std::byte const> const file_words = body.first(words.size() * sizeof(PackedWord));
+    if (std::memcmp(header.magic, CodeCacheFileHeader::expected_magic, sizeof header.magic) == 0
+        && header.version == CodeCacheFileHeader::current_version
+        && header.byte_size == byte_size
+        && header.fingerprint == code_cache_fingerprint()
+        && header.origin == origin
+        && header.count == words.size()
+        && header.checksum == checksum(header, body)
+        && std::memcmp(file_words.data(), words.data(), file_words.size()) == 0)
+    {
+        segment = std::make_shared<SharedSegment>();
+        segment->origin = origin;
+        segment->words.assign(words.begin(), words.end());
+        segment->cached_cells.resize(words.size());
+        std::memcpy(segment->cached_cells.data(), body.data() + file_words.size(), words.size() * sizeof(CachedCell));
+    }
+    munmap(mapping, expected_size);
+    return segment;
+}
+
+void CodeCache::write_file(std::filesystem::path const &path, SharedSegment const &segment)
+{
+    std::vector<CachedCell> cells(segment.cells.size());
+    for (size_t i = 0; i < cells.size(); i++)
+        cells[i] = {segment.cells[i].handler, segment.cells[i].cycles, segment.cells[i].instructions};
+    std::span<std::byte const> const words = std::as_bytes(std::span(segment.words));
+    std::span<std::byte const> const cached_cells = std::as_bytes(std::span(cells));
+    std::vector<std::byte> body(words.begin(), words.end());
+    body.insert(body.end(), cached_cells.begin(), cached_cells.end());
+
+    CodeCacheFileHeader header{};
+    std::memcpy(header.magic, CodeCacheFileHeader::expected_magic, sizeof header.magic);
+    header.version = CodeCacheFileHeader::current_version;
+    header.byte_size = byte_size;
+    header.fingerprint = code_cache_fingerprint();
+    header.origin = segment.origin;
+    header.count = segment.words.size();
+    header.checksum = checksum(header, body);
+
+    std::span<std::byte const> const header_bytes = std::as_bytes(std::span(&header, 1));
+    body.insert(body.begin(), header_bytes.begin(), header_bytes.end());
+    write_file_atomically(path, body);
+}
+
+CodeCache &CodeCache::process_wide()
+{
+    static CodeCache cache;
+    return cache;
+}
+
+void CodeCache::set_directory(std::filesystem::path path)
+{
+    if (!path.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+    }
+    std::lock_guard const lock(mutex);
+    directory = std::move(path);
+}
+
+void CodeCache::clear()
+{
+    std::lock_guard const lock(mutex);
+    segments.clear();
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <base/base.h>
+#include <vm/fnv1a.h>
+#include <vm/instruction.defn.h>
+#include <vm/packed_word.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// What predecoding changes in the plain decode of a word, which is all that a file keeps of a decoded cell
+struct CachedCell
+{
+    std::uint32_t handler;
+    std::uint32_t cycles;
+    std::uint32_t instructions;
+};
+
+// Whether a cached cell is what predecoding could have made of the word at offset i of words
+bool is_predecoded_form(CachedCell const &cell, std::span<PackedWord const> words, size_t i);
+
+// The predecoded form of a loaded segment, superinstructions and idioms included, as a machine with no breakpoints decodes it.
+// A decoded cell never depends on a cell outside of the segment.
+struct SharedSegment
+{
+    NativeByte origin;
+    std::vector<PackedWord> words;
+    // Empty for a segment read from a file, whose cells are only decoded as machines first run them
+    std::vector<DecodedInstruction> cells;
+    // Those of the file, for a segment read from one
+    std::vector<CachedCell> cached_cells;
+
+    // Returns the decoded cell at offset i, or nothing if the file had a cell there that predecoding could not have made
+    std::optional<DecodedInstruction> cell(size_t i) const
+    {
+        if (cached_cells.empty())
+            return cells[i];
+        CachedCell const &cached = cached_cells[i];
+        if (!is_predecoded_form(cached, words, i))
+            return std::nullopt;
+        DecodedInstruction decoded = decode_instruction(words[i]);
+        decoded.handler = OpHandler(cached.handler);
+        decoded.cycles = std::uint8_t(cached.cycles);
+        decoded.instructions = std::uint8_t(cached.instructions);
+        return decoded;
+    }
+};
+
+// Predecoded segments shared by every machine that loads the same words at the same origin, from any thread.
+// Entries are never changed once cached: a machine copies a cell into its own decoded_instructions when it first runs it,
+// and only if it has not written to the cells that the decoded form depends on, so that its own writes never reach other machines.
+// The cache only holds a segment while some machine does, so that a long-lived process that loads many programs
+// does not keep every one of them.
+//
+// With a directory set, a segment that is not cached yet is read from the directory, so that a process
+// does not have to predecode again what an earlier one did, and a segment built anew is written there (see vm/code_cache.cpp).
+// A file is only used if it has the version, byte size and fingerprint of this build, its checksum holds,
+// and its words are the loaded ones; any other file is ignored and replaced. The cells of a file are not decoded as it is read,
+// but as machines first run them, and a cell that predecoding could not have made of its words is decoded afresh instead.
+// JIT code is never written, since it points into the process that generated it.
+class CodeCache
+{
+    std::mutex mutex;
+    // By hash of the origin and words. An entry whose segment no machine holds any more is dropped when its key is
+    // looked up again, or when the map next grows to sweep_at entries.
+    std::unordered_map<std::uint64_t, std::weak_ptr<SharedSegment const>> segments;
+    size_t sweep_at = 64;
+    // Empty when segments are not persisted
+    std::filesystem::path directory;
+
+    static std::uint64_t hash(NativeByte origin, std::span<PackedWord const> words)
+    {
+        return fnv1a(fnv1a(fnv1a_basis, std::as_bytes(std::span(&origin, 1))), std::as_bytes(words));
+    }
+
+    std::filesystem::path file_path(std::uint64_t key) const;
+
+    // Returns nullptr unless the file holds a valid segment of the words at origin
+    static std::shared_ptr<SharedSegment const> read_file(std::filesystem::path const &path, NativeByte origin, std::span<PackedWord const> words);
+
+    // Failing to write is not an error, since the segment is then just predecoded again next time.
+    static void write_file(std::filesystem::path const &path, SharedSegment const &segment);
+
+public:
+    // The cache used by machines unless Machine::set_code_cache says otherwise
+    static CodeCache &process_wide();
+
+    // Persists segments in a directory, which is created if need be, or stops persisting them with an empty path.
+    // Several processes may share a directory.
+    void set_directory(std::filesystem::path path);
+
+    // Returns the segment cached for the words at origin, caching the one that build returns if there is none yet.
+    // build runs without the lock held, so two machines loading the same new program at once may both build it.
+    // Returns nullptr if another segment has the same hash.
+    template <class Build>
+    std::shared_ptr<SharedSegment const> find_or_build(NativeByte origin, std::span<PackedWord const> words, Build &&build)
+    {
+        std::uint64_t const key = hash(origin, words);
+        auto const matches = [origin, words](SharedSegment const &segment) {
+            return segment.origin == origin && std::equal(words.begin(), words.end(), segment.words.begin(), segment.words.end());
+        };
+        std::filesystem::path path;
+        {
+            std::lock_guard const lock(mutex);
+            auto const found = segments.find(key);
+            if (found != segments.end())
+            {
+                if (std::shared_ptr<SharedSegment const> segment = found->second.lock())
+                    return matches(*segment) ? segment : nullptr;
+                segments.erase(found);
+            }
+            if (!directory.empty())
+                path = file_path(key);
+        }
+        std::shared_ptr<SharedSegment const> built = path.empty() ? nullptr : read_file(path, origin, words);
+        if (!built)
+        {
+            built = build();
+            if (!path.empty())
+                write_file(path, *built);
+        }
+        std::lock_guard const lock(mutex);
+        std::weak_ptr<SharedSegment const> &entry = segments[key];
+        if (std::shared_ptr<SharedSegment const> segment = entry.lock())
+            return matches(*segment) ? segment : nullptr;
+        entry = built;
+        if (segments.size() >= sweep_at)
+        {
+            std::erase_if(segments, [](auto const &segment) { return segment.second.expired(); });
+            sweep_at = std::max<size_t>(64, segments.size() * 2);
+        }
+        return built;
+    }
+
+    // Forgets every segment, although the machines that use one keep it.
+    // Files in the directory are left alone.
+    void clear();
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,2 @@
+#pragma once
+#include <vm/code_cache.defn.h>
@@ -0,0 +1,25 @@
+#include <base/base.h>
+#include <vm/engine.h>
+namespace mix
+{
+
+std::unique_ptr<Engine> make_engine(NativeByte size)
+{
+    switch (size)
+    {
+    case 64:
+        return make_engine<64>();
+    case 100:
+        return make_engine<100>();
+    default:
+        return nullptr;
+    }
+}
+
+void set_code_cache_directory(std::filesystem::path const &directory)
+{
+    set_code_cache_directory<64>(directory);
+    set_code_cache_directory<100>(directory);
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <base/base.h>
+#include <vm/machine.decl.h>
+
+#include <filesystem>
+#include <memory>
+namespace mix
+{
+
+// A MIX word as laid out in a MIX binary: the sign (0 for +, 1 for -) followed by the 5 numerical bytes.
+// Unlike Byte, it does not depend on byte_size.
+using RawWord = std::array<NativeByte, bytes_in_word>;
+
+// A Machine behind an interface that does not depend on byte_size, so that the byte size can be picked per program at load time.
+// Each byte size is backed by its own build of Machine, in which division and modulo by byte_size stay constant-folded.
+class Engine
+{
+public:
+    virtual ~Engine() = default;
+
+    virtual NativeByte mix_byte_size() const = 0;
+
+    virtual void set_dispatch_engine(DispatchEngine engine) = 0;
+
+    // See Machine::run
+    virtual RunResult run(size_t budget) = 0;
+
+    // The functions below fail on an address outside of memory, or on a word with a byte that does not fit in a MIX byte
+
+    virtual Result<void> load_program(NativeByte origin, std::span<RawWord const> words, NativeByte entry_point) = 0;
+
+    virtual Result<void> load_word(NativeByte address, RawWord const &word) = 0;
+
+    virtual Result<RawWord> read_word(NativeByte address) const = 0;
+
+    virtual Result<void> set_breakpoint(NativeByte address) = 0;
+
+    virtual Result<void> clear_breakpoint(NativeByte address) = 0;
+
+    virtual std::optional<IoRequest> const &io_request() const = 0;
+
+    virtual Trap const &last_trap() const = 0;
+};
+
+// Specialised for each byte size that the simulator is built for, see vm/engine_64.cpp and vm/engine_100.cpp
+template <NativeByte size>
+std::unique_ptr<Engine> make_engine();
+
+template <>
+std::unique_ptr<Engine> make_engine<64>();
+
+template <>
+std::unique_ptr<Engine> make_engine<100>();
+
+// Returns nullptr when the simulator is not built for the byte size
+std::unique_ptr<Engine> make_engine(NativeByte size);
+
+// Sets the directory that the process-wide code cache of a byte size persists predecoded programs in (see vm/code_cache.h)
+template <NativeByte size>
+void set_code_cache_directory(std::filesystem::path const &directory);
+
+template <>
+void set_code_cache_directory<64>(std::filesystem::path const &directory);
+
+template <>
+void set_code_cache_directory<100>(std::filesystem::path const &directory);
+
+// Sets it for every byte size, each of which keeps its own files there. An empty path stops persisting.
+void set_code_cache_directory(std::filesystem::path const &directory);
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <base/base.h>
+#include <vm/engine.h>
+#include <vm/machine.h>
+#include <vm/raw_word.h>
+
+#include <vector>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// The Engine of the byte size that this translation unit is built for
+class MachineEngine final : public Engine
+{
+    Machine machine;
+
+    static Result<ValidatedAddress> to_address(NativeByte address)
+    {
+        return ValidatedAddress::constructor(address);
+    }
+
+public:
+    NativeByte mix_byte_size() const override
+    {
+        return byte_size;
+    }
+
+    void set_dispatch_engine(DispatchEngine engine) override
+    {
+        machine.set_dispatch_engine(engine);
+    }
+
+    RunResult run(size_t budget) override
+    {
+        return machine.run(budget);
+    }
+
+    Result<void> load_program(NativeByte origin, std::span<RawWord const> raw_words, NativeByte entry_point) override
+    {
+        std::vector<std::array<Byte, bytes_in_word>> words;
+        words.reserve(raw_words.size());
+        for (RawWord const &raw : raw_words)
+        {
+            Result<std::array<Byte, bytes_in_word>> const word = to_word(raw);
+            if (!word)
+                return Result<void>::failure();
+            words.push_back(word.value());
+        }
+
+        Result<ValidatedAddress> const validated_origin = to_address(origin);
+        Result<ValidatedAddress> const validated_entry_point = to_address(entry_point);
+        if (!validated_origin || !validated_entry_point)
+            return Result<void>::failure();
+        return machine.load_program(validated_origin.value(), words, validated_entry_point.value());
+    }
+
+    Result<void> load_word(NativeByte address, RawWord const &raw) override
+    {
+        Result<ValidatedAddress> const validated_address = to_address(address);
+        Result<std::array<Byte, bytes_in_word>> const word = to_word(raw);
+        if (!validated_address || !word)
+            return Result<void>::failure();
+        machine.load_word(validated_address.value(), word.value());
+        return Result<void>::success();
+    }
+
+    Result<RawWord> read_word(NativeByte address) const override
+    {
+        return to_address(address).transform_value([this](ValidatedAddress const validated_address){
+            return Result<RawWord>::success(to_raw_word(machine.read_word(validated_address)));
+        });
+    }
+
+    Result<void> set_breakpoint(NativeByte address) override
+    {
+        return to_address(address).transform_value([this](ValidatedAddress const validated_address){
+            machine.set_breakpoint(validated_address);
+        });
+    }
+
+    Result<void> clear_breakpoint(NativeByte address) override
+    {
+        return to_address(address).transform_value([this](ValidatedAddress const validated_address){
+            machine.clear_breakpoint(validated_address);
+        });
+    }
+
+    std::optional<IoRequest> const &io_request() const override
+    {
+        return machine.io_request();
+    }
+
+    Trap const &last_trap() const override
+    {
+        return machine.last_trap();
+    }
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,27 @@
+// Builds the simulator for decimal MIX, with a byte size of 100, alongside the binary one (see vm/engine.h)
+#undef MIX_BYTE_SIZE
+#define MIX_BYTE_SIZE 100
+
+#include <vm/instruction.cpp>
+#include <vm/register.cpp>
+#include <vm/machine.cpp>
+#include <vm/code_cache.cpp>
+#include <vm/jit.cpp>
+#include <vm/aot.cpp>
+#include <vm/engine.impl.h>
+namespace mix
+{
+
+template <>
+std::unique_ptr<Engine> make_engine<100>()
+{
+    return std::make_unique<MachineEngine>();
+}
+
+template <>
+void set_code_cache_directory<100>(std::filesystem::path const &directory)
+{
+    CodeCache::process_wide().set_directory(directory);
+}
+
+}
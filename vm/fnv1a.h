@@ -0,0 +1,23 @@
+#pragma once
+#include <base/base.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+namespace mix
+{
+
+// FNV-1a, continued from h
+inline std::uint64_t fnv1a(std::uint64_t h, std::span<std::byte const> bytes)
+{
+    for (std::byte const byte : bytes)
+    {
+        h ^= std::to_integer<std::uint64_t>(byte);
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+constexpr std::uint64_t fnv1a_basis = 0xcbf29ce484222325;
+
+}
@@ -0,0 +1,188 @@
+#include <base/base.h>
+#include <vm/fork_server.h>
+#include <vm/machine.h>
+#include <vm/snapshot_file.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+// What a child writes to its pipe, followed by the words that its job punched and then those that it printed.
+// The server reads it in the same build, so it is written as it is laid out in memory.
+struct ChildReport
+{
+    RunResult run;
+    std::optional<IoRequest> io;
+    bool finished;
+    std::uint64_t next_card;
+    std::uint64_t punched;
+    std::uint64_t printed;
+};
+
+static_assert(std::is_trivially_copyable_v<ChildReport> && std::is_trivially_copyable_v<RawWord>);
+
+bool write_all(int const fd, std::span<std::byte const> bytes)
+{
+    while (!bytes.empty())
+    {
+        ssize_t const written = write(fd, bytes.data(), bytes.size());
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        bytes = bytes.subspan(size_t(written));
+    }
+    return true;
+}
+
+}
+
+ForkServer::ForkServer(size_t const max_children, DispatchEngine const engine)
+    : machine(std::make_unique<Machine>()),
+      max_children(max_children == 0 ? std::max(1u, std::thread::hardware_concurrency()) : max_children)
+{
+    machine->set_dispatch_engine(engine);
+}
+
+ForkServer::~ForkServer() = default;
+
+std::unique_ptr<ForkServer::Child> ForkServer::start(size_t const index, Job const &job)
+{
+    // A job with a snapshot file restores it in its child instead
+    if (!job.snapshot && binary != job.binary)
+    {
+        machine->reset();
+        load_binary(*machine, *job.binary);
+        machine->predecode_all();
+        binary = job.binary;
+    }
+
+    int ends[2];
+    if (pipe2(ends, O_CLOEXEC) != 0)
+        return nullptr;
+    pid_t const pid = fork();
+    if (pid < 0)
+    {
+        close(ends[0]);
+        close(ends[1]);
+        return nullptr;
+    }
+    if (pid == 0)
+    {
+        close(ends[0]);
+        JobResult result;
+        // The server stops a child by killing it
+        if (job.snapshot)
+        {
+            machine->restore(*job.snapshot);
+            resume_loaded_job(*machine, job, job.snapshot->header().counters, result, {});
+        }
+        else
+            run_loaded_job(*machine, job, result, {});
+        ChildReport const report{
+            .run = result.run,
+            .io = result.io,
+            .finished = result.finished,
+            .next_card = result.next_card,
+            .punched = result.punched.size(),
+            .printed = result.printed.size(),
+        };
+        bool const written = write_all(ends[1], std::as_bytes(std::span(&report, 1)))
+            && write_all(ends[1], std::as_bytes(std::span(result.punched)))
+            && write_all(ends[1], std::as_bytes(std::span(result.printed)));
+        // Leaves the server's buffers and destructors alone
+        _exit(written ? 0 : 1);
+    }
+    close(ends[1]);
+    return std::make_unique<Child>(Child{.pid = pid, .pipe = ends[0], .job = index, .output = {}});
+}
+
+void ForkServer::finish(Child &child, JobResult &result)
+{
+    close(child.pipe);
+    int status = 0;
+    while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    ChildReport report;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || child.output.size() < sizeof report)
+        return;
+    std::memcpy(&report, child.output.data(), sizeof report);
+    size_t const words = child.output.size() - sizeof report;
+    if (report.punched > words || report.printed > words || (report.punched + report.printed) * sizeof(RawWord) != words)
+        return;
+
+    result.run = report.run;
+    result.io = report.io;
+    result.finished = report.finished;
+    result.next_card = report.next_card;
+    result.punched.resize(report.punched);
+    result.printed.resize(report.printed);
+    std::byte const *const punched = child.output.data() + sizeof report;
+    std::memcpy(result.punched.data(), punched, report.punched * sizeof(RawWord));
+    std::memcpy(result.printed.data(), punched + report.punched * sizeof(RawWord), report.printed * sizeof(RawWord));
+}
+
+std::vector<JobResult> ForkServer::run(std::span<Job const> const jobs, std::stop_token const stop)
+{
+    std::vector<JobResult> results(jobs.size(), JobResult{.run = {.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0}, .io = {}, .punched = {}, .printed = {}});
+    std::vector<std::unique_ptr<Child>> children;
+    std::vector<pollfd> pipes;
+    size_t next = 0;
+    while (!stop.stop_requested() && (next < jobs.size() || !children.empty()))
+    {
+        // A job whose child cannot be forked is left unfinished
+        for (; next < jobs.size() && children.size() < max_children; next++)
+            if (std::unique_ptr<Child> child = start(next, jobs[next]))
+                children.push_back(std::move(child));
+        if (children.empty())
+            continue;
+
+        pipes.clear();
+        for (std::unique_ptr<Child> const &child : children)
+            pipes.push_back(pollfd{.fd = child->pipe, .events = POLLIN, .revents = 0});
+        if (poll(pipes.data(), pipes.size(), stop_poll_interval) < 0 && errno != EINTR)
+            break;
+        // From the back, so that finishing a child leaves the others where pipes has them
+        for (size_t i = children.size(); i-- > 0;)
+        {
+            if (pipes[i].revents == 0)
+                continue;
+            Child &child = *children[i];
+            std::byte buffer[4096];
+            ssize_t const count = read(child.pipe, buffer, sizeof buffer);
+            if (count > 0)
+                child.output.insert(child.output.end(), buffer, buffer + count);
+            else if (count == 0 || errno != EINTR)
+            {
+                finish(child, results[child.job]);
+                children.erase(children.begin() + std::ptrdiff_t(i));
+            }
+        }
+    }
+
+    for (std::unique_ptr<Child> const &child : children)
+    {
+        kill(child->pid, SIGKILL);
+        close(child->pipe);
+        while (waitpid(child->pid, nullptr, 0) < 0 && errno == EINTR)
+            ;
+    }
+    return results;
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
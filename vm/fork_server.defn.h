@@ -0,0 +1,66 @@
+#pragma once
+#include <base/base.h>
+#include <binary/reader.h>
+#include <vm/job_pool.defn.h>
+#include <vm/machine.decl.h>
+
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+#include <sys/types.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Runs each job in a child process of its own, forked from a machine that has the binary of the job loaded already.
+//
+// The server loads a binary, and decodes all of its cells, once for the jobs that run it, and each child inherits
+// the machine copy-on-write, so that a job starts from the warm machine at the cost of a fork and of copying the pages
+// that it writes. A child runs its job as JobPool does, and writes the result to a pipe, which the server reads
+// while the child runs, so that a child never blocks on a full pipe.
+// A job that crashes its child, or whose child is killed, only leaves its own result unfinished.
+// A job with a snapshot file has its child restore the file, on whatever the machine has loaded, and resume from it.
+//
+// Children are forked from the calling thread, so no other thread should be holding a lock, e.g. of the allocator,
+// that a child needs: a ForkServer does not run alongside a JobPool.
+class ForkServer
+{
+    // How long the server waits on its children before checking whether it was asked to stop, in milliseconds
+    static constexpr int stop_poll_interval = 50;
+
+    // A child that is running, and what it has written to its pipe so far
+    struct Child
+    {
+        pid_t pid;
+        int pipe;
+        size_t job;
+        std::vector<std::byte> output;
+    };
+
+    std::unique_ptr<Machine> machine;
+    // The binary that machine has loaded, which is kept so that it is not mistaken for another one
+    std::shared_ptr<BinaryImage const> binary;
+    size_t max_children;
+
+    // Forks a child that runs a job on the machine, which has its binary loaded, and writes the result to a pipe.
+    // Returns nullptr if the child could not be forked.
+    std::unique_ptr<Child> start(size_t index, Job const &job);
+
+    // Reads the result that a child wrote, once it has exited, into result, which is left unfinished
+    // if the child did not exit normally or did not write a whole result
+    static void finish(Child &child, JobResult &result);
+
+public:
+    // With as many children at a time as the host has hardware threads when max_children is 0
+    explicit ForkServer(size_t max_children = 0, DispatchEngine engine = DispatchEngine::jump_table);
+    ~ForkServer();
+
+    // Runs every job, returning the results in the order of the jobs.
+    // Once stop is requested, the children still running are killed, and their jobs and those not started yet are left unfinished.
+    std::vector<JobResult> run(std::span<Job const> jobs, std::stop_token stop = {});
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
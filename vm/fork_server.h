@@ -0,0 +1,2 @@
+#pragma once
+#include <vm/fork_server.defn.h>
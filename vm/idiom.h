@@ -0,0 +1,72 @@
+#pragma once
+#include <base/base.h>
+#include <vm/op_list.h>
+namespace mix
+{
+
+// An idiom is a loop that the predecoder recognises as a whole, so that the iterations that go round
+// run as one native fill, copy or scan over memory rather than one dispatch per instruction.
+// The loop starts at the cell that a jump at its end goes back to, and has one of the shapes
+//
+//     clear:   STZ A,i          copy:   LDr A,i           search:  CMPr A,i
+//              INCi s                   STr B,i                    JE   found
+//              Ji<cond> clear           INCi s                     INCi s
+//                                       Ji<cond> copy              Ji<cond> search
+//
+// where r is rA or rX, INCi s may also be DECi s, s is at least 1, the memory operands are full words (0:5),
+// and <cond> is any of the six conditions on rIi.
+//
+// Iterations that cannot go round whole, i.e. that exit the loop, trap, find the key or store into the loop,
+// run one instruction at a time, so that the machine ends up exactly as if the whole loop had.
+
+enum class IdiomKind : NativeByte
+{
+    clear,
+    copy,
+    search,
+};
+
+constexpr NativeByte max_idiom_length = 4;
+
+struct Idiom
+{
+    IdiomKind kind;
+    // Cells in the loop, including the jump back
+    NativeByte length;
+    // i of the index register that counts the loop
+    NativeByte index;
+    // Added to rIi once per iteration
+    NativeInt stride;
+    // F of the jump back, which picks the condition on rIi
+    NativeByte condition;
+    // A of the load, compare or STZ
+    NativeInt source;
+    // A of the store of a copy
+    NativeInt target;
+    // Whether a copy or search uses rX rather than rA
+    bool uses_rX;
+    // Execution time of an iteration that goes round
+    NativeByte cycles;
+};
+
+// Whether Ji<cond> jumps for a value of rIi, F of the jump picking the condition
+constexpr bool index_condition_holds(NativeByte condition, NativeInt value)
+{
+    switch (condition)
+    {
+    case 0:
+        return value < 0;
+    case 1:
+        return value == 0;
+    case 2:
+        return value > 0;
+    case 3:
+        return value >= 0;
+    case 4:
+        return value != 0;
+    default:
+        return value <= 0;
+    }
+}
+
+}
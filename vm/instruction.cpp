@@ -6,33 +6,38 @@
 
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
-Instruction::Instruction(Machine &m)
-    : Word(std::span<Byte, bytes_in_word>(m.memory.begin() + m.pc, bytes_in_word)), m(m)
-{}
-
-void Instruction::update_by_pc()
-{
-    std::copy_n(m.memory.begin() + m.pc, bytes_in_word, container.begin());
-}
-
-ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>> Instruction::native_A() const
+DecodedInstruction decode_instruction(PackedWord word)
 {
-    auto const [
-        s, 
-        b1, 
-        b2
-    ] = A();
-
-    return ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>>(
+    Sign const s = packed_sign(word);
+    ValidatedByte const b1 = packed_byte(word, 1);
+    ValidatedByte const b2 = packed_byte(word, 2);
+    ValidatedByte const I = packed_byte(word, 3);
+    ValidatedByte const F = packed_byte(word, 4);
+    ValidatedByte const C = packed_byte(word, 5);
+    ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>> const A(
         (
             (
                 to_interval(b1) * to_interval(validated_byte_size)
             ) + to_interval(b2)
         ) * ValidatedUtils::from_sign(s)
     );
+    return DecodedInstruction{
+        .handler = verified_handler(decode_handler(C, F, I), ValidatedAddress::constructor(A).is_success(), packed_fields[F].valid),
+        .cycles = std::uint8_t(execution_time(C, F)),
+        .instructions = 1,
+        .raw_A = std::int16_t(A),
+        .raw_I = std::uint8_t(I),
+        .raw_F = std::uint8_t(F),
+        .raw_sign = std::uint8_t(s),
+    };
 }
 
+Instruction::Instruction(Machine &m)
+    : m(m)
+{}
+
 Result<ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>>> Instruction::native_I_value_or_zero() const
 {
     return I().transform_value([&m = this->m](ValidatedIValue idx) {
@@ -58,36 +63,5 @@ Result<ValidatedAddress> Instruction::native_M() const
     return ValidatedAddress::constructor(base_address + offset.value());
 }
 
-Result<Word<OwnershipKind::mutable_view>> Instruction::M_value() const
-{
-    using ResultType = Result<Word<OwnershipKind::mutable_view>>;
-    Result<ValidatedAddress> const address = native_M();
-    if (!address) { return ResultType::failure(); }
-    return ResultType::success(m.get_memory_word(address.value()));
-}
-
-// (L:R) is 8L + R
-FieldSpec Instruction::field_spec() const
-{
-    NativeByte const field = F();
-    return FieldSpec::from_byte(field);
-}
-
-Result<SliceMutable> Instruction::MF() const
-{
-    using ResultType = Result<SliceMutable>;
-    Result<Word<OwnershipKind::mutable_view>> const value_at_address_M = M_value();
-    if (!value_at_address_M)
-        return ResultType::failure();
-    return ResultType::success(SliceMutable(value_at_address_M.value(), field_spec()));
-}
-
-Result<ValidatedWord> Instruction::native_MF() const
-{
-    using ResultType = Result<ValidatedWord>;
-    return MF().transform_value([](SliceMutable slice){
-        return ValidatedWord::constructor(slice.native_value());
-    });
-}
-
+MIX_END_BYTE_SIZE_NAMESPACE
 }
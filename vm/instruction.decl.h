@@ -1,7 +1,11 @@
 #pragma once
+#include <config.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
+struct DecodedInstruction;
 struct Instruction;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
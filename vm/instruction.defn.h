@@ -4,51 +4,125 @@
 #include <base/validation/v2.h>
 #include <vm/instruction.decl.h>
 #include <vm/machine.decl.h>
+#include <vm/op_list.h>
+#include <vm/packed_word.h>
+#include <vm/superinstruction.h>
+
+#include <cstdint>
+#include <limits>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
-struct Instruction : public Word<OwnershipKind::owns>
+// An instruction word split into its parts once,
+// so that executing it again does not need to re-decode it.
+// Machine keeps one for every cell of memory, so the parts are stored in the narrowest types that hold them,
+// and handed out as validated values.
+struct DecodedInstruction
 {
-    Machine &m;
-    Instruction(Machine &m);
-
-    void update_by_pc();
+    OpHandler handler = h_undecoded;
+    // Execution time in units of u
+    std::uint8_t cycles = 0;
+    // Instructions that the decoded instruction stands for, more than 1 for a superinstruction (see vm/superinstruction.h)
+    std::uint8_t instructions = 0;
+    std::int16_t raw_A = 0;
+    std::uint8_t raw_I = 0;
+    std::uint8_t raw_F = 0;
+    std::uint8_t raw_sign = s_plus;
 
     Sign sign() const
     {
-        return container[0].sign;
+        return Sign(raw_sign);
     }
 
-    std::tuple<Sign, ValidatedByte, ValidatedByte> A() const
+    ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>> A() const
     {
-        return { container[0].sign, container[1].byte, container[2].byte };
+        // Rebuilt as decode_instruction builds it, since the bounds of the type are more than its validator admits
+        auto const [sign, magnitude] = ValidatedUtils::from_abs(raw_A);
+        return ValidatedUtils::from_mod<lut[2]>(magnitude) * ValidatedUtils::from_sign(sign);
     }
 
-    Result<ValidatedIValue> I() const
+    // A as an address, which is M whenever I is 0
+    Result<ValidatedAddress> direct_M() const
     {
-        return ValidatedIValue::constructor(container[3].byte);
+        return ValidatedAddress::constructor(raw_A);
     }
 
-    // Returns *M, where * represents dereferencing
-    Result<Word<OwnershipKind::mutable_view>> M_value() const;
+    Result<ValidatedIValue> I() const
+    {
+        return ValidatedIValue::constructor(raw_I);
+    }
 
     ValidatedByte F() const
     {
-        return container[4].byte;
+        return ValidatedByte::trusted_constructor(raw_F).value();
     }
 
-    // Returns M(F)
-    Result<SliceMutable> MF() const;
+    // How to reach the field (L:R) given by F
+    PackedField const &field() const
+    {
+        return packed_fields[raw_F];
+    }
+};
 
-    ValidatedByte C() const
+static_assert(sizeof(DecodedInstruction) <= 16);
+static_assert(lut[2] - 1 <= std::numeric_limits<std::int16_t>::max() && byte_size - 1 <= std::numeric_limits<std::uint8_t>::max());
+// The longest execution time is that of a MOVE of byte_size - 1 words, which a superinstruction can only end with
+static_assert(execution_time(op_move, byte_size - 1) + (max_superinstruction_length - 1) * execution_time(op_div, 0)
+    <= std::numeric_limits<std::uint8_t>::max());
+
+DecodedInstruction decode_instruction(PackedWord word);
+
+struct Instruction
+{
+    Machine &m;
+    DecodedInstruction const *decoded = nullptr;
+    Instruction(Machine &m);
+
+    OpHandler handler() const
     {
-        return container[5].byte;
+        return decoded->handler;
     }
 
-    // Extracts and returns L and R from F()
-    FieldSpec field_spec() const;
+    NativeByte cycles() const
+    {
+        return decoded->cycles;
+    }
 
-    ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>> native_A() const;
+    NativeByte instructions() const
+    {
+        return decoded->instructions;
+    }
+
+    Sign sign() const
+    {
+        return decoded->sign();
+    }
+
+    Result<ValidatedIValue> I() const
+    {
+        return decoded->I();
+    }
+
+    ValidatedByte F() const
+    {
+        return decoded->F();
+    }
+
+    // Returns how to reach the field (L:R) given by F()
+    template <Addressing addressing>
+    [[gnu::always_inline]] inline
+    PackedField const &field() const;
+
+    // Whether F() is a field (L:R), which only an indexed variant has to check (see verified_handler)
+    template <Addressing addressing>
+    [[gnu::always_inline]] inline
+    bool has_valid_field() const;
+
+    ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>> native_A() const
+    {
+        return decoded->A();
+    }
 
     // Returns rIi, where i is the value of I()
     Result<ValidatedInt<IsInClosedInterval<-(lut[2] - 1), lut[2] - 1>>> native_I_value_or_zero() const;
@@ -56,11 +130,21 @@ struct Instruction : public Word<OwnershipKind::owns>
     // Returns M = A + rIi
     Result<ValidatedAddress> native_M() const;
 
+    // Same as native_M(), but unindexed addressing reuses the M found while decoding, which is then an address
+    template <Addressing addressing>
+    [[gnu::always_inline]] inline
+    Result<ValidatedAddress> native_M() const;
+
     // Returns native value of M(F)
+    template <Addressing addressing>
+    [[gnu::always_inline]] inline
     Result<ValidatedWord> native_MF() const;
+
     // Same as native M(F)
-    [[gnu::flatten]]
-    Result<ValidatedWord> native_V() const { return native_MF(); }
+    template <Addressing addressing>
+    [[gnu::always_inline]] inline
+    Result<ValidatedWord> native_V() const { return native_MF<addressing>(); }
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
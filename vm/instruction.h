@@ -1,2 +1,2 @@
 #pragma once
-#include <vm/instruction.defn.h>
+#include <vm/instruction.impl.h>
@@ -0,0 +1,51 @@
+#pragma once
+#include <base/base.h>
+#include <vm/instruction.defn.h>
+#include <vm/machine.defn.h>
+#include <vm/memory.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+template <Addressing addressing>
+PackedField const &Instruction::field() const
+{
+    if constexpr (is_full_word(addressing))
+        return packed_fields[full_word_field];
+    else
+        return decoded->field();
+}
+
+template <Addressing addressing>
+bool Instruction::has_valid_field() const
+{
+    if constexpr (is_indexed(addressing) && !is_full_word(addressing))
+        return decoded->field().valid;
+    else
+        return true;
+}
+
+template <Addressing addressing>
+Result<ValidatedAddress> Instruction::native_M() const
+{
+    if constexpr (is_indexed(addressing))
+        return native_M();
+    else
+        return ValidatedAddress::trusted_constructor(decoded->raw_A);
+}
+
+template <Addressing addressing>
+Result<ValidatedWord> Instruction::native_MF() const
+{
+    using ResultType = Result<ValidatedWord>;
+    if (!has_valid_field<addressing>())
+        return ResultType::failure();
+    PackedField const &field = this->field<addressing>();
+    return native_M<addressing>().transform_value([&m = this->m, &field](ValidatedAddress address){
+        // A field of a word is itself a word
+        return ValidatedWord::trusted_constructor(packed_field_value(m.memory.load(address), field));
+    });
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
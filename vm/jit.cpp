@@ -0,0 +1,900 @@
+#include <base/base.h>
+#include <vm/jit.h>
+#include <vm/machine.h>
+#include <vm/x86_64_emitter.h>
+
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <sys/mman.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+using Emitter = X86_64Emitter;
+
+// INC, DEC, ENT and ENN follow each other for rA, rI1 to rI6 and rX in turn, each with a direct and an indexed variant
+enum AddressTransfer : NativeByte
+{
+    at_inc,
+    at_dec,
+    at_ent,
+    at_enn,
+};
+
+constexpr OpHandler address_transfer_handler(NativeByte reg, AddressTransfer kind)
+{
+    return OpHandler(h_inca_direct + 2 * (4 * reg + kind));
+}
+
+static_assert(address_transfer_handler(1, at_dec) == h_dec1_direct);
+static_assert(address_transfer_handler(7, at_enn) == h_ennx_direct);
+
+// Likewise JrN, JrZ, JrP, JrNN, JrNZ and JrNP, in the order of their F
+constexpr OpHandler register_jump_handler(NativeByte reg, NativeByte F)
+{
+    return OpHandler(h_jan_direct + 2 * (6 * reg + F));
+}
+
+static_assert(register_jump_handler(1, 2) == h_j1p_direct);
+static_assert(register_jump_handler(7, 5) == h_jxnp_direct);
+
+// Whether a jump on a register is taken when the register is zero, positive or negative
+struct RegisterJumpCondition
+{
+    bool zero;
+    bool plus;
+    bool minus;
+};
+
+constexpr RegisterJumpCondition register_jump_conditions[] = {
+    {.zero = false, .plus = false, .minus = true}, // N
+    {.zero = true, .plus = false, .minus = false}, // Z
+    {.zero = false, .plus = true, .minus = false}, // P
+    {.zero = true, .plus = true, .minus = false}, // NN
+    {.zero = false, .plus = true, .minus = true}, // NZ
+    {.zero = true, .plus = false, .minus = true}, // NP
+};
+
+// Whether the instruction may be followed by anything but the next one, or stop the run
+constexpr bool ends_block(OpHandler handler)
+{
+    return (handler >= h_jbus_direct && handler <= h_jxnp_indexed) || handler == h_hlt;
+}
+
+// Loads, stores, comparisons, ADD and SUB reach their field in place with shifts and masks, in either memory layout,
+// when the numerical bytes of a word are its native magnitude in the packed form
+constexpr bool inline_fields = packed_magnitude_is_native;
+
+// The handlers of ops that read or write a field come four to an op (see OP_VARIANTS_MF), and the ops one register after another:
+// LDr, LDrN, STr (for rA, rI1 to rI6, rX, rJ and rZ) and CMPr, each in the order of Machine::RegisterIdx
+constexpr NativeByte field_variants = 4;
+static_assert(h_ldxn_indexed - h_lda_direct_full + 1 == 16 * field_variants);
+static_assert(h_stz_indexed - h_sta_direct_full + 1 == 10 * field_variants);
+static_assert(h_cmpx_indexed - h_cmpa_direct_full + 1 == 8 * field_variants);
+static_assert(h_sub_direct_full - h_add_direct_full == h_sub_indexed - h_add_indexed);
+
+// Bytes from one word of memory to the next
+constexpr std::int32_t word_stride = packed_memory ? sizeof(PackedWord) : bytes_in_word * sizeof(Byte);
+
+// With ByteMemory, each numerical byte of a word is a native integer, and the sign a Sign, at the start of its Byte
+static_assert(packed_memory || sizeof(Memory) == main_memory_size * bytes_in_word * sizeof(Byte));
+static_assert(!packed_memory || sizeof(Memory) == main_memory_size * sizeof(PackedWord));
+static_assert(sizeof(Byte) == sizeof(NativeInt) && sizeof(ValidatedByte) == sizeof(NativeInt) && sizeof(Sign) == sizeof(std::uint32_t));
+
+// CMP stores the comparison indicator as the -1, 0 or 1 that it is made of
+static_assert(sizeof(std::strong_ordering) == 1);
+static_assert(std::bit_cast<std::int8_t>(std::strong_ordering::less) == -1 && std::bit_cast<std::int8_t>(std::strong_ordering::equal) == 0
+              && std::bit_cast<std::int8_t>(std::strong_ordering::greater) == 1);
+
+// How JL, JE, JG, JGE, JNE and JLE, in the order of their F, test the comparison indicator against 0
+constexpr X86_64Emitter::Condition comparison_jump_conditions[] = {
+    X86_64Emitter::c_less,
+    X86_64Emitter::c_equal,
+    X86_64Emitter::c_greater,
+    X86_64Emitter::c_greater_or_equal,
+    X86_64Emitter::c_not_equal,
+    X86_64Emitter::c_less_or_equal,
+};
+static_assert(h_jle_direct - h_jl_direct == 2 * 5);
+
+constexpr std::int32_t budget_offset = offsetof(Jit::Counters, budget);
+constexpr std::int32_t cycles_offset = offsetof(Jit::Counters, cycles);
+
+}
+
+Jit::Jit(Machine &m)
+    : m(m)
+{
+    static_assert(sizeof(NumberRegister::Magnitude) == sizeof(NativeInt) && sizeof(IndexRegister::Magnitude) == sizeof(NativeInt));
+    pc_offset = offset_of(&m.pc);
+    decoded_offset = offset_of(&m.inst.decoded);
+    overflow_offset = offset_of(&m.overflow);
+    trap_code_offset = offset_of(&m.trap_record.code);
+    rJ_magnitude_offset = offset_of(&m.rJ.magnitude_);
+    memory_offset = offset_of(&m.memory);
+    comparison_offset = offset_of(&m.comparison);
+    dirty_cells_offset = offset_of(&m.dirty_cells);
+    decoded_instructions_offset = offset_of(&m.decoded_instructions);
+    translated_cells_offset = std::int32_t(reinterpret_cast<std::byte const *>(&translated_cells) - reinterpret_cast<std::byte const *>(&counters));
+    sign_offsets[0] = offset_of(&m.rA.sign_);
+    magnitude_offsets[0] = offset_of(&m.rA.magnitude_);
+    for (size_t i = 1; i <= m.index_registers.size(); i++)
+    {
+        sign_offsets[i] = offset_of(&m.index_registers[i - 1].sign_);
+        magnitude_offsets[i] = offset_of(&m.index_registers[i - 1].magnitude_);
+    }
+    sign_offsets[7] = offset_of(&m.rX.sign_);
+    magnitude_offsets[7] = offset_of(&m.rX.magnitude_);
+
+    if constexpr (jit_supported)
+    {
+        void *const buffer = mmap(nullptr, code_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer != MAP_FAILED)
+        {
+            code = static_cast<std::uint8_t *>(buffer);
+            emit_trampolines();
+            // A host that does not let mapped memory become executable gets no JIT
+            if (mprotect(code, code_buffer_size, PROT_READ | PROT_EXEC) == 0)
+                executable = true;
+            else
+            {
+                munmap(code, code_buffer_size);
+                code = nullptr;
+            }
+        }
+    }
+}
+
+Jit::~Jit()
+{
+    if (code != nullptr)
+        munmap(code, code_buffer_size);
+}
+
+std::int32_t Jit::offset_of(void const *member) const
+{
+    return std::int32_t(static_cast<std::byte const *>(member) - reinterpret_cast<std::byte const *>(&m));
+}
+
+void Jit::set_executable(bool const to_executable)
+{
+    if (executable == to_executable)
+        return;
+    mprotect(code, code_buffer_size, to_executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE);
+    executable = to_executable;
+}
+
+JitStatus Jit::note_store(Machine &m, NativeByte const address)
+{
+    m.invalidate_decoded_instruction(ValidatedAddress::trusted_constructor(address).value());
+    return m.translated_code_invalidated ? JitStatus::leave : JitStatus::next;
+}
+
+// Translated code runs with the Machine in rbx and the Counters in r12, and jumps from block to block without using the stack,
+// so leaving it from anywhere is a matter of popping what enter pushed.
+void Jit::emit_trampolines()
+{
+    Emitter e(code);
+    enter = reinterpret_cast<EnterFunction>(e.position());
+    e.push_rbx();
+    e.push_r12();
+    // Keeps the stack 16-byte aligned for the handlers that blocks call
+    e.sub_rsp(8);
+    e.mov_rbx_rdi();
+    e.mov_r12_rsi();
+    e.jmp(Emitter::rdx);
+
+    exit_trap = e.position();
+    e.mov_eax_imm(NativeByte(JitStatus::trap));
+    Emitter::JumpSite const to_epilogue = e.jmp();
+
+    exit_next = e.position();
+    e.mov_eax_imm(NativeByte(JitStatus::next));
+    e.bind(to_epilogue);
+    e.add_rsp(8);
+    e.pop_r12();
+    e.pop_rbx();
+    e.ret();
+
+    first_block = code_cursor = e.position();
+}
+
+void Jit::flush()
+{
+    translated.clear();
+    blocks.fill(nullptr);
+    for (std::vector<Block *> &blocks_here : spanning)
+        blocks_here.clear();
+    translated_cells.fill(0);
+    for (std::vector<std::uint8_t *> &links : pending_links)
+        links.clear();
+    code_cursor = first_block;
+}
+
+Jit::Block *Jit::block_at(NativeByte address)
+{
+    if (address >= main_memory_size || m.breakpoints[address])
+        return nullptr;
+    if (blocks[address] != nullptr) [[likely]]
+        return blocks[address];
+    return translate(address);
+}
+
+Jit::Block *Jit::translate(NativeByte const start)
+{
+    if (interpreted[start])
+        return nullptr;
+    set_executable(false);
+
+    auto block = std::make_unique<Block>();
+    block->start = start;
+    block->decoded.reserve(max_block_length);
+    for (NativeByte address = start; address < main_memory_size && block->decoded.size() < max_block_length; address++)
+    {
+        if (address != start && (interpreted[address] || m.breakpoints[address]))
+            break;
+        DecodedInstruction const decoded = decode_instruction(m.memory.load(ValidatedAddress::trusted_constructor(address).value()));
+        if (decoded.handler == h_invalid)
+            break;
+        block->decoded.push_back(decoded);
+        if (ends_block(decoded.handler))
+            break;
+    }
+    if (block->decoded.empty())
+        return nullptr;
+    NativeByte const length = block->length = NativeByte(block->decoded.size());
+
+    if (size_t(code + code_buffer_size - code_cursor) < (length + 1) * max_code_per_instruction)
+        flush();
+
+    // Execution time of the instructions before each one
+    std::array<size_t, max_block_length + 1> cycles_before;
+    cycles_before[0] = 0;
+    for (NativeByte k = 0; k < length; k++)
+        cycles_before[k + 1] = cycles_before[k] + block->decoded[k].cycles;
+    size_t const cycles = cycles_before[length];
+
+    Emitter e(code_cursor);
+
+    // Jumps to target, straight into its block once there is one
+    auto const emit_link = [&](NativeByte const target)
+    {
+        e.mov(Emitter::w32, Emitter::base_rbx, pc_offset, target);
+        Emitter::JumpSite const site = e.jmp();
+        if (target >= main_memory_size)
+            Emitter::patch(site, exit_next);
+        else if (blocks[target] != nullptr)
+        {
+            Emitter::patch(site, blocks[target]->entry);
+            blocks[target]->incoming.push_back(site);
+        }
+        else
+        {
+            Emitter::patch(site, exit_next);
+            pending_links[target].push_back(site);
+        }
+    };
+
+    // Gives back the budget and time of the instructions after the first `completed` ones
+    auto const emit_unwind = [&](NativeByte const completed)
+    {
+        if (completed != length)
+        {
+            e.add(Emitter::base_r12, budget_offset, length - completed);
+            e.sub(Emitter::base_r12, cycles_offset, std::uint32_t(cycles - cycles_before[completed]));
+        }
+    };
+
+    // Ways out of the block before its end, emitted after it
+    struct SideExit
+    {
+        Emitter::JumpSite site;
+        NativeByte index;
+        // Whether al holds the JitStatus of a handler, and otherwise the instruction has trapped
+        bool from_handler;
+        // The trap, when the exit still has to record it
+        std::optional<TrapCode> trap;
+    };
+    std::vector<SideExit> side_exits;
+
+    // rax = value of register reg
+    auto const emit_register_value = [&](NativeByte const reg)
+    {
+        e.mov(Emitter::w64, Emitter::rax, Emitter::base_rbx, magnitude_offsets[reg]);
+        e.mov(Emitter::w32, Emitter::rcx, Emitter::base_rbx, sign_offsets[reg]);
+        e.test(Emitter::rcx, Emitter::rcx);
+        Emitter::JumpSite const is_plus = e.jcc(Emitter::c_equal);
+        e.neg(Emitter::rax);
+        e.bind(is_plus);
+    };
+
+    // Loads the value in rax into register reg as Register::load does, for instruction k.
+    // The value must be less than twice the register's range in magnitude, as the sum of two values that fit is.
+    // An overflow sets the overflow toggle, or traps for an index register.
+    auto const emit_store_sum = [&](NativeByte const reg, NativeByte const k)
+    {
+        bool const is_index_register = reg != 0 && reg != 7;
+        std::int32_t const sign = sign_offsets[reg];
+        std::int32_t const magnitude = magnitude_offsets[reg];
+        // rdx = -1 if negative and 0 otherwise, rax = |rax|
+        e.mov(Emitter::rdx, Emitter::rax);
+        e.sar(Emitter::rdx, 63);
+        e.xor_(Emitter::rax, Emitter::rdx);
+        e.sub(Emitter::rax, Emitter::rdx);
+        e.mov(Emitter::rcx, std::uint64_t(is_index_register ? lut[2] : lut[numerical_bytes_in_word]));
+        e.cmp(Emitter::rax, Emitter::rcx);
+        Emitter::JumpSite const fits = e.jcc(Emitter::c_below);
+        e.sub(Emitter::rax, Emitter::rcx);
+        if (is_index_register)
+        {
+            // Loaded all the same, then trapped
+            e.mov(Emitter::w64, Emitter::base_rbx, magnitude, Emitter::rax);
+            e.and_32(Emitter::rdx, 1);
+            e.mov(Emitter::w32, Emitter::base_rbx, sign, Emitter::rdx);
+            e.mov(Emitter::w32, Emitter::base_rbx, trap_code_offset, NativeByte(TrapCode::index_overflow));
+            e.mov(Emitter::w32, Emitter::base_rbx, pc_offset, start + k);
+            e.mov(Emitter::rax, reinterpret_cast<std::uint64_t>(&block->decoded[k]));
+            e.mov(Emitter::w64, Emitter::base_rbx, decoded_offset, Emitter::rax);
+            side_exits.push_back({.site = e.jmp(), .index = k, .from_handler = false, .trap = std::nullopt});
+        }
+        else
+            e.mov(Emitter::w8, Emitter::base_rbx, overflow_offset, 1);
+        e.bind(fits);
+        e.mov(Emitter::w64, Emitter::base_rbx, magnitude, Emitter::rax);
+        e.and_32(Emitter::rdx, 1);
+        e.mov(Emitter::w32, Emitter::base_rbx, sign, Emitter::rdx);
+    };
+
+    // Where translated code finds M: known when the block is translated,
+    // or else worked out into rsi from rIi, with rdi = M * word_stride to reach its word in memory
+    struct Operand
+    {
+        bool known;
+        NativeByte M;
+    };
+
+    // Returns the operand of instruction k, or nullopt, having emitted nothing, if its handler has to be called
+    // since I is not an index or, with I = 0, M is not an address. An indexed M that is not an address traps.
+    auto const emit_operand = [&](NativeByte const k) -> std::optional<Operand>
+    {
+        DecodedInstruction const &d = block->decoded[k];
+        if (!d.I())
+            return std::nullopt;
+        NativeByte const I = NativeByte(d.I().value());
+        if (I == 0)
+        {
+            if (!d.direct_M())
+                return std::nullopt;
+            return Operand{.known = true, .M = NativeByte(d.direct_M().value())};
+        }
+        e.mov(Emitter::w64, Emitter::rsi, Emitter::base_rbx, magnitude_offsets[I]);
+        e.mov(Emitter::w32, Emitter::rcx, Emitter::base_rbx, sign_offsets[I]);
+        e.test(Emitter::rcx, Emitter::rcx);
+        Emitter::JumpSite const is_plus = e.jcc(Emitter::c_equal);
+        e.neg(Emitter::rsi);
+        e.bind(is_plus);
+        e.add(Emitter::rsi, d.raw_A);
+        // Negative addresses are above every address when compared unsigned
+        e.cmp(Emitter::rsi, std::int32_t(main_memory_size));
+        side_exits.push_back({.site = e.jcc(Emitter::c_above_or_equal), .index = k, .from_handler = false, .trap = TrapCode::invalid_address});
+        e.imul(Emitter::rdi, Emitter::rsi, word_stride);
+        return Operand{.known = false, .M = 0};
+    };
+
+    // reg = the part of the operand's word in memory that starts disp bytes into it, and the other way round
+    auto const emit_load_memory = [&](Emitter::Width const width, Emitter::Reg const reg, Operand const &operand, std::int32_t const disp)
+    {
+        if (operand.known)
+            e.mov(width, reg, Emitter::base_rbx, memory_offset + std::int32_t(operand.M) * word_stride + disp);
+        else
+            e.mov(width, reg, Emitter::base_rbx, Emitter::rdi, memory_offset + disp);
+    };
+    auto const emit_store_memory = [&](Emitter::Width const width, Operand const &operand, std::int32_t const disp, Emitter::Reg const reg)
+    {
+        if (operand.known)
+            e.mov(width, Emitter::base_rbx, memory_offset + std::int32_t(operand.M) * word_stride + disp, reg);
+        else
+            e.mov(width, Emitter::base_rbx, Emitter::rdi, memory_offset + disp, reg);
+    };
+
+    // rax = the magnitude of the field F of the operand's word, rdx = its sign, or s_plus when the field has none
+    auto const emit_load_field = [&](Operand const &operand, NativeByte const F)
+    {
+        PackedField const &field = packed_fields[F];
+        if constexpr (packed_memory)
+        {
+            emit_load_memory(Emitter::w64, Emitter::rax, operand, 0);
+            if (field.has_sign)
+            {
+                e.mov(Emitter::rdx, Emitter::rax);
+                e.shr(Emitter::rdx, 63);
+            }
+            else
+                e.mov(Emitter::rdx, std::uint64_t(s_plus));
+            if (field.shift != 0)
+                e.shr(Emitter::rax, std::uint8_t(field.shift));
+            e.mov(Emitter::rcx, field.magnitude_mask);
+            e.and_(Emitter::rax, Emitter::rcx);
+        }
+        else
+        {
+            NativeByte const first = std::max<NativeByte>(F / 8, 1);
+            NativeByte const R = F % 8;
+            if (first > R)
+                e.mov(Emitter::rax, std::uint64_t(0));
+            for (NativeByte i = first; i <= R; i++)
+            {
+                if (i == first)
+                {
+                    emit_load_memory(Emitter::w64, Emitter::rax, operand, std::int32_t(i * sizeof(Byte)));
+                    continue;
+                }
+                e.shl(Emitter::rax, std::uint8_t(packed_byte_bits));
+                emit_load_memory(Emitter::w64, Emitter::rcx, operand, std::int32_t(i * sizeof(Byte)));
+                e.or_(Emitter::rax, Emitter::rcx);
+            }
+            if (field.has_sign)
+                emit_load_memory(Emitter::w32, Emitter::rdx, operand, 0);
+            else
+                e.mov(Emitter::rdx, std::uint64_t(s_plus));
+        }
+    };
+
+    // Negates value if sign is s_minus
+    auto const emit_apply_sign = [&](Emitter::Reg const value, Emitter::Reg const sign)
+    {
+        e.test(sign, sign);
+        Emitter::JumpSite const is_plus = e.jcc(Emitter::c_equal);
+        e.neg(value);
+        e.bind(is_plus);
+    };
+
+    // Stores the field F of the word whose magnitude is in rax and sign in rdx into the operand's word, as packed_store_field does
+    auto const emit_store_field = [&](Operand const &operand, NativeByte const F)
+    {
+        PackedField const &field = packed_fields[F];
+        if constexpr (packed_memory)
+        {
+            if (field.shift != 0)
+                e.shl(Emitter::rax, std::uint8_t(field.shift));
+            if (field.has_sign)
+            {
+                e.shl(Emitter::rdx, 63);
+                e.or_(Emitter::rax, Emitter::rdx);
+            }
+            e.mov(Emitter::rdx, field.store_mask);
+            e.and_(Emitter::rax, Emitter::rdx);
+            e.mov(Emitter::rdx, ~field.store_mask);
+            emit_load_memory(Emitter::w64, Emitter::rcx, operand, 0);
+            e.and_(Emitter::rcx, Emitter::rdx);
+            e.or_(Emitter::rcx, Emitter::rax);
+            emit_store_memory(Emitter::w64, operand, 0, Emitter::rcx);
+        }
+        else
+        {
+            NativeByte const first = std::max<NativeByte>(F / 8, 1);
+            for (NativeByte i = F % 8; i >= first; i--)
+            {
+                e.mov(Emitter::rcx, Emitter::rax);
+                e.and_(Emitter::rcx, std::int32_t(byte_size - 1));
+                emit_store_memory(Emitter::w64, operand, std::int32_t(i * sizeof(Byte)), Emitter::rcx);
+                if (i > first)
+                    e.shr(Emitter::rax, std::uint8_t(packed_byte_bits));
+            }
+            if (field.has_sign)
+                emit_store_memory(Emitter::w32, operand, 0, Emitter::rdx);
+        }
+    };
+
+    // Does what invalidate_decoded_instruction does for the operand of the store at instruction k, which is done.
+    // Only the dirty bit is set in place: a cell that has been decoded, is part of a superinstruction or is translated
+    // calls note_store, which is rare since data is seldom executed.
+    auto const emit_note_store = [&](Operand const &operand, NativeByte const k)
+    {
+        constexpr NativeByte superinstruction_cells = superinstruction_count > 0 ? max_superinstruction_length : 1;
+        constexpr std::int32_t decoded_size = sizeof(DecodedInstruction);
+        std::vector<Emitter::JumpSite> to_note;
+        if (operand.known)
+        {
+            e.bts(Emitter::base_rbx, dirty_cells_offset + std::int32_t(operand.M / 64 * sizeof(std::uint64_t)), std::uint8_t(operand.M % 64));
+            for (NativeByte before = 0; before < superinstruction_cells && before <= operand.M; before++)
+            {
+                e.cmp(Emitter::w16, Emitter::base_rbx, decoded_instructions_offset + std::int32_t(operand.M - before) * decoded_size, h_undecoded);
+                to_note.push_back(e.jcc(Emitter::c_not_equal));
+            }
+            e.cmp(Emitter::w8, Emitter::base_r12, translated_cells_offset + std::int32_t(operand.M), 0);
+            to_note.push_back(e.jcc(Emitter::c_not_equal));
+        }
+        else
+        {
+            e.bts(Emitter::base_rbx, dirty_cells_offset, Emitter::rsi);
+            e.imul(Emitter::rdx, Emitter::rsi, decoded_size);
+            // Cells before the start of memory are read from the members before decoded_instructions,
+            // which at worst calls note_store for nothing
+            for (NativeByte before = 0; before < superinstruction_cells; before++)
+            {
+                e.cmp(Emitter::w16, Emitter::base_rbx, Emitter::rdx, decoded_instructions_offset - before * decoded_size, h_undecoded);
+                to_note.push_back(e.jcc(Emitter::c_not_equal));
+            }
+            e.cmp(Emitter::w8, Emitter::base_r12, Emitter::rsi, translated_cells_offset, 0);
+            to_note.push_back(e.jcc(Emitter::c_not_equal));
+        }
+        Emitter::JumpSite const done = e.jmp();
+        for (Emitter::JumpSite const site : to_note)
+            e.bind(site);
+        e.mov(Emitter::w32, Emitter::base_rbx, pc_offset, start + k + 1);
+        e.mov(Emitter::rdi, Emitter::rbx);
+        if (operand.known)
+            e.mov(Emitter::rsi, std::uint64_t(operand.M));
+        e.mov(Emitter::rax, reinterpret_cast<std::uint64_t>(&note_store));
+        e.call(Emitter::rax);
+        e.cmp_al(std::uint8_t(JitStatus::next));
+        side_exits.push_back({.site = e.jcc(Emitter::c_not_equal), .index = k, .from_handler = true, .trap = std::nullopt});
+        e.bind(done);
+    };
+
+    // The block only runs if it fits in what is left of the budget, and otherwise goes back to the dispatcher with pc at start
+    block->entry = e.position();
+    e.cmp(Emitter::w64, Emitter::base_r12, budget_offset, length);
+    Emitter::patch(e.jcc(Emitter::c_below), exit_next);
+    e.sub(Emitter::base_r12, budget_offset, length);
+    e.add(Emitter::base_r12, cycles_offset, std::uint32_t(cycles));
+
+    bool linked = false;
+    for (NativeByte k = 0; k < length; k++)
+    {
+        DecodedInstruction const &d = block->decoded[k];
+        NativeByte const address = start + k;
+        bool const direct = d.I() && d.I().value() == 0;
+        std::optional<NativeByte> const M = direct && d.direct_M() ? std::optional<NativeByte>(NativeByte(d.direct_M().value())) : std::nullopt;
+        NativeByte const handler_offset = d.handler - h_inca_direct;
+        NativeByte const jump_offset = d.handler - h_jan_direct;
+        PackedField const &field = d.field();
+        // Numerical bytes of the field
+        NativeByte const field_bytes = field.valid ? d.raw_F % 8 + 1 - std::max<NativeByte>(d.raw_F / 8, 1) : 0;
+
+        if (d.handler >= h_inca_direct && d.handler <= h_ennx_indexed)
+        {
+            std::optional<Operand> const operand = emit_operand(k);
+            if (operand)
+            {
+                NativeByte const reg = handler_offset / 8;
+                AddressTransfer const kind = AddressTransfer(handler_offset / 2 % 4);
+                std::int32_t const sign = sign_offsets[reg];
+                std::int32_t const magnitude = magnitude_offsets[reg];
+                // An M of 0 takes the sign of the instruction, so that -0 can be entered
+                Sign const zero_sign = kind == at_ent ? d.sign() : -d.sign();
+                Sign const value_sign = kind == at_enn ? s_minus : s_plus;
+                if ((kind == at_ent || kind == at_enn) && operand->known)
+                {
+                    e.mov(Emitter::w32, Emitter::base_rbx, sign, operand->M == 0 ? zero_sign : value_sign);
+                    e.mov(Emitter::w64, Emitter::base_rbx, magnitude, operand->M);
+                }
+                else if (kind == at_ent || kind == at_enn)
+                {
+                    e.mov(Emitter::w64, Emitter::base_rbx, magnitude, Emitter::rsi);
+                    e.mov(Emitter::w32, Emitter::base_rbx, sign, value_sign);
+                    e.test(Emitter::rsi, Emitter::rsi);
+                    Emitter::JumpSite const is_nonzero = e.jcc(Emitter::c_not_equal);
+                    e.mov(Emitter::w32, Emitter::base_rbx, sign, zero_sign);
+                    e.bind(is_nonzero);
+                }
+                else
+                {
+                    emit_register_value(reg);
+                    if (operand->known)
+                        e.add(Emitter::rax, kind == at_inc ? NativeInt(operand->M) : -NativeInt(operand->M));
+                    else if (kind == at_inc)
+                        e.add(Emitter::rax, Emitter::rsi);
+                    else
+                        e.sub(Emitter::rax, Emitter::rsi);
+                    emit_store_sum(reg, k);
+                }
+                continue;
+            }
+        }
+
+        if (inline_fields && field.valid && d.handler >= h_lda_direct_full && d.handler <= h_ldxn_indexed)
+        {
+            NativeByte const op = (d.handler - h_lda_direct_full) / field_variants;
+            NativeByte const reg = op % 8;
+            bool const is_index_register = reg != 0 && reg != 7;
+            // A field of more than 2 bytes may not fit in an index register, which then traps
+            std::optional<Operand> const operand = !is_index_register || field_bytes <= 2 ? emit_operand(k) : std::nullopt;
+            if (operand)
+            {
+                emit_load_field(*operand, d.raw_F);
+                if (op >= 8)
+                    e.xor_32(Emitter::rdx, 1);
+                e.mov(Emitter::w64, Emitter::base_rbx, magnitude_offsets[reg], Emitter::rax);
+                e.mov(Emitter::w32, Emitter::base_rbx, sign_offsets[reg], Emitter::rdx);
+                continue;
+            }
+        }
+
+        if (inline_fields && field.valid && d.handler >= h_sta_direct_full && d.handler <= h_stz_indexed)
+        {
+            std::optional<Operand> const operand = emit_operand(k);
+            if (operand)
+            {
+                NativeByte const reg = (d.handler - h_sta_direct_full) / field_variants;
+                if (reg < 8)
+                {
+                    e.mov(Emitter::w64, Emitter::rax, Emitter::base_rbx, magnitude_offsets[reg]);
+                    e.mov(Emitter::w32, Emitter::rdx, Emitter::base_rbx, sign_offsets[reg]);
+                }
+                else
+                {
+                    // rJ, which is always +, or rZ
+                    if (reg == 8)
+                        e.mov(Emitter::w64, Emitter::rax, Emitter::base_rbx, rJ_magnitude_offset);
+                    else
+                        e.mov(Emitter::rax, std::uint64_t(0));
+                    e.mov(Emitter::rdx, std::uint64_t(s_plus));
+                }
+                emit_store_field(*operand, d.raw_F);
+                emit_note_store(*operand, k);
+                continue;
+            }
+        }
+
+        if (inline_fields && field.valid && d.handler >= h_cmpa_direct_full && d.handler <= h_cmpx_indexed)
+        {
+            std::optional<Operand> const operand = emit_operand(k);
+            if (operand)
+            {
+                NativeByte const reg = (d.handler - h_cmpa_direct_full) / field_variants;
+                emit_load_field(*operand, d.raw_F);
+                emit_apply_sign(Emitter::rax, Emitter::rdx);
+                e.mov(Emitter::rsi, Emitter::rax);
+                // rax = the same field of the register, whose packed word has its magnitude in the rightmost bytes
+                e.mov(Emitter::w64, Emitter::rax, Emitter::base_rbx, magnitude_offsets[reg]);
+                if (field.shift != 0)
+                    e.shr(Emitter::rax, std::uint8_t(field.shift));
+                e.mov(Emitter::rcx, field.magnitude_mask);
+                e.and_(Emitter::rax, Emitter::rcx);
+                if (field.has_sign)
+                {
+                    e.mov(Emitter::w32, Emitter::rcx, Emitter::base_rbx, sign_offsets[reg]);
+                    emit_apply_sign(Emitter::rax, Emitter::rcx);
+                }
+                // comparison = (rax > rsi) - (rax < rsi)
+                e.cmp(Emitter::rax, Emitter::rsi);
+                e.setcc(Emitter::c_greater, Emitter::rax);
+                e.setcc(Emitter::c_less, Emitter::rcx);
+                e.sub_8(Emitter::rax, Emitter::rcx);
+                e.mov(Emitter::w8, Emitter::base_rbx, comparison_offset, Emitter::rax);
+                continue;
+            }
+        }
+
+        if (inline_fields && field.valid && d.handler >= h_add_direct_full && d.handler <= h_sub_indexed
+            && (d.handler <= h_add_indexed || d.handler >= h_sub_direct_full))
+        {
+            std::optional<Operand> const operand = emit_operand(k);
+            if (operand)
+            {
+                // rdi = V, negated for SUB
+                emit_load_field(*operand, d.raw_F);
+                if (d.handler >= h_sub_direct_full)
+                    e.xor_32(Emitter::rdx, 1);
+                emit_apply_sign(Emitter::rax, Emitter::rdx);
+                e.mov(Emitter::rdi, Emitter::rax);
+                emit_register_value(0);
+                e.add(Emitter::rax, Emitter::rdi);
+                emit_store_sum(0, k);
+                continue;
+            }
+        }
+
+        if (M && d.handler >= h_jov_direct && d.handler <= h_jle_indexed && (d.handler - h_jov_direct) % 2 == 0)
+        {
+            Emitter::JumpSite taken;
+            if (d.handler == h_jov_direct || d.handler == h_jnov_direct)
+            {
+                // Either turns the overflow toggle off
+                e.cmp(Emitter::w8, Emitter::base_rbx, overflow_offset, 0);
+                e.mov(Emitter::w8, Emitter::base_rbx, overflow_offset, 0);
+                taken = e.jcc(d.handler == h_jov_direct ? Emitter::c_not_equal : Emitter::c_equal);
+            }
+            else
+            {
+                e.cmp(Emitter::w8, Emitter::base_rbx, comparison_offset, 0);
+                taken = e.jcc(comparison_jump_conditions[(d.handler - h_jl_direct) / 2]);
+            }
+            emit_link(address + 1);
+            e.bind(taken);
+            e.mov(Emitter::w64, Emitter::base_rbx, rJ_magnitude_offset, address + 1);
+            emit_link(*M);
+            linked = true;
+            break;
+        }
+
+        if (M && (d.handler == h_jmp_direct || d.handler == h_jsj_direct))
+        {
+            if (d.handler == h_jmp_direct)
+                e.mov(Emitter::w64, Emitter::base_rbx, rJ_magnitude_offset, address + 1);
+            emit_link(*M);
+            linked = true;
+            break;
+        }
+
+        if (M && d.handler >= h_jan_direct && d.handler <= h_jxnp_indexed && jump_offset % 2 == 0)
+        {
+            NativeByte const reg = jump_offset / 12;
+            RegisterJumpCondition const condition = register_jump_conditions[jump_offset / 2 % 6];
+            std::vector<Emitter::JumpSite> taken, not_taken;
+            e.mov(Emitter::w64, Emitter::rax, Emitter::base_rbx, magnitude_offsets[reg]);
+            e.test(Emitter::rax, Emitter::rax);
+            (condition.zero ? taken : not_taken).push_back(e.jcc(Emitter::c_equal));
+            if (condition.plus != condition.minus)
+            {
+                e.mov(Emitter::w32, Emitter::rcx, Emitter::base_rbx, sign_offsets[reg]);
+                e.test(Emitter::rcx, Emitter::rcx);
+                (condition.plus ? taken : not_taken).push_back(e.jcc(Emitter::c_equal));
+            }
+            (condition.minus ? taken : not_taken).push_back(e.jmp());
+            for (Emitter::JumpSite const site : not_taken)
+                e.bind(site);
+            emit_link(address + 1);
+            for (Emitter::JumpSite const site : taken)
+                e.bind(site);
+            e.mov(Emitter::w64, Emitter::base_rbx, rJ_magnitude_offset, address + 1);
+            emit_link(*M);
+            linked = true;
+            break;
+        }
+
+        // Anything else calls its handler
+        e.mov(Emitter::w32, Emitter::base_rbx, pc_offset, address);
+        e.mov(Emitter::rax, reinterpret_cast<std::uint64_t>(&d));
+        e.mov(Emitter::w64, Emitter::base_rbx, decoded_offset, Emitter::rax);
+        e.mov(Emitter::rdi, Emitter::rbx);
+        e.mov(Emitter::rax, reinterpret_cast<std::uint64_t>(Machine::jit_thunks[d.handler]));
+        e.call(Emitter::rax);
+        e.cmp_al(std::uint8_t(JitStatus::next));
+        side_exits.push_back({.site = e.jcc(Emitter::c_not_equal), .index = k, .from_handler = true, .trap = std::nullopt});
+        if (ends_block(d.handler))
+        {
+            // A jump that the handler did not take goes on to the next instruction
+            e.cmp(Emitter::w32, Emitter::base_rbx, pc_offset, address + 1);
+            Emitter::JumpSite const taken = e.jcc(Emitter::c_not_equal);
+            emit_link(address + 1);
+            e.bind(taken);
+            if (M)
+                emit_link(*M);
+            else
+                Emitter::patch(e.jmp(), exit_next);
+            linked = true;
+        }
+    }
+    if (!linked)
+        emit_link(start + length);
+
+    for (SideExit const &side_exit : side_exits)
+    {
+        e.bind(side_exit.site);
+        if (side_exit.from_handler)
+        {
+            // The handler completed, but the run has to go back to the dispatcher
+            e.test_al_al();
+            Emitter::JumpSite const trapped = e.jcc(Emitter::c_equal);
+            emit_unwind(side_exit.index + 1);
+            Emitter::patch(e.jmp(), exit_next);
+            e.bind(trapped);
+        }
+        if (side_exit.trap)
+        {
+            e.mov(Emitter::w32, Emitter::base_rbx, trap_code_offset, NativeByte(*side_exit.trap));
+            e.mov(Emitter::w32, Emitter::base_rbx, pc_offset, start + side_exit.index);
+            e.mov(Emitter::rax, reinterpret_cast<std::uint64_t>(&block->decoded[side_exit.index]));
+            e.mov(Emitter::w64, Emitter::base_rbx, decoded_offset, Emitter::rax);
+        }
+        emit_unwind(side_exit.index);
+        Emitter::patch(e.jmp(), exit_trap);
+    }
+    code_cursor = e.position();
+
+    Block *const translated_block = translated.emplace_back(std::move(block)).get();
+    blocks[start] = translated_block;
+    for (NativeByte k = 0; k < length; k++)
+    {
+        spanning[start + k].push_back(translated_block);
+        translated_cells[start + k] = 1;
+    }
+    for (std::uint8_t *const site : pending_links[start])
+    {
+        Emitter::patch(site, translated_block->entry);
+        translated_block->incoming.push_back(site);
+    }
+    pending_links[start].clear();
+    return translated_block;
+}
+
+void Jit::retire(Block *block)
+{
+    // Cools the cell down, for DispatchEngine::tiered
+    m.heat[block->start] = 0;
+    for (NativeByte k = 0; k < block->length; k++)
+    {
+        std::erase(spanning[block->start + k], block);
+        translated_cells[block->start + k] = !spanning[block->start + k].empty();
+    }
+    blocks[block->start] = nullptr;
+    for (std::uint8_t *const site : block->incoming)
+    {
+        Emitter::patch(site, exit_next);
+        pending_links[block->start].push_back(site);
+    }
+    block->incoming.clear();
+}
+
+void Jit::invalidate(ValidatedAddress address)
+{
+    std::vector<Block *> &blocks_here = spanning[address];
+    if (blocks_here.empty()) [[likely]]
+        return;
+    m.translated_code_invalidated = true;
+    if (++rewrites[address] >= max_rewrites)
+        interpreted.set(address);
+    // Called from a handler or a store of translated code as well, which goes on running once the exits are patched
+    bool const was_executable = executable;
+    set_executable(false);
+    while (!blocks_here.empty())
+        retire(blocks_here.back());
+    set_executable(was_executable);
+}
+
+RunResult Jit::run(size_t const budget, bool const hot_only)
+{
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    counters = {.budget = budget, .cycles = 0};
+    while (counters.budget > 0)
+    {
+        if (hot_only && (m.pc >= main_memory_size || (blocks[m.pc] == nullptr && !m.is_hot(m.pc))))
+            break;
+        Block *const block = block_at(m.pc);
+        if (hot_only && block == nullptr)
+            break;
+        if (block != nullptr && block->length <= counters.budget) [[likely]]
+        {
+            m.translated_code_invalidated = false;
+            set_executable(true);
+            if (enter(&m, &counters, block->entry) == JitStatus::trap) [[unlikely]]
+            {
+                result.reason = StopReason::trap;
+                result.trap = m.record_trap();
+                break;
+            }
+        }
+        else
+        {
+            // pc is past the end of memory or on a breakpoint, the instruction is never translated,
+            // or the budget ends partway through the block
+            RunResult const interpreted_run = m.run_jump_table(block != nullptr ? counters.budget : 1);
+            counters.budget -= interpreted_run.instructions;
+            counters.cycles += interpreted_run.cycles;
+            if (interpreted_run.reason != StopReason::budget)
+            {
+                result.reason = interpreted_run.reason;
+                result.trap = interpreted_run.trap;
+                break;
+            }
+        }
+        if (m.pending_stop) [[unlikely]]
+        {
+            result.reason = *m.pending_stop;
+            break;
+        }
+    }
+    result.instructions = budget - counters.budget;
+    result.cycles = counters.cycles;
+    return result;
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <base/base.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+class Jit;
+
+MIX_END_BYTE_SIZE_NAMESPACE
+
+// Whether the host can run code translated by the JIT.
+// Elsewhere DispatchEngine::jit runs as DispatchEngine::threaded.
+#if defined(__x86_64__)
+constexpr bool jit_supported = true;
+#else
+constexpr bool jit_supported = false;
+#endif
+
+// What translated code, or a handler that it calls, hands back
+enum class JitStatus : NativeByte
+{
+    // The instruction failed, see Machine::record_trap
+    trap,
+    // Carry on at pc
+    next,
+    // The instruction completed, but the run must go back to the dispatcher,
+    // either because it stops or because translated code has been invalidated
+    leave,
+};
+
+}
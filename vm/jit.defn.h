@@ -0,0 +1,171 @@
+#pragma once
+#include <base/base.h>
+#include <vm/instruction.defn.h>
+#include <vm/jit.decl.h>
+#include <vm/machine.decl.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <vector>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Translates the basic blocks of a Machine's program to x86-64 and runs them natively, for DispatchEngine::jit.
+//
+// A block starts wherever the run reaches, and runs straight on until a jump, HLT or an I/O instruction,
+// which it includes, or until an instruction that it cannot include, which it stops before.
+// Address transfers, jumps on a register, the comparison indicator or the overflow toggle, and, when byte_size is a power of 2,
+// loads, stores, comparisons, ADD and SUB on any field are translated to host code that works on the registers and memory in place,
+// indexed or not. Every other instruction is a call to its handler, which still saves the fetch, decode and dispatch.
+// A translated store only calls out when the cell it writes has been decoded or translated, so that those get thrown away.
+// An exit whose successor is known is patched to jump straight into the successor once it is translated,
+// so a hot loop stays in translated code until its budget runs out.
+//
+// A store into a translated cell throws away the blocks that span it.
+// A cell that is stored into over and over (e.g. the address of a subroutine's return jump) is left to the interpreter from then on,
+// so that its block does not get translated again on every store.
+//
+// The code buffer is never writable and executable at once: it is made executable to run translated code,
+// and writable again, for as long as it takes, to translate a block or to patch the exits of one that is thrown away.
+class Jit
+{
+public:
+    // Kept up to date by translated code, which reaches them through r12
+    struct Counters
+    {
+        // Instructions that may still run.
+        // A block only runs if it fits, and takes its length off on entry.
+        size_t budget;
+        // Execution time so far in units of u
+        size_t cycles;
+    };
+
+private:
+    using EnterFunction = JitStatus (*)(Machine *, Counters *, void const *);
+
+    struct Block
+    {
+        NativeByte start;
+        NativeByte length;
+        std::uint8_t *entry;
+        // The instructions that the block calls handlers for, which Instruction points into
+        std::vector<DecodedInstruction> decoded;
+        // Exits of other blocks that jump straight into this one
+        std::vector<std::uint8_t *> incoming;
+    };
+
+    // Longest block, in instructions
+    static constexpr NativeByte max_block_length = 64;
+
+    // Upper bound of the code that one instruction translates to, exit paths included
+    static constexpr size_t max_code_per_instruction = 512;
+
+    // Stores into a translated cell after which it is left to the interpreter
+    static constexpr NativeByte max_rewrites = 4;
+
+    static constexpr size_t code_buffer_size = size_t(16) << 20;
+
+    Machine &m;
+
+    Counters counters{};
+
+    // Starts with the code that enters and leaves translated code.
+    // Readable and executable while executable is set, and readable and writable otherwise.
+    std::uint8_t *code = nullptr;
+    bool executable = false;
+    // Where blocks start, after the trampolines
+    std::uint8_t *first_block = nullptr;
+    std::uint8_t *code_cursor = nullptr;
+
+    EnterFunction enter = nullptr;
+    // Leave translated code with JitStatus::next or JitStatus::trap
+    std::uint8_t *exit_next = nullptr;
+    std::uint8_t *exit_trap = nullptr;
+
+    // Where translated code reaches the machine state, relative to the Machine in rbx
+    std::int32_t pc_offset;
+    std::int32_t decoded_offset;
+    std::int32_t overflow_offset;
+    std::int32_t trap_code_offset;
+    std::int32_t rJ_magnitude_offset;
+    std::int32_t memory_offset;
+    std::int32_t comparison_offset;
+    std::int32_t dirty_cells_offset;
+    std::int32_t decoded_instructions_offset;
+    // Where translated code reaches translated_cells, relative to the Counters in r12
+    std::int32_t translated_cells_offset;
+    // rA, rI1 to rI6 and rX, in the order that the op codes of address transfers and jumps on registers follow
+    std::array<std::int32_t, 8> sign_offsets;
+    std::array<std::int32_t, 8> magnitude_offsets;
+
+    // Every block translated since the code buffer was last flushed, kept until then even once thrown away,
+    // since its code and decoded instructions may still be in use when it is thrown away
+    std::vector<std::unique_ptr<Block>> translated;
+
+    // The live block starting at each address
+    std::array<Block *, main_memory_size> blocks{};
+
+    // The live blocks that span each address
+    std::array<std::vector<Block *>, main_memory_size> spanning;
+
+    // Whether any live block spans each address, for translated stores to check
+    std::array<std::uint8_t, main_memory_size> translated_cells{};
+
+    // Exits waiting for a block to be translated at each address
+    std::array<std::vector<std::uint8_t *>, main_memory_size> pending_links;
+
+    std::array<NativeByte, main_memory_size> rewrites{};
+
+    // Cells that are no longer translated, see max_rewrites
+    std::bitset<main_memory_size> interpreted;
+
+    std::int32_t offset_of(void const *member) const;
+
+    // Makes the code buffer executable, or writable
+    void set_executable(bool to_executable);
+
+    // Called by a translated store into a cell that has been decoded or translated, once the store is done
+    static JitStatus note_store(Machine &m, NativeByte address);
+
+    // Emits the code that enters and leaves translated code, at the start of the code buffer
+    void emit_trampolines();
+
+    // Throws away every block, and starts the code buffer over
+    void flush();
+
+    // Returns the block starting at address, translating it if need be,
+    // or nullptr if the instruction at address has to be interpreted
+    Block *block_at(NativeByte address);
+
+    Block *translate(NativeByte start);
+
+    // Throws away a block, pointing the exits that jump straight into it back at the dispatcher
+    void retire(Block *block);
+
+public:
+    explicit Jit(Machine &m);
+    ~Jit();
+
+    Jit(Jit const &) = delete;
+    Jit &operator=(Jit const &) = delete;
+
+    // False if there is no executable memory to translate to, in which case the machine does not use the JIT
+    bool has_code_buffer() const
+    {
+        return code != nullptr;
+    }
+
+    // Same as Machine::run, from wherever Machine::run leaves off.
+    // With hot_only, as for DispatchEngine::tiered, only translates blocks that start on a hot cell (see Machine::heat),
+    // and returns as soon as it reaches a cell that is neither hot nor translated.
+    RunResult run(size_t budget, bool hot_only = false);
+
+    // Called whenever a cell is written to, or has a breakpoint set or cleared
+    void invalidate(ValidatedAddress address);
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
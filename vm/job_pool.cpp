@@ -0,0 +1,237 @@
+#include <base/base.h>
+#include <vm/job_pool.h>
+#include <vm/machine.h>
+#include <vm/raw_word.h>
+#include <vm/snapshot_file.h>
+
+#include <algorithm>
+#include <thread>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+constexpr std::uint64_t pack_range(std::uint64_t first, std::uint64_t last)
+{
+    return first << 32 | last;
+}
+
+// Jobs that the deques can index at a time, since a deque packs two 32-bit indices
+constexpr size_t max_chunk = 0xffffffff;
+
+// Carries out an I/O instruction with the devices of the job, and returns whether the job has the device.
+// Reading past the end of the deck, a block that does not fit in memory and a card with a word that is not a MIX word
+// count as having no device.
+bool serve_io(Machine &machine, Job const &job, IoRequest const &request, JobResult &result)
+{
+    if (request.unit != card_reader_unit && request.unit != card_punch_unit && request.unit != line_printer_unit)
+        return false;
+    // Ejecting a page or skipping a card is left to whoever reads the output
+    if (request.op == op_ioc)
+        return true;
+    size_t const words = request.unit == line_printer_unit ? line_words : card_words;
+    if (request.M + words > main_memory_size)
+        return false;
+
+    if (request.op == op_in)
+    {
+        if (request.unit != card_reader_unit || result.next_card > job.input_deck.size() || job.input_deck.size() - result.next_card < card_words)
+            return false;
+        for (size_t i = 0; i < card_words; i++)
+        {
+            Result<std::array<Byte, bytes_in_word>> const word = to_word(job.input_deck[result.next_card + i]);
+            if (!word)
+                return false;
+            machine.load_word(ValidatedAddress::trusted_constructor(request.M + i).value(), word.value());
+        }
+        result.next_card += card_words;
+        return true;
+    }
+
+    if (request.unit == card_reader_unit)
+        return false;
+    std::vector<RawWord> &output = request.unit == card_punch_unit ? result.punched : result.printed;
+    for (size_t i = 0; i < words; i++)
+        output.push_back(to_raw_word(machine.read_word(ValidatedAddress::trusted_constructor(request.M + i).value())));
+    return true;
+}
+
+}
+
+void load_binary(Machine &machine, BinaryImage const &binary)
+{
+    ValidatedAddress const entry_point = ValidatedAddress::trusted_constructor(binary.entry_point).value();
+    std::vector<std::array<Byte, bytes_in_word>> words;
+    for (BinarySegment const &segment : binary.segments)
+    {
+        words.clear();
+        for (RawWord const &raw : segment.words)
+            words.push_back(to_word(raw).value());
+        (void)machine.load_program(ValidatedAddress::trusted_constructor(segment.origin).value(), words, entry_point);
+    }
+    // Sets pc even when the binary loads nothing
+    (void)machine.load_program(entry_point, {}, entry_point);
+}
+
+void run_loaded_job(Machine &machine, Job const &job, JobResult &result, std::stop_token const &stop)
+{
+    result.punched.clear();
+    result.printed.clear();
+    resume_loaded_job(machine, job, SnapshotCounters{.instructions = 0, .cycles = 0, .next_card = 0}, result, stop);
+}
+
+void resume_loaded_job(Machine &machine, Job const &job, SnapshotCounters const &counters, JobResult &result, std::stop_token const &stop)
+{
+    result.run = RunResult{.reason = StopReason::budget, .trap = {}, .instructions = counters.instructions, .cycles = counters.cycles};
+    result.io.reset();
+    result.next_card = counters.next_card;
+    result.finished = false;
+    // Before carrying out any I/O, since a machine that was not restored for the job may still wait on that of another
+    if (stop.stop_requested())
+        return;
+    while (true)
+    {
+        // Stopped on by the last slice, or by the run that the machine was restored from
+        if (std::optional<IoRequest> const request = machine.io_request())
+        {
+            if (!serve_io(machine, job, *request, result))
+            {
+                result.run.reason = StopReason::io_wait;
+                result.io = request;
+                break;
+            }
+            machine.clear_io_request();
+            result.run.reason = StopReason::budget;
+        }
+        if (result.run.instructions >= job.budget)
+            break;
+        if (stop.stop_requested())
+            return;
+        RunResult const slice = machine.run(std::min(job.budget - result.run.instructions, job_slice_budget));
+        result.run.reason = slice.reason;
+        result.run.trap = slice.trap;
+        result.run.instructions += slice.instructions;
+        result.run.cycles += slice.cycles;
+        if (slice.reason != StopReason::budget && slice.reason != StopReason::io_wait)
+            break;
+    }
+    result.finished = true;
+}
+
+void JobPool::run_job(Worker &worker, Job const &job, JobResult &result, std::stop_token const &stop)
+{
+    Machine &machine = *worker.machine;
+    // resume_loaded_job leaves a job unfinished without running it once stop is requested
+    if (!stop.stop_requested())
+    {
+        // The snapshot of the worker stays valid, since restoring it later writes back every cell that differs
+        if (job.snapshot)
+            machine.restore(*job.snapshot);
+        else if (worker.binary == job.binary)
+            machine.restore(*worker.snapshot);
+        else
+        {
+            machine.reset();
+            load_binary(machine, *job.binary);
+            worker.binary = job.binary;
+            worker.snapshot = std::make_unique<MachineSnapshot>(machine.snapshot());
+        }
+    }
+    if (job.snapshot)
+        resume_loaded_job(machine, job, job.snapshot->header().counters, result, stop);
+    else
+        run_loaded_job(machine, job, result, stop);
+}
+
+JobPool::JobPool(size_t worker_count, DispatchEngine const engine)
+{
+    if (worker_count == 0)
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    deques = std::make_unique<Deque[]>(worker_count);
+    for (size_t worker = 0; worker < worker_count; worker++)
+    {
+        workers.push_back(Worker{.machine = std::make_unique<Machine>(), .binary = nullptr, .snapshot = nullptr});
+        workers.back().machine->set_dispatch_engine(engine);
+    }
+}
+
+JobPool::~JobPool() = default;
+
+std::optional<size_t> JobPool::pop(size_t const worker)
+{
+    std::atomic<std::uint64_t> &range = deques[worker].range;
+    // The ranges only hand out indices: jobs and results are published by starting and joining the workers
+    std::uint64_t current = range.load(std::memory_order_relaxed);
+    while (true)
+    {
+        std::uint64_t const first = current >> 32;
+        std::uint64_t const last = current & max_chunk;
+        if (first == last)
+            return std::nullopt;
+        if (range.compare_exchange_weak(current, pack_range(first + 1, last), std::memory_order_relaxed))
+            return first;
+    }
+}
+
+bool JobPool::steal(size_t const worker)
+{
+    for (size_t k = 1; k < workers.size(); k++)
+    {
+        std::atomic<std::uint64_t> &victim = deques[(worker + k) % workers.size()].range;
+        std::uint64_t current = victim.load(std::memory_order_relaxed);
+        while (true)
+        {
+            std::uint64_t const first = current >> 32;
+            std::uint64_t const last = current & max_chunk;
+            if (first == last)
+                break;
+            // Rounded up, so that the last job of a deque can be stolen too
+            std::uint64_t const middle = last - (last - first + 1) / 2;
+            if (victim.compare_exchange_weak(current, pack_range(first, middle), std::memory_order_relaxed))
+            {
+                // Nobody else writes to an empty deque, so the stolen jobs can simply be stored
+                deques[worker].range.store(pack_range(middle, last), std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void JobPool::work(size_t const worker, std::span<Job const> const jobs, std::span<JobResult> const results, std::stop_token const &stop)
+{
+    while (true)
+    {
+        std::optional<size_t> const index = pop(worker);
+        if (index)
+            run_job(workers[worker], jobs[*index], results[*index], stop);
+        // A worker that finds nothing to steal is done, since jobs are never added, and those that are being stolen
+        // are run by the thief
+        else if (!steal(worker))
+            return;
+    }
+}
+
+std::vector<JobResult> JobPool::run(std::span<Job const> const all_jobs, std::stop_token const stop)
+{
+    std::vector<JobResult> all_results(all_jobs.size());
+    size_t const worker_count = workers.size();
+    for (size_t offset = 0; offset < all_jobs.size(); offset += max_chunk)
+    {
+        std::span<Job const> const jobs = all_jobs.subspan(offset, std::min(max_chunk, all_jobs.size() - offset));
+        std::span<JobResult> const results = std::span(all_results).subspan(offset, jobs.size());
+        for (size_t worker = 0; worker < worker_count; worker++)
+            deques[worker].range.store(pack_range(jobs.size() * worker / worker_count, jobs.size() * (worker + 1) / worker_count), std::memory_order_relaxed);
+
+        std::vector<std::jthread> threads;
+        for (size_t worker = 1; worker < worker_count; worker++)
+            threads.emplace_back([this, worker, jobs, results, &stop] { work(worker, jobs, results, stop); });
+        work(0, jobs, results, stop);
+    }
+    return all_results;
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <base/base.h>
+#include <binary/reader.h>
+#include <vm/machine.decl.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <vector>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// The devices that a job has, by unit number, and the words in a block of each
+constexpr NativeByte card_reader_unit = 16;
+constexpr NativeByte card_punch_unit = 17;
+constexpr NativeByte line_printer_unit = 18;
+constexpr size_t card_words = 16;
+constexpr size_t line_words = 24;
+
+// A program to run with its input, for up to budget instructions
+struct Job
+{
+    // Usually shared by many jobs
+    std::shared_ptr<BinaryImage const> binary;
+    // Read a card of card_words words at a time by IN from the card reader
+    std::vector<RawWord> input_deck;
+    // Counted over the whole job, from before any snapshot it resumes from
+    size_t budget;
+    // When set, the job resumes from the snapshot, and its counters, instead of starting with binary, which is not used then,
+    // e.g. to carry on with a job that another process stopped. input_deck is the whole deck, which the job reads on
+    // from where the snapshot has got to, and the result only has what the job writes from the snapshot on.
+    std::shared_ptr<SnapshotFile const> snapshot = nullptr;
+};
+
+struct JobResult
+{
+    // Counted over the whole job. A job that stops on an I/O instruction that it has no device for,
+    // or that reads past the end of its deck, stops with StopReason::io_wait.
+    RunResult run;
+    // The I/O instruction that the job stopped on, if it did
+    std::optional<IoRequest> io;
+    // What OUT wrote to the card punch and the line printer, block after block
+    std::vector<RawWord> punched;
+    std::vector<RawWord> printed;
+    // Words of the input deck that the job has read
+    std::uint64_t next_card = 0;
+    // False when the pool was asked to stop before the job ran to its end
+    bool finished = false;
+
+    // What a snapshot of the machine that the job stopped on carries, so that the job can be resumed from it
+    SnapshotCounters counters() const
+    {
+        return SnapshotCounters{.instructions = run.instructions, .cycles = run.cycles, .next_card = next_card};
+    }
+};
+
+// Loads what a binary loads into a machine that was just reset, which read_binary made sure fits, and sets pc to its entry point
+void load_binary(Machine &machine, BinaryImage const &binary);
+
+// Instructions that a job runs at a time, in between which its I/O instructions are carried out
+// and its runner checks whether it was asked to stop
+constexpr size_t job_slice_budget = 1 << 20;
+
+// Runs a job on a machine that its binary was just loaded into, or restored to, until it stops, or its budget runs out,
+// or stop is requested, which leaves it unfinished
+void run_loaded_job(Machine &machine, Job const &job, JobResult &result, std::stop_token const &stop);
+
+// Runs a job as run_loaded_job does, on a machine that the job was stopped on counters into it, or that was restored
+// from a snapshot taken there. The I/O instruction that the machine waits on, if any, is carried out first,
+// and what the job writes is appended to the output in result, which holds what it wrote so far.
+void resume_loaded_job(Machine &machine, Job const &job, SnapshotCounters const &counters, JobResult &result, std::stop_token const &stop);
+
+// Runs jobs on a fixed set of worker threads, each of which keeps one Machine.
+// A worker keeps a snapshot of the binary that it loaded last, so that a job that runs the same binary,
+// as in BinaryImage object, restores the snapshot rather than resetting the machine and loading the binary again.
+// A job with a snapshot file restores the file instead.
+//
+// Each worker has its own deque of jobs: a range of job indices that it takes jobs from the front of, one at a time,
+// and that idle workers steal the back half of, so that workers only touch each other's deques once they run out of work.
+// A deque is a single atomic word, the range packed as two 32-bit indices, which every change swaps in with a compare-and-swap.
+// Each job writes its result into its own slot of the results, which therefore need no lock and keep the order of the jobs.
+//
+// A job runs in slices of job_slice_budget instructions, and in between, the worker carries out its I/O instructions
+// and checks whether the pool was asked to stop, so that a long job is preempted without any help from the interpreter.
+class JobPool
+{
+    // [first, last) of the job indices left to the worker, as first << 32 | last
+    struct alignas(64) Deque
+    {
+        std::atomic<std::uint64_t> range{0};
+    };
+
+    struct Worker
+    {
+        std::unique_ptr<Machine> machine;
+        // The binary that the snapshot was taken just after loading, which is kept so that it is not mistaken for another one
+        std::shared_ptr<BinaryImage const> binary;
+        std::unique_ptr<MachineSnapshot> snapshot;
+    };
+
+    std::vector<Worker> workers;
+    std::unique_ptr<Deque[]> deques;
+
+    // Takes the job at the front of the worker's deque
+    std::optional<size_t> pop(size_t worker);
+
+    // Moves the back half of another worker's deque into the worker's own, which is empty.
+    // Returns whether it found any job to take.
+    bool steal(size_t worker);
+
+    // Runs a job on a worker's machine, up to its budget or until stop is requested
+    void run_job(Worker &worker, Job const &job, JobResult &result, std::stop_token const &stop);
+
+    void work(size_t worker, std::span<Job const> jobs, std::span<JobResult> results, std::stop_token const &stop);
+
+public:
+    // With as many workers as the host has hardware threads when worker_count is 0
+    explicit JobPool(size_t worker_count = 0, DispatchEngine engine = DispatchEngine::jump_table);
+    ~JobPool();
+
+    size_t worker_count() const
+    {
+        return workers.size();
+    }
+
+    // Runs every job, returning the results in the order of the jobs.
+    // The calling thread is one of the workers, and the others are started for the call.
+    // Once stop is requested, workers finish the slice that they are in and leave the jobs not run yet unfinished.
+    std::vector<JobResult> run(std::span<Job const> jobs, std::stop_token stop = {});
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,2 @@
+#pragma once
+#include <vm/job_pool.defn.h>
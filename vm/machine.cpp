@@ -3,336 +3,1373 @@
 #include "base/validation/validator.impl.h"
 #include <base/base.h>
 #include <vm/instruction.h>
+#include <vm/aot.h>
+#include <vm/jit.h>
 #include <vm/machine.h>
-#include <vm/register.decl.h>
+#include <vm/register.h>
+#include <vm/sequence_profile.h>
+#include <vm/snapshot_file.h>
+#include <vm/superinstruction.h>
 
+#include <bit>
 #include <compare>
-#include <iostream>
-#include <stdexcept>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
-void Machine::do_nop()
+Result<void> Machine::do_nop()
 {
     increment_pc();
+    return Result<void>::success();
 }
 
-void Machine::do_add()
+template <Addressing addressing>
+Result<void> Machine::do_add()
 {
-    if (rA.load<false>(rA.native_value() + inst.native_MF()))
-        overflow = true;
-    increment_pc();
+    return inst.native_MF<addressing>().transform_value([this](NativeInt const V){
+        if (rA.load(rA.native_value() + V))
+            overflow = true;
+        increment_pc();
+    });
 }
 
-void Machine::do_fadd()
+Result<void> Machine::do_fadd()
 {
-    throw std::runtime_error("Unimplemented");
-    increment_pc();
+    return trap(TrapCode::unimplemented);
 }
 
-void Machine::do_sub()
+template <Addressing addressing>
+Result<void> Machine::do_sub()
 {
-    if (rA.load<false>(rA.native_value() - inst.native_MF()))
-        overflow = true;
-    increment_pc();
+    return inst.native_MF<addressing>().transform_value([this](NativeInt const V){
+        if (rA.load(rA.native_value() - V))
+            overflow = true;
+        increment_pc();
+    });
 }
 
-void Machine::do_fsub()
+Result<void> Machine::do_fsub()
 {
-    throw std::runtime_error("Unimplemented");
-    increment_pc();
+    return trap(TrapCode::unimplemented);
 }
 
-void Machine::do_mul()
+template <Addressing addressing>
+Result<void> Machine::do_mul()
 {
-    NativeInt const mul_result = rA.native_value() * inst.native_MF();
-    rAX.load(mul_result);
-    increment_pc();
+    return inst.native_MF<addressing>().transform_value([this](NativeInt const V){
+        auto const [
+            V_sign,
+            V_abs
+        ] = ValidatedUtils::from_abs(V);
+        // The product of two words always fits in rAX
+        rAX.load(Sign(rA.sign() ^ V_sign), NativeExtendedUInt(rA.native_unsigned_value()) * NativeInt(V_abs));
+        increment_pc();
+    });
 }
 
-void Machine::do_fmul()
+Result<void> Machine::do_fmul()
 {
-    throw std::runtime_error("Unimplemented");
-    increment_pc();
+    return trap(TrapCode::unimplemented);
 }
 
-void Machine::do_div()
+// As in MIX, a zero divisor or a quotient that does not fit in rA only turns on the overflow toggle
+template <Addressing addressing>
+Result<void> Machine::do_div()
 {
-    NativeInt const dividend = rAX.native_value();
-    Sign const dividend_sign = rAX.sign();
-    
-    NativeInt const divisor = inst.native_V();
-    if (divisor == 0)
-        throw std::runtime_error("Divide by zero");
-    
-    // TODO: Check for overflow
+    return inst.native_V<addressing>().transform_value([this](NativeInt const V){
+        auto const [
+            V_sign,
+            V_abs
+        ] = ValidatedUtils::from_abs(V);
+        NativeInt const divisor = V_abs;
+        if (rA.native_unsigned_value() >= divisor)
+        {
+            overflow = true;
+            increment_pc();
+            return;
+        }
 
-    // sgn(rAX / V) * floor(|rAX / V|)
-    // Regular division already rounds toward zero, thereby achieving the desired effect.
-    NativeInt const quotient = dividend / divisor;
-    rA.load<false>(quotient);
+        // As |rA| < |V|, the quotient fits in a word
+        NativeExtendedUInt const dividend = rAX.native_unsigned_value();
+        Sign const dividend_sign = rAX.sign();
 
-    // sgn(rAX) * (|rAX| mod |V|)
-    NativeInt const remainder = dividend_sign * (std::labs(dividend) % std::labs(divisor));
-    rX.load<false>(remainder);
+        // sgn(rAX / V) * floor(|rAX / V|)
+        rA.load(Sign(dividend_sign ^ V_sign), std::get<1>(ValidatedUtils::from_abs(NativeInt(dividend / divisor))));
 
-    increment_pc();
+        // sgn(rAX) * (|rAX| mod |V|)
+        rX.load(dividend_sign, std::get<1>(ValidatedUtils::from_abs(NativeInt(dividend % divisor))));
+
+        increment_pc();
+    });
 }
 
-void Machine::do_fdiv()
+Result<void> Machine::do_fdiv()
 {
-    throw std::runtime_error("Unimplemented");
-    increment_pc();
+    return trap(TrapCode::unimplemented);
 }
 
-void Machine::do_num()
+Result<void> Machine::do_num()
 {
+    // Each of the 10 bytes of rAX is a decimal digit, the leftmost one being the most significant
+    NativeExtendedUInt const digits = rAX.native_unsigned_value();
     NativeInt value = 0;
-    for (size_t i = 1; i < rA.reg.size(); i++)
-    {
-        NativeByte const character_value = rA.reg[i].byte % 10;
-        value = value * byte_size + character_value;
-    }
-
-    for (size_t i = 1; i < rX.reg.size(); i++)
-    {
-        NativeByte const character_value = rX.reg[i].byte % 10;
-        value = value * byte_size + character_value;
-    }
-
-    if (rA.sign() == s_minus)
-        value = -value;
+    for (size_t i = numerical_bytes_in_extended_word; i --> 0;)
+        value = value * 10 + NativeInt(shift_bytes_down(digits, i) % byte_size % 10);
 
-    if (rA.load<false>(value))
-        std::cerr << "Warning: overflow during NUM\n";
+    // A value that does not fit in rA is taken modulo the word size
+    rA.load(rA.sign(), std::get<1>(ValidatedUtils::from_abs(value)));
     increment_pc();
+    return Result<void>::success();
 }
 
-void Machine::do_char()
+Result<void> Machine::do_char()
 {
-    static constexpr auto thirty = to_interval(from_literal<30>());
-    static constexpr auto ten = deduce<IsNonNegative>(from_literal<10>());
-    ValidatedNonNegative unsigned_value = rA.native_unsigned_value();
-    for (size_t i = rX.reg.size(); i --> 1; unsigned_value = unsigned_value / ten)
-        rX.reg[i].byte = ValidatedInt<IsInClosedInterval<0, byte_size - 1>>(thirty + ValidatedUtils::from_mod<10>(unsigned_value));
-
-    for (size_t i = rA.reg.size(); i --> 1; unsigned_value = unsigned_value / ten)
-        rA.reg[i].byte = ValidatedInt<IsInClosedInterval<0, byte_size - 1>>(thirty + ValidatedUtils::from_mod<10>(unsigned_value));
-
-    if (unsigned_value > 0)
-        std::cerr << "Warning: overflow in CHAR";
+    // The 10 decimal digits of rA become the character codes 30 to 39 in the bytes of rAX
+    NativeInt value = rA.native_unsigned_value();
+    NativeExtendedUInt characters = 0;
+    for (size_t i = 0; i < numerical_bytes_in_extended_word; i++, value /= 10)
+        characters += shift_bytes_up<NativeExtendedUInt>(30 + value % 10, i);
+    rAX.load_unsigned(characters);
     increment_pc();
+    return Result<void>::success();
 }
 
-void Machine::do_hlt()
+// Restarting after HLT continues from the next instruction
+Result<void> Machine::do_hlt()
 {
-    halted = true;
+    pending_stop = StopReason::halted;
+    increment_pc();
+    return Result<void>::success();
 }
 
-void Machine::do_sla()
+template <Addressing addressing>
+Result<void> Machine::do_sla()
 {
-    rA.shift_left(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rA.shift_left(shift_by);
+        increment_pc();
+    });
 }
 
-void Machine::do_sra()
+template <Addressing addressing>
+Result<void> Machine::do_sra()
 {
-    rA.shift_right(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rA.shift_right(shift_by);
+        increment_pc();
+    });
 }
 
-void Machine::do_slax()
+template <Addressing addressing>
+Result<void> Machine::do_slax()
 {
-    rAX.shift_left(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rAX.shift_left(shift_by);
+        increment_pc();
+    });
 }
 
-void Machine::do_srax()
+template <Addressing addressing>
+Result<void> Machine::do_srax()
 {
-    rAX.shift_right(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rAX.shift_right(shift_by);
+        increment_pc();
+    });
 }
 
-void Machine::do_slc()
+template <Addressing addressing>
+Result<void> Machine::do_slc()
 {
-    rAX.shift_left_circular(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rAX.shift_left_circular(shift_by);
+        increment_pc();
+    });
 }
 
-void Machine::do_src()
+template <Addressing addressing>
+Result<void> Machine::do_src()
 {
-    rAX.shift_right_circular(inst.native_M());
+    return inst.native_M<addressing>().transform_value([this](NativeInt const shift_by){
+        rAX.shift_right_circular(shift_by);
+        increment_pc();
+    });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_ld()
 {
-    return inst.MF().transform_value([this](SliceView const slice){
-        RegisterT &reg = this->*reg_member_ptr;
-        reg.template load<true>(slice.native_value());
+    if (!inst.has_valid_field<addressing>())
+        return Result<void>::failure();
+    PackedField const &field = inst.field<addressing>();
+    return inst.native_M<addressing>().transform_value([this, &field](ValidatedAddress const address){
+        PackedWord const word = memory.load(address);
+        auto &reg = get_register<reg_idx>();
+        if (reg.load(packed_field_sign(word, field), packed_field_magnitude(word, field)))
+            return trap(TrapCode::index_overflow);
+        increment_pc();
+        return Result<void>::success();
     });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_ldn()
 {
-    return inst.MF().transform_value([this](SliceView const slice){
-        RegisterT &reg = this->*reg_member_ptr;
-        reg.template load<true>(-slice.native_value());
+    if (!inst.has_valid_field<addressing>())
+        return Result<void>::failure();
+    PackedField const &field = inst.field<addressing>();
+    return inst.native_M<addressing>().transform_value([this, &field](ValidatedAddress const address){
+        PackedWord const word = memory.load(address);
+        auto &reg = get_register<reg_idx>();
+        if (reg.load(-packed_field_sign(word, field), packed_field_magnitude(word, field)))
+            return trap(TrapCode::index_overflow);
+        increment_pc();
+        return Result<void>::success();
+    });
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_move()
+{
+    return inst.native_M<addressing>().transform_value([this](ValidatedAddress const from){
+        IndexRegister &rI1 = get_register<idx_rI1>();
+        // Read F before copying, since the copy may overwrite the MOVE itself.
+        NativeByte const count = inst.F();
+        for (NativeByte i = 0; i < count; i++)
+        {
+            Result<ValidatedAddress> const source = ValidatedAddress::constructor(from + i);
+            Result<ValidatedAddress> const destination = ValidatedAddress::constructor(rI1.native_value());
+            if (!source || !destination)
+                return trap(TrapCode::invalid_address);
+            memory.store(destination.value(), memory.load(source.value()));
+            invalidate_decoded_instruction(destination.value());
+            rI1.increment(1);
+        }
+        increment_pc();
+        return Result<void>::success();
     });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_st()
 {
-    return inst.MF().transform_value([this](SliceMutable const slice){
-        RegisterT const &reg = this->*reg_member_ptr;
-        reg.store(slice);
+    if (!inst.has_valid_field<addressing>())
+        return Result<void>::failure();
+    PackedField const &field = inst.field<addressing>();
+    return inst.native_M<addressing>().transform_value([this, &field](ValidatedAddress const address){
+        auto const &reg = get_register<reg_idx>();
+        memory.store(address, packed_store_field(memory.load(address), reg.packed_word(), field));
+        invalidate_decoded_instruction(address);
+        increment_pc();
+    });
+}
+
+template <Addressing addressing, bool save_rJ>
+Result<void> Machine::jump_if(bool condition)
+{
+    return inst.native_M<addressing>().transform_value([this, condition](ValidatedAddress const M){
+        if (!condition)
+        {
+            increment_pc();
+            return;
+        }
+        if constexpr (save_rJ)
+            rJ.load(NativeInt(pc + 1));
+        pc = M;
     });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
-void Machine::do_j()
+// There are no devices attached, so a unit is never busy
+template <Addressing addressing>
+Result<void> Machine::do_jbus()
 {
-    
+    return jump_if<addressing>(false);
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Addressing addressing>
+Result<void> Machine::do_jred()
+{
+    return jump_if<addressing>(true);
+}
+
+// IN, OUT and IOC stop the run, and leave the transfer to the host
+#define MACHINE_IO_HANDLER(NAME) \
+template <Addressing addressing> \
+Result<void> Machine::do_##NAME() \
+{ \
+    return inst.native_M<addressing>().transform_value([this](ValidatedAddress const M){ \
+        pending_io.emplace(IoRequest{.op = op_##NAME, .unit = inst.F(), .M = NativeByte(M)}); \
+        pending_stop = StopReason::io_wait; \
+        increment_pc(); \
+    }); \
+}
+
+MACHINE_IO_HANDLER(ioc)
+MACHINE_IO_HANDLER(in)
+MACHINE_IO_HANDLER(out)
+#undef MACHINE_IO_HANDLER
+
+template <Addressing addressing>
+Result<void> Machine::do_jmp()
+{
+    return jump_if<addressing>(true);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jsj()
+{
+    return jump_if<addressing, false>(true);
+}
+
+// JOV and JNOV both turn the overflow toggle off
+template <Addressing addressing>
+Result<void> Machine::do_jov()
+{
+    return jump_if<addressing>(std::exchange(overflow, false));
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jnov()
+{
+    return jump_if<addressing>(!std::exchange(overflow, false));
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jl()
+{
+    return jump_if<addressing>(comparison < 0);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_je()
+{
+    return jump_if<addressing>(comparison == 0);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jg()
+{
+    return jump_if<addressing>(comparison > 0);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jge()
+{
+    return jump_if<addressing>(comparison >= 0);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jne()
+{
+    return jump_if<addressing>(comparison != 0);
+}
+
+template <Addressing addressing>
+Result<void> Machine::do_jle()
+{
+    return jump_if<addressing>(comparison <= 0);
+}
+
+// -0 counts as zero
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jn()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() < 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jz()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() == 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jp()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() > 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jnn()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() >= 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jnz()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() != 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
+Result<void> Machine::do_jnp()
+{
+    return jump_if<addressing>(get_register<reg_idx>().native_value() <= 0);
+}
+
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_inc()
 {
-    return inst.native_M().transform_value([this](NativeInt reg_addend){
-        RegisterT &reg = this->*reg_member_ptr;
+    return inst.native_M<addressing>().transform_value([this](NativeInt reg_addend){
+        auto &reg = get_register<reg_idx>();
         if (reg.increment(reg_addend))
+        {
+            if constexpr (reg_idx != idx_rA && reg_idx != idx_rX)
+                return trap(TrapCode::index_overflow);
             overflow = true;
-    });    
+        }
+        increment_pc();
+        return Result<void>::success();
+    });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_dec()
 {
-    return inst.native_M().transform_value([this](NativeInt const reg_subtractend){
+    return inst.native_M<addressing>().transform_value([this](NativeInt const reg_subtractend){
         NativeInt const reg_addend = -reg_subtractend;
-        RegisterT &reg = this->*reg_member_ptr;
+        auto &reg = get_register<reg_idx>();
         if (reg.increment(reg_addend))
+        {
+            if constexpr (reg_idx != idx_rA && reg_idx != idx_rX)
+                return trap(TrapCode::index_overflow);
             overflow = true;
-    });    
+        }
+        increment_pc();
+        return Result<void>::success();
+    });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_ent()
 {
-    return inst.native_M().transform_value([this](NativeInt const new_reg_value){
-        RegisterT &reg = this->*reg_member_ptr;
+    return inst.native_M<addressing>().transform_value([this](NativeInt const new_reg_value){
+        auto &reg = get_register<reg_idx>();
         if (new_reg_value == 0)
             reg.load_zero(inst.sign());
         else
-            reg.template load<true>(new_reg_value);
-    });    
+            // |M| < 4000 fits in every register
+            reg.load(new_reg_value);
+        increment_pc();
+    });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_enn()
 {
-    return inst.native_M().transform_value([this](NativeInt const M){
-        RegisterT &reg = this->*reg_member_ptr;
+    return inst.native_M<addressing>().transform_value([this](NativeInt const M){
+        auto &reg = get_register<reg_idx>();
         if (M == 0)
             reg.load_zero(-inst.sign());
         else
-            reg.template load<true>(-M);
+            reg.load(-M);
+        increment_pc();
     });
 }
 
-template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+template <Machine::RegisterIdx reg_idx, Addressing addressing>
 Result<void> Machine::do_cmp()
 {
-    return inst.MF().transform_value([this](SliceView const mem_slice){
-        RegisterT const &reg = this->*reg_member_ptr;
-        IntegralContainer<OwnershipKind::view, RegisterT::is_signed_v, RegisterT::size_v> container = reg;
-        SliceView const reg_slice(container, mem_slice.spec);
-        comparison = reg_slice.native_value() <=> mem_slice.native_value();
-    });    
+    if (!inst.has_valid_field<addressing>())
+        return Result<void>::failure();
+    PackedField const &field = inst.field<addressing>();
+    return inst.native_M<addressing>().transform_value([this, &field](ValidatedAddress const address){
+        auto const &reg = get_register<reg_idx>();
+        comparison = packed_field_value(reg.packed_word(), field) <=> packed_field_value(memory.load(address), field);
+        increment_pc();
+    });
+}
+
+Result<void> Machine::do_fcmp()
+{
+    return trap(TrapCode::unimplemented);
+}
+
+constexpr Machine::Handler Machine::handler_functions[h_invalid] = {
+#define OP_VARIANT_FUNCTION_ITERATOR(HANDLER, ...) &Machine::__VA_ARGS__,
+    OP_VARIANT_LIST(OP_VARIANT_FUNCTION_ITERATOR)
+#undef OP_VARIANT_FUNCTION_ITERATOR
+};
+
+template <OpHandler... handlers>
+Result<void> Machine::do_fused()
+{
+    // inst already holds the first instruction, which the superinstruction was decoded from
+    NativeByte completed = 0;
+    auto const step = [this, &completed]<OpHandler handler>() {
+        if (completed > 0)
+            inst.decoded = &decoded_instructions[pc];
+        if (!(this->*handler_functions[handler])()) [[unlikely]]
+            return false;
+        completed++;
+        return true;
+    };
+    if ((step.template operator()<handlers>() && ...)) [[likely]]
+        return Result<void>::success();
+
+    fused_progress.instructions = completed;
+    fused_progress.cycles = 0;
+    for (NativeByte k = 0; k < completed; k++)
+        fused_progress.cycles += decode_instruction(memory.load(ValidatedAddress::trusted_constructor(pc - completed + k).value())).cycles;
+    return Result<void>::failure();
+}
+
+void Machine::fuse_superinstruction(NativeByte const head_address, DecodedInstruction &head)
+{
+    for (Superinstruction const &superinstruction : superinstructions)
+    {
+        if (superinstruction.handlers[0] != head.handler || head_address + superinstruction.length > main_memory_size)
+            continue;
+        NativeByte cycles = head.cycles;
+        NativeByte k = 1;
+        for (; k < superinstruction.length; k++)
+        {
+            NativeByte const address = head_address + k;
+            if (breakpoints[address])
+                break;
+            DecodedInstruction &decoded = decoded_instructions[address];
+            if (decoded.handler == h_undecoded)
+            {
+                decoded = decode_instruction(memory.load(ValidatedAddress::trusted_constructor(address).value()));
+                // An idiom is worth more than the superinstruction that it would be part of
+                recognise_idiom(address, decoded);
+            }
+            if (decoded.handler != superinstruction.handlers[k])
+                break;
+            cycles += decoded.cycles;
+        }
+        if (k == superinstruction.length)
+        {
+            head.handler = superinstruction.handler;
+            head.cycles = std::uint8_t(cycles);
+            head.instructions = std::uint8_t(superinstruction.length);
+            return;
+        }
+    }
+}
+
+void Machine::predecode(NativeByte const address)
+{
+    DecodedInstruction &decoded = decoded_instructions[address];
+    if (!breakpoints[address] && sequence_profile == nullptr && adopt_shared_cell(address))
+        return;
+    decoded = decode_instruction(memory.load(ValidatedAddress::trusted_constructor(address).value()));
+    if (breakpoints[address])
+        decoded.handler = h_breakpoint;
+    else if (sequence_profile == nullptr && !recognise_idiom(address, decoded))
+    {
+        if constexpr (superinstruction_count > 0)
+            fuse_superinstruction(address, decoded);
+    }
+}
+
+// The cells, from the cell itself on, that a decoded cell depends on
+static NativeByte decoded_span(DecodedInstruction const &decoded)
+{
+    // An idiom may be shorter, but do_idiom checks its cells again anyway
+    return decoded.handler == h_idiom ? max_idiom_length : decoded.instructions;
+}
+
+bool Machine::adopt_shared_cell(NativeByte const address)
+{
+    for (auto it = shared_segments.rbegin(); it != shared_segments.rend(); ++it)
+    {
+        SharedSegment const &segment = **it;
+        if (address < segment.origin || address >= segment.origin + segment.words.size())
+            continue;
+        std::optional<DecodedInstruction> const cell = segment.cell(address - segment.origin);
+        if (!cell)
+            return false;
+        DecodedInstruction const &shared = *cell;
+        NativeByte const span = decoded_span(shared);
+        if (address + span > segment.origin + segment.words.size())
+            return false;
+        for (NativeByte k = 0; k < span; k++)
+        {
+            NativeByte const cell = address + k;
+            if (breakpoints[cell] || memory.load(ValidatedAddress::trusted_constructor(cell).value()) != segment.words[cell - segment.origin])
+                return false;
+        }
+        decoded_instructions[address] = shared;
+        // do_fused runs the rest of a superinstruction from their own decoded cells
+        for (NativeByte k = 1; k < shared.instructions; k++)
+        {
+            DecodedInstruction &decoded = decoded_instructions[address + k];
+            if (decoded.handler == h_undecoded)
+                decoded = decode_instruction(segment.words[address + k - segment.origin]);
+        }
+        return true;
+    }
+    return false;
+}
+
+void Machine::share_segment(ValidatedAddress const origin, size_t const count)
+{
+    std::vector<PackedWord> words(count);
+    for (size_t i = 0; i < count; i++)
+        words[i] = memory.load(ValidatedAddress::trusted_constructor(origin + i).value());
+    for (size_t i = 0; i < count; i++)
+        if (breakpoints[origin + i])
+            return;
+
+    std::shared_ptr<SharedSegment const> segment = code_cache->find_or_build(origin, words, [this, origin, &words]() {
+        auto segment = std::make_shared<SharedSegment>();
+        segment->origin = origin;
+        segment->words = words;
+        segment->cells.resize(words.size());
+        NativeByte const end = NativeByte(origin + words.size());
+        for (NativeByte address = origin; address < end; address++)
+        {
+            // Decoded by this machine as it would on the first run, which has just loaded the words and has no breakpoints on them
+            if (decoded_instructions[address].handler == h_undecoded)
+                predecode(address);
+            DecodedInstruction decoded = decoded_instructions[address];
+            if (address + decoded_span(decoded) > end)
+                decoded = decode_instruction(words[address - origin]);
+            segment->cells[address - origin] = decoded;
+        }
+        return segment;
+    });
+    if (segment)
+        shared_segments.push_back(std::move(segment));
+}
+
+std::optional<Idiom> Machine::match_idiom(NativeByte head) const
+{
+    // Decoded afresh, since the cells may be decoded as superinstructions or idioms themselves
+    auto const cell = [this, head](NativeByte k) {
+        return decode_instruction(memory.load(ValidatedAddress::trusted_constructor(head + k).value()));
+    };
+    DecodedInstruction const first = cell(0);
+    Idiom idiom{};
+    switch (first.handler)
+    {
+    case h_stz_indexed_full:
+        idiom.kind = IdiomKind::clear;
+        idiom.length = 3;
+        break;
+    case h_lda_indexed_full:
+    case h_ldx_indexed_full:
+        idiom.kind = IdiomKind::copy;
+        idiom.length = 4;
+        break;
+    case h_cmpa_indexed_full:
+    case h_cmpx_indexed_full:
+        idiom.kind = IdiomKind::search;
+        idiom.length = 4;
+        break;
+    default:
+        return std::nullopt;
+    }
+    if (!first.I() || head + idiom.length > main_memory_size)
+        return std::nullopt;
+    for (NativeByte k = 0; k < idiom.length; k++)
+        if (breakpoints[head + k])
+            return std::nullopt;
+    idiom.index = NativeByte(first.I().value());
+    idiom.source = first.A();
+    idiom.uses_rX = first.handler == h_ldx_indexed_full || first.handler == h_cmpx_indexed_full;
+    idiom.cycles = first.cycles;
+
+    NativeByte const body = idiom.length - 2;
+    if (idiom.kind == IdiomKind::copy)
+    {
+        DecodedInstruction const store = cell(1);
+        if (store.handler != (idiom.uses_rX ? h_stx_indexed_full : h_sta_indexed_full) || !store.I() || store.I().value() != idiom.index)
+            return std::nullopt;
+        idiom.target = store.A();
+        idiom.cycles += store.cycles;
+    }
+    else if (idiom.kind == IdiomKind::search)
+    {
+        DecodedInstruction const found = cell(1);
+        if (found.handler != h_je_direct || !found.direct_M())
+            return std::nullopt;
+        idiom.cycles += found.cycles;
+    }
+    else
+        idiom.target = idiom.source;
+
+    DecodedInstruction const step = cell(body);
+    bool const increments = step.handler == decode_handler(op_inc1 + idiom.index - 1, 0, 0);
+    if (!(increments || step.handler == decode_handler(op_dec1 + idiom.index - 1, 1, 0)) || !step.direct_M() || step.A() == 0)
+        return std::nullopt;
+    idiom.stride = increments ? NativeInt(step.A()) : -NativeInt(step.A());
+
+    DecodedInstruction const jump = cell(body + 1);
+    if (jump.handler == h_invalid || jump.handler != decode_handler(op_j1n + idiom.index - 1, jump.F(), 0)
+        || !jump.direct_M() || jump.direct_M().value() != head)
+        return std::nullopt;
+    idiom.condition = jump.F();
+    idiom.cycles += step.cycles + jump.cycles;
+    return idiom;
+}
+
+bool Machine::recognise_idiom(NativeByte head, DecodedInstruction &decoded) const
+{
+    if (!match_idiom(head))
+        return false;
+    // do_idiom counts the instructions that it runs itself
+    decoded.handler = h_idiom;
+    decoded.instructions = 0;
+    decoded.cycles = 0;
+    return true;
+}
+
+Result<void> Machine::do_idiom()
+{
+    NativeByte const head = pc;
+    // A store into the loop since it was predecoded may have left it no longer an idiom, in which case only its first instruction runs
+    std::optional<Idiom> const idiom = match_idiom(head);
+    NativeByte const length = idiom ? idiom->length : 1;
+    for (NativeByte k = 0; k < length; k++)
+        idiom_instructions[k] = decode_instruction(memory.load(ValidatedAddress::trusted_constructor(head + k).value()));
+
+    RunResult &result = *idiom_result;
+    while (result.instructions < idiom_budget && pc >= head && pc < head + length)
+    {
+        if (idiom && pc == head)
+        {
+            size_t const iterations = run_idiom_in_bulk(*idiom, (idiom_budget - result.instructions) / length);
+            result.instructions += iterations * length;
+            result.cycles += iterations * idiom->cycles;
+        }
+        NativeByte const k = pc - head;
+        inst.decoded = &idiom_instructions[k];
+        // Whether the instruction stores into the loop
+        bool stores_into_loop = false;
+        if (idiom && idiom->kind != IdiomKind::search && k == (idiom->kind == IdiomKind::copy ? 1 : 0))
+        {
+            NativeInt const target = idiom->target + index_registers[idiom->index - 1].native_value();
+            stores_into_loop = target >= head && target < head + length;
+        }
+        NativeByte const cycles = inst.cycles();
+        if (!jump_table()) [[unlikely]]
+            return Result<void>::failure();
+        result.instructions++;
+        result.cycles += cycles;
+        // The loop carries on in the run loop, decoded afresh
+        if (!idiom || stores_into_loop)
+            break;
+    }
+    return Result<void>::success();
+}
+
+size_t Machine::run_idiom_in_bulk(Idiom const &idiom, size_t max_iterations)
+{
+    IndexRegister &index = index_registers[idiom.index - 1];
+    NativeInt const first = index.native_value();
+    PackedWord const key = idiom.uses_rX ? rX.packed_word() : rA.packed_word();
+    PackedField const &full = packed_fields[full_word_field];
+    auto const is_address = [](NativeInt address) {
+        return address >= 0 && address < NativeInt(main_memory_size);
+    };
+
+    // Iterations that go round, without trapping, finding the key or storing into the loop
+    size_t going_round = 0;
+    for (NativeInt value = first; going_round < max_iterations; going_round++)
+    {
+        NativeInt const source = idiom.source + value;
+        NativeInt const target = idiom.target + value;
+        if (!is_address(source))
+            break;
+        if (idiom.kind != IdiomKind::search && (!is_address(target) || (target >= pc && target < pc + idiom.length)))
+            break;
+        if (idiom.kind == IdiomKind::search
+            && packed_field_value(key, full) == packed_field_value(memory.load(ValidatedAddress::trusted_constructor(source).value()), full))
+            break;
+        NativeInt const next = value + idiom.stride;
+        if (next < -(lut[2] - 1) || next > lut[2] - 1 || !index_condition_holds(idiom.condition, next))
+            break;
+        value = next;
+    }
+    // The last one runs one instruction at a time, which leaves the registers and comparison indicator as the loop would
+    if (going_round < 2)
+        return 0;
+    size_t const iterations = going_round - 1;
+    NativeInt const last = first + NativeInt(iterations - 1) * idiom.stride;
+
+    if (idiom.kind != IdiomKind::search)
+    {
+        auto const address = [](NativeInt address) {
+            return ValidatedAddress::trusted_constructor(address).value();
+        };
+        NativeInt const lowest = std::min(first, last);
+        bool const contiguous = idiom.stride == 1 || idiom.stride == -1;
+        if (idiom.kind == IdiomKind::clear && contiguous)
+            memory.fill(address(idiom.target + lowest), iterations, rZ.packed_word());
+        else if (idiom.kind == IdiomKind::copy && contiguous
+                 && !((idiom.target - idiom.source) * idiom.stride > 0 && (idiom.target - idiom.source) * idiom.stride < NativeInt(iterations)))
+            // No iteration reads a cell that an earlier one writes, so copying them all at once is the same
+            memory.move(address(idiom.target + lowest), address(idiom.source + lowest), iterations);
+        else
+        {
+            for (NativeInt value = first, j = 0; j < NativeInt(iterations); j++, value += idiom.stride)
+            {
+                PackedWord const word = idiom.kind == IdiomKind::clear ? rZ.packed_word() : memory.load(address(idiom.source + value));
+                memory.store(address(idiom.target + value), word);
+            }
+        }
+        for (NativeInt value = first, j = 0; j < NativeInt(iterations); j++, value += idiom.stride)
+            invalidate_decoded_instruction(address(idiom.target + value));
+    }
+
+    index.load(first + NativeInt(iterations) * idiom.stride);
+    // Left by the jump back
+    rJ.load(NativeInt(pc + idiom.length));
+    return iterations;
 }
 
 Result<void> Machine::jump_table()
 {
-    switch (inst.C())
+    switch (inst.handler())
     {
-#define DISPATCH8(base) \
-    case base * 8 + 0: \
-        dispatch_by_op_code<base * 8 + 0>(); break; \
-    case base * 8 + 1: \
-        dispatch_by_op_code<base * 8 + 1>(); break; \
-    case base * 8 + 2: \
-        dispatch_by_op_code<base * 8 + 2>(); break; \
-    case base * 8 + 3: \
-        dispatch_by_op_code<base * 8 + 3>(); break; \
-    case base * 8 + 4: \
-        dispatch_by_op_code<base * 8 + 4>(); break; \
-    case base * 8 + 5: \
-        dispatch_by_op_code<base * 8 + 5>(); break; \
-    case base * 8 + 6: \
-        dispatch_by_op_code<base * 8 + 6>(); break; \
-    case base * 8 + 7: \
-        dispatch_by_op_code<base * 8 + 7>(); break; \
-
-
-    DISPATCH8(0);
-    DISPATCH8(1);
-    DISPATCH8(2);
-    DISPATCH8(3);
-    DISPATCH8(4);
-    DISPATCH8(5);
-    DISPATCH8(6);
-    DISPATCH8(7);
+#define OP_VARIANT_DISPATCH_ITERATOR(HANDLER, ...) \
+    case HANDLER: \
+        return __VA_ARGS__();
+
+    OP_VARIANT_LIST(OP_VARIANT_DISPATCH_ITERATOR)
+
+#undef OP_VARIANT_DISPATCH_ITERATOR
+#define SUPERINSTRUCTION_DISPATCH_ITERATOR(NAME, ...) \
+    case h_##NAME: \
+        return do_fused<__VA_ARGS__>();
+
+    SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_DISPATCH_ITERATOR)
+
+#undef SUPERINSTRUCTION_DISPATCH_ITERATOR
+    case h_idiom:
+        return do_idiom();
     default:
-        // Bad op code
+        // Bad op code, or bad field for the op code
         return Result<void>::failure();
     }
-#undef DISPATCH8
+}
 
-    return Result<void>::success();
+RunResult Machine::run_jump_table(size_t budget)
+{
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    idiom_result = &result;
+    idiom_budget = budget;
+    while (result.instructions < budget)
+    {
+        update_current_instruction();
+        NativeByte const instructions = inst.instructions();
+        if constexpr (superinstruction_count > 0)
+        {
+            if (instructions > budget - result.instructions) [[unlikely]]
+            {
+                if (step_plain_into(result))
+                    return result;
+                continue;
+            }
+        }
+        NativeByte const cycles = inst.cycles();
+        if (!jump_table()) [[unlikely]]
+        {
+            if (inst.handler() == h_breakpoint)
+                result.reason = StopReason::breakpoint;
+            else
+            {
+                result.reason = StopReason::trap;
+                result.trap = record_trap();
+                result.instructions += fused_progress.instructions;
+                result.cycles += fused_progress.cycles;
+                fused_progress = {};
+            }
+            return result;
+        }
+        result.instructions += instructions;
+        result.cycles += cycles;
+        if (pending_stop) [[unlikely]]
+        {
+            result.reason = *pending_stop;
+            return result;
+        }
+    }
+    return result;
 }
 
-template <NativeByte op_code>
-void Machine::dispatch_by_op_code()
+// Every handler ends with its own copy of the fetch and indirect jump,
+// so that the host branch predictor can learn which handler tends to follow which.
+template <bool count_heat>
+RunResult Machine::run_threaded(size_t budget)
 {
-#define OP_LIST_DISPATCH_ITERATOR(OP_NAME, OP_CODE, FUNC) \
-    if constexpr(op_code == OP_CODE) \
+    static void *const handler_labels[] = {
+#define OP_VARIANT_LABEL_ITERATOR(HANDLER, ...) &&label_##HANDLER,
+        OP_VARIANT_LIST(OP_VARIANT_LABEL_ITERATOR)
+#undef OP_VARIANT_LABEL_ITERATOR
+        &&label_invalid,
+        &&label_breakpoint,
+        &&label_idiom,
+#define SUPERINSTRUCTION_LABEL_ITERATOR(NAME, ...) &&label_h_##NAME,
+        SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_LABEL_ITERATOR)
+#undef SUPERINSTRUCTION_LABEL_ITERATOR
+    };
+    static_assert(std::size(handler_labels) == h_idiom + 1 + superinstruction_count);
+
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    idiom_result = &result;
+    idiom_budget = budget;
+    // Where the last instruction started, so that a jump back to it or before it is seen as a back-edge.
+    // None at first, so that the cell that the run starts on is not counted.
+    NativeInt address = -1;
+
+#define DISPATCH_NEXT() \
+    if (result.instructions == budget) \
+        return result; \
+    if constexpr (count_heat) \
     { \
-        FUNC(); \
-        return; \
-    }
+        if (NativeInt(pc) <= address && ++heat[pc] >= tier_up_threshold) [[unlikely]] \
+            return result; \
+        address = pc; \
+    } \
+    update_current_instruction(); \
+    goto *handler_labels[inst.handler()];
+
+    DISPATCH_NEXT();
+
+#define OP_VARIANT_THREADED_ITERATOR(HANDLER, ...) \
+label_##HANDLER: \
+    { \
+        NativeByte const cycles = inst.cycles(); \
+        if (!__VA_ARGS__()) [[unlikely]] \
+            goto label_invalid; \
+        result.instructions++; \
+        result.cycles += cycles; \
+    } \
+    if (pending_stop) [[unlikely]] \
+    { \
+        result.reason = *pending_stop; \
+        return result; \
+    } \
+    DISPATCH_NEXT();
 
-#define OP_LIST_FIELD_DISPATCH_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC) \
-    if constexpr(op_code == OP_CODE) \
+    OP_VARIANT_LIST(OP_VARIANT_THREADED_ITERATOR)
+
+#undef OP_VARIANT_THREADED_ITERATOR
+
+#define SUPERINSTRUCTION_THREADED_ITERATOR(NAME, ...) \
+label_h_##NAME: \
     { \
-        if (inst.F() == OP_FIELD)\
+        NativeByte const instructions = inst.instructions(); \
+        if (instructions > budget - result.instructions) [[unlikely]] \
         { \
-            FUNC(); \
-            return; \
+            if (step_plain_into(result)) \
+                return result; \
+            DISPATCH_NEXT(); \
         } \
+        NativeByte const cycles = inst.cycles(); \
+        if (!do_fused<__VA_ARGS__>()) [[unlikely]] \
+            goto label_invalid; \
+        result.instructions += instructions; \
+        result.cycles += cycles; \
+    } \
+    if (pending_stop) [[unlikely]] \
+    { \
+        result.reason = *pending_stop; \
+        return result; \
+    } \
+    DISPATCH_NEXT();
+
+    SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_THREADED_ITERATOR)
+
+#undef SUPERINSTRUCTION_THREADED_ITERATOR
+
+label_idiom:
+    if (!do_idiom()) [[unlikely]]
+        goto label_invalid;
+    DISPATCH_NEXT();
+
+#undef DISPATCH_NEXT
+
+label_invalid:
+    // Bad op code, bad field for the op code, or an operand out of range
+    result.reason = StopReason::trap;
+    result.trap = record_trap();
+    result.instructions += fused_progress.instructions;
+    result.cycles += fused_progress.cycles;
+    fused_progress = {};
+    return result;
+
+label_breakpoint:
+    result.reason = StopReason::breakpoint;
+    return result;
+}
+
+Machine::JitThunk const Machine::jit_thunks[h_invalid] = {
+#define OP_VARIANT_JIT_THUNK_ITERATOR(HANDLER, ...) \
+    [](Machine &m) { return m.jit_status(m.__VA_ARGS__()); },
+
+    OP_VARIANT_LIST(OP_VARIANT_JIT_THUNK_ITERATOR)
+
+#undef OP_VARIANT_JIT_THUNK_ITERATOR
+};
+
+JitStatus Machine::jit_status(Result<void> result)
+{
+    if (!result) [[unlikely]]
+        return JitStatus::trap;
+    if (pending_stop || translated_code_invalidated) [[unlikely]]
+        return JitStatus::leave;
+    return JitStatus::next;
+}
+
+RunResult Machine::run_tiered(size_t budget)
+{
+    if constexpr (!jit_supported)
+        return run_threaded(budget);
+
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    while (result.instructions < budget)
+    {
+        NativeByte const start = pc;
+        RunResult stretch;
+        if (is_hot(start))
+        {
+            if (!jit)
+                jit = std::make_unique<Jit>(*this);
+            if (!jit->has_code_buffer())
+            {
+                tier_up_threshold = std::numeric_limits<std::uint32_t>::max();
+                continue;
+            }
+            stretch = jit->run(budget - result.instructions, true);
+            // The block cannot be translated, e.g. it has a breakpoint on it, so the cell starts over as cold
+            if (stretch.instructions == 0 && stretch.reason == StopReason::budget)
+            {
+                heat[start] = 0;
+                continue;
+            }
+            // Translated code that keeps leaving for the same cell gets that cell hot too
+            if (pc < main_memory_size)
+                heat[pc]++;
+        }
+        else
+            stretch = run_threaded<true>(budget - result.instructions);
+        result.instructions += stretch.instructions;
+        result.cycles += stretch.cycles;
+        if (stretch.reason != StopReason::budget)
+        {
+            result.reason = stretch.reason;
+            result.trap = stretch.trap;
+            return result;
+        }
     }
+    return result;
+}
 
-#define OP_LIST_REGISTER_DISPATCH_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER) \
-    if constexpr(op_code == OP_CODE) \
-    { \
-        FUNC<decltype(std::declval<Machine>().REGISTER), &Machine::REGISTER>(); \
-        return; \
+RunResult Machine::run_profiled(size_t budget)
+{
+    RunResult result{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    sequence_profile->break_sequence();
+    while (result.instructions < budget)
+    {
+        update_current_instruction();
+        NativeByte const address = pc;
+        OpHandler const handler = inst.handler();
+        NativeByte const cycles = inst.cycles();
+        if (!jump_table()) [[unlikely]]
+        {
+            if (handler == h_breakpoint)
+                result.reason = StopReason::breakpoint;
+            else
+            {
+                result.reason = StopReason::trap;
+                result.trap = record_trap();
+            }
+            return result;
+        }
+        sequence_profile->record(address, handler);
+        result.instructions++;
+        result.cycles += cycles;
+        if (pending_stop) [[unlikely]]
+        {
+            result.reason = *pending_stop;
+            return result;
+        }
     }
+    return result;
+}
 
-#define OP_LIST_FIELD_REGISTER_DISPATCH_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER) \
-    if constexpr(op_code == OP_CODE) \
-    { \
-        if (inst.F() == OP_FIELD) \
-        { \
-            FUNC<decltype(std::declval<Machine>().REGISTER), &Machine::REGISTER>(); \
-            return; \
-        } \
+RunResult Machine::run_jit(size_t budget)
+{
+    if (!jit)
+        jit = std::make_unique<Jit>(*this);
+    if (!jit->has_code_buffer())
+        return run_threaded(budget);
+    return jit->run(budget);
+}
+
+RunResult Machine::step_plain()
+{
+    // Only called on a breakpoint, which is within memory
+    DecodedInstruction const decoded = decode_instruction(memory.load(ValidatedAddress::trusted_constructor(pc).value()));
+    inst.decoded = &decoded;
+    if (!jump_table())
+        return {.reason = StopReason::trap, .trap = record_trap(), .instructions = 0, .cycles = 0};
+    return {.reason = pending_stop.value_or(StopReason::budget), .trap = {}, .instructions = 1, .cycles = decoded.cycles};
+}
+
+bool Machine::step_plain_into(RunResult &result)
+{
+    RunResult const plain = step_plain();
+    result.instructions += plain.instructions;
+    result.cycles += plain.cycles;
+    if (plain.reason == StopReason::budget)
+        return false;
+    result.reason = plain.reason;
+    result.trap = plain.trap;
+    return true;
+}
+
+Trap Machine::record_trap()
+{
+    if (trap_record.code == TrapCode::none)
+    {
+        // The handler failed on something common to all instructions, checked here in the order that decoding hits them
+        if (inst.handler() == h_invalid)
+            trap_record.code = TrapCode::invalid_instruction;
+        else if (!inst.I())
+            trap_record.code = TrapCode::invalid_index;
+        else if (!inst.native_M())
+            trap_record.code = TrapCode::invalid_address;
+        else
+            trap_record.code = TrapCode::invalid_field;
+    }
+    trap_record.pc = pc;
+    return trap_record;
+}
+
+Machine::Machine()
+{
+    DecodedInstruction past_the_end = decode_instruction(0);
+    past_the_end.handler = h_invalid;
+    decoded_instructions.back() = past_the_end;
+}
+
+Machine::~Machine() = default;
+
+void Machine::reset()
+{
+    pc = 0;
+    rA.load_zero(s_plus);
+    for (IndexRegister &rI : index_registers)
+        rI.load_zero(s_plus);
+    rX.load_zero(s_plus);
+    rJ.load_zero(s_plus);
+    pending_stop.reset();
+    pending_io.reset();
+    trap_record = {.code = TrapCode::none, .pc = 0};
+    overflow = false;
+    comparison = std::strong_ordering::equal;
+    memory.fill(ValidatedAddress::trusted_constructor(0).value(), main_memory_size, pack_sign(s_plus));
+    // The entry past the end of memory stays h_invalid
+    for (size_t address = 0; address < main_memory_size; address++)
+        decoded_instructions[address] = {};
+    breakpoints.reset();
+    shared_segments.clear();
+    jit.reset();
+    heat.fill(0);
+    fused_progress = {};
+    translated_code_invalidated = false;
+    dirty_cells.fill(0);
+    snapshot_serial = 0;
+}
+
+MachineSnapshot Machine::snapshot()
+{
+    snapshot_serial = new_snapshot_serial();
+    dirty_cells.fill(0);
+    return MachineSnapshot{
+        .serial = snapshot_serial,
+        .pc = pc,
+        .rA = rA,
+        .index_registers = index_registers,
+        .rX = rX,
+        .rJ = rJ,
+        .overflow = overflow,
+        .comparison = comparison,
+        .pending_io = pending_io,
+        .memory = memory,
+        .shared_segments = shared_segments,
+    };
+}
+
+template <class WordAt>
+void Machine::restore_cells(std::uint64_t const serial, WordAt const &word_at)
+{
+    auto const restore_cell = [this, &word_at](size_t const cell) {
+        ValidatedAddress const address = ValidatedAddress::trusted_constructor(cell).value();
+        PackedWord const word = word_at(address);
+        if (memory.load(address) != word)
+        {
+            memory.store(address, word);
+            invalidate_decoded_instruction(address);
+        }
+    };
+    // A serial of 0 keeps track of no cells, e.g. that of MachineBatch::snapshot
+    if (serial != 0 && serial == snapshot_serial)
+    {
+        for (size_t i = 0; i < dirty_cells.size(); i++)
+            for (std::uint64_t cells = dirty_cells[i]; cells != 0; cells &= cells - 1)
+                restore_cell(i * 64 + std::countr_zero(cells));
+    }
+    else
+    {
+        for (size_t cell = 0; cell < main_memory_size; cell++)
+            restore_cell(cell);
+    }
+    // Rewriting the cells marked them again
+    dirty_cells.fill(0);
+    snapshot_serial = serial;
+    translated_code_invalidated = false;
+}
+
+void Machine::restore(MachineSnapshot const &snapshot)
+{
+    pc = snapshot.pc;
+    rA = snapshot.rA;
+    index_registers = snapshot.index_registers;
+    rX = snapshot.rX;
+    rJ = snapshot.rJ;
+    overflow = snapshot.overflow;
+    comparison = snapshot.comparison;
+    pending_stop.reset();
+    pending_io = snapshot.pending_io;
+    trap_record = {.code = TrapCode::none, .pc = 0};
+    fused_progress = {};
+    // Copying the same segments again would only bounce their reference counts between the threads that share them
+    if (shared_segments != snapshot.shared_segments)
+        shared_segments = snapshot.shared_segments;
+    restore_cells(snapshot.serial, [&snapshot](ValidatedAddress const address) {
+        return snapshot.memory.load(address);
+    });
+}
+
+void Machine::restore(SnapshotFile const &file)
+{
+    SnapshotFileHeader const &header = file.header();
+    // map checked that every register holds a word that fits in it
+    pc = header.pc;
+    rA.load(unpack(header.registers[0]));
+    for (size_t i = 0; i < index_registers.size(); i++)
+        index_registers[i].load(unpack(header.registers[1 + i]));
+    rX.load(unpack(header.registers[7]));
+    rJ.load(unpack(header.registers[8]));
+    overflow = header.overflow != 0;
+    comparison = header.comparison < 0 ? std::strong_ordering::less
+        : header.comparison > 0 ? std::strong_ordering::greater
+        : std::strong_ordering::equal;
+    pending_stop.reset();
+    // map checked that an I/O instruction has the op code of one and an address in memory
+    pending_io.reset();
+    if (header.io_op != 0)
+        pending_io.emplace(IoRequest{.op = OpCode(header.io_op), .unit = NativeByte(header.io_unit), .M = NativeByte(header.io_M)});
+    trap_record = {.code = TrapCode::none, .pc = 0};
+    fused_progress = {};
+    restore_cells(file.serial(), [words = file.memory()](ValidatedAddress const address) {
+        return words[address];
+    });
+}
+
+RunResult Machine::run(size_t budget)
+{
+    pending_stop.reset();
+    pending_io.reset();
+    trap_record = {.code = TrapCode::none, .pc = 0};
+
+    RunResult first{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0};
+    if (budget > 0 && pc < main_memory_size && breakpoints[pc])
+    {
+        first = step_plain();
+        if (first.reason != StopReason::budget)
+            return first;
+        budget--;
     }
 
-    OP_LIST(OP_LIST_DISPATCH_ITERATOR, OP_LIST_FIELD_DISPATCH_ITERATOR, OP_LIST_REGISTER_DISPATCH_ITERATOR, OP_LIST_FIELD_REGISTER_DISPATCH_ITERATOR)
+    RunResult rest{};
+    if (aot)
+        rest = aot->run(budget);
+    else if (sequence_profile)
+        rest = run_profiled(budget);
+    else
+    {
+        switch (dispatch_engine)
+        {
+        case DispatchEngine::jump_table:
+            rest = run_jump_table(budget);
+            break;
+        case DispatchEngine::threaded:
+            rest = run_threaded(budget);
+            break;
+        case DispatchEngine::jit:
+            rest = run_jit(budget);
+            break;
+        case DispatchEngine::tiered:
+            rest = run_tiered(budget);
+            break;
+        }
+    }
+    rest.instructions += first.instructions;
+    rest.cycles += first.cycles;
+    return rest;
+}
 
-#undef OP_LIST_DISPATCH_ITERATOR
+RunResult Machine::step()
+{
+    return run(1);
+}
+
+void Machine::load_word(ValidatedAddress address, std::span<Byte const, bytes_in_word> word)
+{
+    memory.store(address, pack(word));
+    invalidate_decoded_instruction(address);
+}
+
+std::array<Byte, bytes_in_word> Machine::read_word(ValidatedAddress address) const
+{
+    return unpack(memory.load(address));
+}
+
+Result<void> Machine::load_program(ValidatedAddress origin, std::span<std::array<Byte, bytes_in_word> const> words, ValidatedAddress entry_point)
+{
+    if (words.size() > main_memory_size - origin)
+        return Result<void>::failure();
+    for (size_t i = 0; i < words.size(); i++)
+        load_word(ValidatedAddress::trusted_constructor(origin + i).value(), words[i]);
+    if (code_cache != nullptr && sequence_profile == nullptr && !words.empty())
+        share_segment(origin, words.size());
+    pc = entry_point;
+    return Result<void>::success();
+}
+
+void Machine::predecode_all()
+{
+    for (NativeByte address = 0; address < main_memory_size; address++)
+        if (decoded_instructions[address].handler == h_undecoded)
+            predecode(address);
+}
+
+void Machine::set_breakpoint(ValidatedAddress address)
+{
+    breakpoints.set(address);
+    invalidate_decoded_instruction(address);
+}
+
+void Machine::clear_breakpoint(ValidatedAddress address)
+{
+    breakpoints.reset(address);
+    invalidate_decoded_instruction(address);
 }
 
-void Machine::step()
+void Machine::set_sequence_profile(SequenceProfile *profile)
 {
-    jump_table();
+    sequence_profile = profile;
+    // Drops the superinstructions decoded so far, or lets them be decoded again
+    for (size_t address = 0; address < main_memory_size; address++)
+        decoded_instructions[address] = {};
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -1,11 +1,23 @@
 #pragma once
 #include <base/base.h>
+#include <vm/op_list.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 class Machine;
+struct MachineSnapshot;
+class SnapshotFile;
+class MachineBatch;
+class AotRuntime;
 struct Op;
 
+MIX_END_BYTE_SIZE_NAMESPACE
+
+class SequenceProfile;
+
+// The rest does not depend on byte_size, and is shared by the simulators of every byte size
+
 enum class CompareResult
 {
     less,
@@ -13,4 +25,94 @@ enum class CompareResult
     greater,
 };
 
+// The interpreter loop used by Machine::run
+enum class DispatchEngine
+{
+    // One switch over the decoded handler per instruction
+    jump_table,
+    // Labels-as-values dispatch with an indirect jump at the end of every handler
+    threaded,
+    // Basic blocks translated to host code, see vm/jit.h.
+    // Runs as threaded where the host is not x86-64.
+    jit,
+    // Threaded, handing the loops that get hot to the JIT, see Machine::run_tiered.
+    // Runs as threaded where the host is not x86-64.
+    tiered,
+};
+
+// Times that DispatchEngine::tiered reaches a cell before translating the block that starts there,
+// high enough that a short program finishes without translating anything
+constexpr std::uint32_t default_tier_up_threshold = 1000;
+
+// Why an instruction trapped
+enum class TrapCode : NativeByte
+{
+    none,
+    // Unknown op code, or an F that the op code does not accept
+    invalid_instruction,
+    // I is greater than 6
+    invalid_index,
+    // M, or an address derived from it, is outside of memory
+    invalid_address,
+    // F is not a field (L:R) with L <= R <= 5
+    invalid_field,
+    // The result does not fit in an index register, which MIX leaves undefined
+    index_overflow,
+    // Floating point instructions are not supported yet
+    unimplemented,
+};
+
+struct Trap
+{
+    TrapCode code;
+    // Address of the instruction that trapped
+    NativeByte pc;
+};
+
+// Why Machine::run returned
+enum class StopReason : NativeByte
+{
+    // HLT was executed
+    halted,
+    // An instruction could not be executed, see RunResult::trap
+    trap,
+    // The next instruction has a breakpoint on it
+    breakpoint,
+    // IN, OUT or IOC is waiting for the host to run the device, see Machine::io_request
+    io_wait,
+    // The instruction budget ran out
+    budget,
+};
+
+struct RunResult
+{
+    StopReason reason;
+    // Only meaningful when reason is StopReason::trap
+    Trap trap;
+    // Instructions completed during the run
+    size_t instructions;
+    // Execution time of those instructions in units of u
+    size_t cycles;
+};
+
+// An I/O instruction left for the host to carry out
+struct IoRequest
+{
+    OpCode op;
+    // F, the unit number
+    NativeByte unit;
+    // The buffer address
+    NativeByte M;
+};
+
+// How far the job that a machine runs has got, which a snapshot file carries along with the machine
+struct SnapshotCounters
+{
+    // Instructions completed, and their execution time in units of u, since the job started
+    std::uint64_t instructions;
+    std::uint64_t cycles;
+    // Words of the input deck that the card reader has read so far
+    std::uint64_t next_card;
+};
+
 }
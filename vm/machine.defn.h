@@ -1,96 +1,59 @@
 #pragma once
 #include <base/base.h>
 #include <vm/machine.decl.h>
+#include <vm/code_cache.h>
 #include <vm/register.defn.h>
 #include <vm/instruction.defn.h>
+#include <vm/idiom.h>
+#include <vm/jit.decl.h>
+#include <vm/memory.defn.h>
+#include <vm/op_list.h>
+
+#include <atomic>
+#include <bitset>
+#include <memory>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
-#define OP_LIST(IT, IT_FIELD, IT_REGISTER, IT_FIELD_REGISTER) \
-    IT(nop, 0, do_nop) \
-    IT(add, 1, do_add) IT(fadd, 1, do_add) \
-    IT(sub, 2, do_sub) IT(fsub, 2, do_sub) \
-    IT(mul, 3, do_mul) IT(fmul, 3, do_mul) \
-    IT(div, 4, do_div) IT(fdiv, 4, do_div) \
-    IT_FIELD(num, 5, 0, do_num) IT_FIELD(char, 5, 1, do_char) IT_FIELD(hlt, 5, 2, do_hlt) \
-    IT_FIELD(sla, 6, 0, do_sla) IT_FIELD(sra, 6, 1, do_sra) IT_FIELD(slax, 6, 2, do_slax) IT_FIELD(srax, 6, 3, do_srax) IT_FIELD(slc, 6, 4, do_slc) IT_FIELD(src, 6, 5, do_src) \
-    IT(move, 7, do_move) \
-    IT_REGISTER(lda, 8, do_ld, rA) \
-    IT_REGISTER(ld1, 9, do_ld, rI1) \
-    IT_REGISTER(ld2, 10, do_ld, rI2) \
-    IT_REGISTER(ld3, 11, do_ld, rI3) \
-    IT_REGISTER(ld4, 12, do_ld, rI4) \
-    IT_REGISTER(ld5, 13, do_ld, rI5) \
-    IT_REGISTER(ld6, 14, do_ld, rI6) \
-    IT_REGISTER(ldx, 15, do_ld, rX) \
-    IT_REGISTER(ldan, 16, do_ldn, rA) \
-    IT_REGISTER(ld1n, 17, do_ldn, rI1) \
-    IT_REGISTER(ld2n, 18, do_ldn, rI2) \
-    IT_REGISTER(ld3n, 19, do_ldn, rI3) \
-    IT_REGISTER(ld4n, 20, do_ldn, rI4) \
-    IT_REGISTER(ld5n, 21, do_ldn, rI5) \
-    IT_REGISTER(ld6n, 22, do_ldn, rI6) \
-    IT_REGISTER(ldxn, 23, do_ldn, rX) \
-    IT_REGISTER(sta, 24, do_st, rA) \
-    IT_REGISTER(st1, 25, do_st, rI1) \
-    IT_REGISTER(st2, 26, do_st, rI2) \
-    IT_REGISTER(st3, 27, do_st, rI3) \
-    IT_REGISTER(st4, 28, do_st, rI4) \
-    IT_REGISTER(st5, 29, do_st, rI5) \
-    IT_REGISTER(st6, 30, do_st, rI6) \
-    IT_REGISTER(stx, 31, do_st, rX) \
-    IT_REGISTER(stj, 32, do_st, rJ) \
-    IT_REGISTER(stz, 33, do_st, rZ) \
-    IT(jbus, 34, do_jbus) \
-    IT(ioc, 35, do_ioc) \
-    IT(in, 36, do_in) \
-    IT(out, 37, do_out) \
-    IT(jred, 38, do_jred) \
-    IT_FIELD(jmp, 39, 0, do_jmp) IT_FIELD(jsj, 39, 1, do_jsj) IT_FIELD(jov, 39, 2, do_jov) IT_FIELD(jnov, 39, 3, do_jnov) \
-    IT_REGISTER(ja, 40, do_j, rA) \
-    IT_REGISTER(j1, 41, do_j, rI1) \
-    IT_REGISTER(j2, 42, do_j, rI2) \
-    IT_REGISTER(j3, 43, do_j, rI3) \
-    IT_REGISTER(j4, 44, do_j, rI4) \
-    IT_REGISTER(j5, 45, do_j, rI5) \
-    IT_REGISTER(j6, 46, do_j, rI6) \
-    IT_REGISTER(jx, 47, do_j, rX) \
-    IT_FIELD_REGISTER(inca, 48, 0, do_inc, rA) IT_FIELD_REGISTER(deca, 48, 1, do_dec, rA) IT_FIELD_REGISTER(enta, 48, 2, do_ent, rA) IT_FIELD_REGISTER(enna, 48, 3, do_enn, rA) \
-    IT_FIELD_REGISTER(inc1, 49, 0, do_inc, rI1) IT_FIELD_REGISTER(dec1, 49, 1, do_dec, rI1) IT_FIELD_REGISTER(ent1, 49, 2, do_ent, rI1) IT_FIELD_REGISTER(enn1, 49, 3, do_enn, rI1) \
-    IT_FIELD_REGISTER(inc2, 50, 0, do_inc, rI2) IT_FIELD_REGISTER(dec2, 50, 1, do_dec, rI2) IT_FIELD_REGISTER(ent2, 50, 2, do_ent, rI2) IT_FIELD_REGISTER(enn2, 50, 3, do_enn, rI2) \
-    IT_FIELD_REGISTER(inc3, 51, 0, do_inc, rI3) IT_FIELD_REGISTER(dec3, 51, 1, do_dec, rI3) IT_FIELD_REGISTER(ent3, 51, 2, do_ent, rI3) IT_FIELD_REGISTER(enn3, 51, 3, do_enn, rI3) \
-    IT_FIELD_REGISTER(inc4, 52, 0, do_inc, rI4) IT_FIELD_REGISTER(dec4, 52, 1, do_dec, rI4) IT_FIELD_REGISTER(ent4, 52, 2, do_ent, rI4) IT_FIELD_REGISTER(enn4, 52, 3, do_enn, rI4) \
-    IT_FIELD_REGISTER(inc5, 53, 0, do_inc, rI5) IT_FIELD_REGISTER(dec5, 53, 1, do_dec, rI5) IT_FIELD_REGISTER(ent5, 53, 2, do_ent, rI5) IT_FIELD_REGISTER(enn5, 53, 3, do_enn, rI5) \
-    IT_FIELD_REGISTER(inc6, 54, 0, do_inc, rI6) IT_FIELD_REGISTER(dec6, 54, 1, do_dec, rI6) IT_FIELD_REGISTER(ent6, 54, 2, do_ent, rI6) IT_FIELD_REGISTER(enn6, 54, 3, do_enn, rI6) \
-    IT_FIELD_REGISTER(incx, 55, 0, do_inc, rX) IT_FIELD_REGISTER(decx, 55, 1, do_dec, rX) IT_FIELD_REGISTER(entx, 55, 2, do_ent, rX) IT_FIELD_REGISTER(ennx, 55, 3, do_enn, rX) \
-    IT_REGISTER(cmpa, 56, do_cmp, rA) IT_REGISTER(fcmp, 56, do_cmp, rA) \
-    IT_REGISTER(cmp1, 57, do_cmp, rI1) \
-    IT_REGISTER(cmp2, 58, do_cmp, rI2) \
-    IT_REGISTER(cmp3, 59, do_cmp, rI3) \
-    IT_REGISTER(cmp4, 60, do_cmp, rI4) \
-    IT_REGISTER(cmp5, 61, do_cmp, rI5) \
-    IT_REGISTER(cmp6, 62, do_cmp, rI6) \
-    IT_REGISTER(cmpx, 63, do_cmp, rX) 
-
-enum OpCode : NativeByte 
+// A serial that no snapshot, of any machine, nor any mapped snapshot file has had yet,
+// which is how Machine::restore knows whether the cells written since a snapshot are all that it has to copy back
+inline std::uint64_t new_snapshot_serial()
 {
-#define OP_LIST_ENUM_ITERATOR(OP_NAME, OP_CODE, ...) op_##OP_NAME = OP_CODE,
-    OP_LIST(OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR)
-#undef OP_LIST_ENUM_ITERATOR
-    op_max,
-};
+    static std::atomic<std::uint64_t> serials_taken = 0;
+    return serials_taken.fetch_add(1, std::memory_order_relaxed) + 1;
+}
 
-static_assert(op_max == minimum_byte_size);
+// The state of a machine as Machine::snapshot took it, which Machine::restore puts a machine back into
+struct MachineSnapshot
+{
+    // Tells Machine::restore whether the machine has kept track of the cells written since the snapshot
+    std::uint64_t serial;
+    NativeByte pc;
+    NumberRegister rA;
+    std::array<IndexRegister, 6> index_registers;
+    NumberRegister rX;
+    JumpRegister rJ;
+    bool overflow;
+    std::strong_ordering comparison;
+    // The I/O instruction that the machine was stopped on, unless the host has carried it out
+    std::optional<IoRequest> pending_io;
+    Memory memory;
+    std::vector<std::shared_ptr<SharedSegment const>> shared_segments;
+};
 
 // Represents the MIX machine state
 class Machine
 {
     friend class Instruction;
+    friend class Jit;
+    friend class AotRuntime;
+    friend class MachineBatch;
     template <bool, size_t> 
     friend struct Register;
 
-    // program counter
-    NativeByte pc;
+    // program counter, as a word address
+    NativeByte pc = 0;
     
 #define REGISTER_LIST(IT, ...) /* ... are additional args */ \
     IT(NumberRegister, rA, __VA_ARGS__) \
@@ -105,12 +68,6 @@ class Machine
     IT(ZeroRegister, rZ, __VA_ARGS__)
 
 
-#define REGISTER_DECLARATION_ITERATOR(TYPE, REG, ...) TYPE REG;
-    REGISTER_LIST(REGISTER_DECLARATION_ITERATOR)
-    
-#undef REGISTER_DECLARATION_ITERATOR
-    ExtendedRegister rAX{rA, rX};
-
     enum RegisterIdx
     {
 #define REGISTER_ENUM_ITERATOR(TYPE, REG, ...) idx_##REG,
@@ -118,21 +75,139 @@ class Machine
 #undef REGISTER_ENUM_ITERATOR
     };
 
-    std::array<IndexRegister, 6> index_registers = { rI1, rI2, rI3, rI4, rI5, rI6 };
+    NumberRegister rA;
+    // rI1 to rI6 are stored once, contiguously, so that rIi can be looked up by i
+    std::array<IndexRegister, 6> index_registers;
+    NumberRegister rX;
+    JumpRegister rJ;
+    ZeroRegister rZ;
+    ExtendedRegister rAX{rA, rX};
+
+    // Set by a handler that ends the run once it completes, e.g. HLT
+    std::optional<StopReason> pending_stop;
+
+    std::optional<IoRequest> pending_io;
 
-    bool halted;
+    // The code is set by a handler that knows why it fails, and otherwise worked out once the run stops
+    Trap trap_record{.code = TrapCode::none, .pc = 0};
 
     // overflow toggle
-    bool overflow;
+    bool overflow = false;
 
     // comparison indicator
     std::strong_ordering comparison{std::strong_ordering::equal};  
     
     // A MIX machine has 4000 memory cells
-    std::array<Byte, main_memory_size * bytes_in_word> memory;
+    Memory memory;
+
+    // Decoded form of each memory cell, filled lazily when the cell is executed.
+    // An entry is h_undecoded until then, and again whenever its cell is written to, so self-modifying code still works.
+    // The extra entry past the end of memory always decodes to h_invalid,
+    // so that running off the end of memory traps without a bounds check on every fetch.
+    std::array<DecodedInstruction, main_memory_size + 1> decoded_instructions;
+
+    // The cells written since the last snapshot, one bit per cell, set by invalidate_decoded_instruction,
+    // which every write into memory goes through
+    std::array<std::uint64_t, (main_memory_size + 63) / 64> dirty_cells{};
+
+    // The serial of the snapshot that dirty_cells are kept since, or 0 for none
+    std::uint64_t snapshot_serial = 0;
+
+    // Checked only when a cell is decoded, which swaps in h_breakpoint for the decoded handler
+    std::bitset<main_memory_size> breakpoints;
+
+    // Where load_program looks for the predecoded form of the segments that it loads, or nullptr to predecode them alone
+    CodeCache *code_cache = &CodeCache::process_wide();
+
+    // The segments loaded by load_program, newest last, which cells are decoded from while they still hold the words loaded
+    std::vector<std::shared_ptr<SharedSegment const>> shared_segments;
 
     Instruction inst{*this}; // current instruction
 
+    DispatchEngine dispatch_engine = DispatchEngine::jump_table;
+
+    // Created on the first run with DispatchEngine::jit, or once a cell gets hot with DispatchEngine::tiered
+    std::unique_ptr<Jit> jit;
+
+    // For DispatchEngine::tiered, the times that each cell was reached by a back-edge in the threaded interpreter,
+    // or by leaving translated code. The block starting at a cell is translated once the cell is hot,
+    // and a store that throws the block away cools the cell down again, so that it only comes back once it is hot again.
+    std::array<std::uint32_t, main_memory_size> heat{};
+
+    std::uint32_t tier_up_threshold = default_tier_up_threshold;
+
+    // Set while an AotRuntime runs a program on this machine
+    AotRuntime *aot = nullptr;
+
+    // Set while runs record the handler sequences that they execute, which also keeps the predecoder from fusing them
+    // and from running loops in bulk
+    SequenceProfile *sequence_profile = nullptr;
+
+    // The instructions, and their execution time, that completed within a superinstruction before one of its instructions trapped.
+    // Left for the run loop to count, and reset by it.
+    struct
+    {
+        NativeByte instructions;
+        NativeByte cycles;
+    } fused_progress{};
+
+    // The run that do_idiom counts the instructions of an idiom into, and the budget that it stops at, set by the run loop
+    RunResult *idiom_result = nullptr;
+    size_t idiom_budget = 0;
+
+    // The cells of the idiom that do_idiom runs, decoded afresh since the first one is decoded as h_idiom
+    std::array<DecodedInstruction, max_idiom_length> idiom_instructions;
+
+    // Set when a write into memory throws away translated code (see vm/jit.h and vm/aot.h),
+    // so that the translated code that made the write goes back to its dispatcher
+    bool translated_code_invalidated = false;
+
+    // Calls a handler for translated code, which cannot call a member function template itself.
+    // Code that is compiled together with the handlers gets them inlined by indexing the table with a constant.
+    using JitThunk = JitStatus (*)(Machine &);
+
+    // The thunk of every handler variant, by OpHandler
+    static JitThunk const jit_thunks[h_invalid];
+
+    using Handler = Result<void> (Machine::*)();
+
+    // The member function of every handler variant, by OpHandler.
+    // Indexed with a constant, e.g. by a superinstruction, it calls the handler directly.
+    static Handler const handler_functions[h_invalid];
+
+    // Runs the handlers of a superinstruction one after another, each on its own cell
+    template <OpHandler... handlers>
+    Result<void> do_fused();
+
+    // Swaps in a superinstruction for the decoded cell at address if it starts one, see vm/superinstruction.h
+    void fuse_superinstruction(NativeByte address, DecodedInstruction &head);
+
+    // Fills the empty decoded cell at address, which is within memory
+    void predecode(NativeByte address);
+
+    // Fills the empty decoded cell at address from a shared segment, if one still holds the cells that it depends on.
+    // Returns whether it does.
+    bool adopt_shared_cell(NativeByte address);
+
+    // Looks up the predecoded form of the words just loaded at origin in code_cache, predecoding them if they are not there yet
+    void share_segment(ValidatedAddress origin, size_t count);
+
+    // The idiom that starts at head, if any, see vm/idiom.h
+    std::optional<Idiom> match_idiom(NativeByte head) const;
+
+    // Swaps in h_idiom for the decoded cell at head if it starts an idiom, and returns whether it does
+    bool recognise_idiom(NativeByte head, DecodedInstruction &decoded) const;
+
+    // Runs the loop at pc until it leaves the loop, traps, or reaches the budget of the run,
+    // adding the instructions and execution time to the run itself rather than leaving them to the run loop.
+    // Kept out of line, since jump_table is flattened and is on the path of every dispatch.
+    [[gnu::noinline]]
+    Result<void> do_idiom();
+
+    // Runs all but the last of the iterations of the idiom at pc that go round, up to max_iterations of them, at once.
+    // Returns how many it ran.
+    size_t run_idiom_in_bulk(Idiom const &idiom, size_t max_iterations);
+
     [[gnu::always_inline]] inline
     void update_current_instruction();
 
@@ -143,76 +218,292 @@ class Machine
     IndexRegister &
     get_index_register(ValidatedRegisterIndex index);
 
+    template <RegisterIdx reg_idx>
+    [[gnu::always_inline]] inline
+    auto &
+    get_register();
+
     [[gnu::always_inline]] inline
-    Word<OwnershipKind::mutable_view> get_memory_word(ValidatedAddress address);
+    void invalidate_decoded_instruction(ValidatedAddress address);
+
+    // Writes back the cells of a snapshot with the given serial, whose words word_at gives by address:
+    // only the cells written since the snapshot if the machine has kept track of them, and otherwise every cell that differs.
+    // The machine then keeps track of the cells written since the snapshot.
+    template <class WordAt>
+    void restore_cells(std::uint64_t serial, WordAt const &word_at);
 
     [[gnu::flatten]]
     Result<void> jump_table();
 
-    template <NativeByte op_code>
-    [[gnu::flatten]]
-    void dispatch_by_op_code();
-
-    void do_nop();
-    void do_add();
-    void do_fadd();
-    void do_sub();
-    void do_fsub();
-    void do_mul();
-    void do_fmul();
-    void do_div();
-    void do_fdiv();
-    void do_num();
-    void do_char();
-    void do_hlt();
-    void do_sla();
-    void do_sra();
-    void do_slax();
-    void do_srax();
-    void do_slc();
-    void do_src();
-    void do_move();
-
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    RunResult run_jump_table(size_t budget);
+
+    // With count_heat, also counts the back-edges that it takes in heat,
+    // and returns early, with StopReason::budget, on reaching a hot cell
+    template <bool count_heat = false>
+    RunResult run_threaded(size_t budget);
+
+    RunResult run_jit(size_t budget);
+
+    // Hands each stretch of the run either to the threaded interpreter or, from a hot cell, to the JIT
+    RunResult run_tiered(size_t budget);
+
+    bool is_hot(NativeByte address) const
+    {
+        return address < main_memory_size && heat[address] >= tier_up_threshold;
+    }
+
+    // Same as run_jump_table, recording each instruction in sequence_profile
+    RunResult run_profiled(size_t budget);
+
+    // What a thunk hands back to translated code once its handler returns
+    JitStatus jit_status(Result<void> result);
+
+    // Fails the current instruction with the given trap code
+    Result<void> trap(TrapCode code)
+    {
+        trap_record.code = code;
+        return Result<void>::failure();
+    }
+
+    // Records the trap of the current instruction, which has just failed
+    [[gnu::cold]]
+    Trap record_trap();
+
+    // Executes the instruction at pc on its own, decoded afresh as if it had no breakpoint and started no superinstruction,
+    // so that a run starting on a breakpoint does not stop on it again,
+    // and so that a run whose budget ends partway through a superinstruction stops exactly at the budget
+    RunResult step_plain();
+
+    // Runs step_plain for a run loop whose budget ends partway through a superinstruction, adding it to result.
+    // Returns true if the run stops there.
+    bool step_plain_into(RunResult &result);
+
+    // Continues at M if the condition holds, and otherwise at the next instruction.
+    // Taking the jump saves the address of the next instruction in rJ, unless save_rJ is false as for JSJ.
+    template <Addressing addressing, bool save_rJ = true>
+    Result<void> jump_if(bool condition);
+
+    Result<void> do_nop();
+
+    template <Addressing addressing>
+    Result<void> do_add();
+    Result<void> do_fadd();
+
+    template <Addressing addressing>
+    Result<void> do_sub();
+    Result<void> do_fsub();
+
+    template <Addressing addressing>
+    Result<void> do_mul();
+    Result<void> do_fmul();
+
+    template <Addressing addressing>
+    Result<void> do_div();
+    Result<void> do_fdiv();
+
+    Result<void> do_num();
+    Result<void> do_char();
+    Result<void> do_hlt();
+
+    template <Addressing addressing>
+    Result<void> do_sla();
+
+    template <Addressing addressing>
+    Result<void> do_sra();
+
+    template <Addressing addressing>
+    Result<void> do_slax();
+
+    template <Addressing addressing>
+    Result<void> do_srax();
+
+    template <Addressing addressing>
+    Result<void> do_slc();
+
+    template <Addressing addressing>
+    Result<void> do_src();
+
+    template <Addressing addressing>
+    Result<void> do_move();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_ld();
     
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_ldn();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_st();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
-    void do_j();
-
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_inc();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_dec();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_ent();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_enn();
 
-    template <typename RegisterT, RegisterT Machine::*reg_member_ptr>
+    template <RegisterIdx reg_idx, Addressing addressing>
     Result<void> do_cmp();
+    Result<void> do_fcmp();
+
+    template <Addressing addressing>
+    Result<void> do_jbus();
+
+    template <Addressing addressing>
+    Result<void> do_ioc();
+
+    template <Addressing addressing>
+    Result<void> do_in();
+
+    template <Addressing addressing>
+    Result<void> do_out();
+
+    template <Addressing addressing>
+    Result<void> do_jred();
+
+    template <Addressing addressing>
+    Result<void> do_jmp();
+
+    template <Addressing addressing>
+    Result<void> do_jsj();
+
+    template <Addressing addressing>
+    Result<void> do_jov();
+
+    template <Addressing addressing>
+    Result<void> do_jnov();
+
+    template <Addressing addressing>
+    Result<void> do_jl();
+
+    template <Addressing addressing>
+    Result<void> do_je();
+
+    template <Addressing addressing>
+    Result<void> do_jg();
+
+    template <Addressing addressing>
+    Result<void> do_jge();
+
+    template <Addressing addressing>
+    Result<void> do_jne();
+
+    template <Addressing addressing>
+    Result<void> do_jle();
 
-    void do_in();
-    void do_out();
-    void do_jbus();
-    void do_jred();
-    void do_jmp();
-    void do_jov();
-    void do_jnov();
-    void do_jsj();
-    void do_ioc();
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jn();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jz();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jp();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jnn();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jnz();
+
+    template <RegisterIdx reg_idx, Addressing addressing>
+    Result<void> do_jnp();
 
 public:
-    Machine() = default;
-    void step();
+    Machine();
+    ~Machine();
+
+    // Puts the machine back as it was constructed, so that one machine can run program after program.
+    // Keeps the dispatch engine, code cache, tier-up threshold and sequence profile.
+    void reset();
+
+    // Takes the state of the registers, indicators, pc and memory, e.g. of a program just loaded,
+    // along with the I/O instruction that the machine waits on, and starts keeping track of the cells written from then on
+    MachineSnapshot snapshot();
+
+    // Puts the machine back into a snapshot, clearing any trap, so that io_request is the I/O instruction of the snapshot.
+    // The last snapshot that the machine took or restored only has the cells written since copied back,
+    // and any other snapshot the cells that differ; the others keep their decoded form and translated code.
+    // Breakpoints, and the heat of DispatchEngine::tiered, are kept.
+    void restore(MachineSnapshot const &snapshot);
+
+    // Puts the machine into the state of a snapshot file, reading its memory from the mapping in place,
+    // which restore(MachineSnapshot const &) does the same for: only the cells that differ from the file are written,
+    // and restoring the same mapped file again only looks at the cells written since.
+    // io_request is then the I/O instruction of the file, and its counters are left to the host, see resume_loaded_job.
+    void restore(SnapshotFile const &file);
+
+    // Executes a single instruction
+    RunResult step();
+
+    void set_dispatch_engine(DispatchEngine engine)
+    {
+        dispatch_engine = engine;
+    }
+
+    // The cache that later calls to load_program share predecoded segments through, or nullptr for none.
+    // Defaults to CodeCache::process_wide().
+    void set_code_cache(CodeCache *cache)
+    {
+        code_cache = cache;
+    }
+
+    // Times that DispatchEngine::tiered reaches a cell before translating the block that starts there
+    void set_tier_up_threshold(std::uint32_t threshold)
+    {
+        tier_up_threshold = threshold;
+    }
+
+    // Executes up to budget instructions in one loop,
+    // stopping early on HLT, a trap, a breakpoint or an I/O instruction.
+    // A run that stops on a trap or breakpoint leaves pc at the instruction it stopped on,
+    // so the next run picks up from there.
+    RunResult run(size_t budget);
+
+    // Writes a word into memory from outside of the machine, e.g. when loading a program.
+    void load_word(ValidatedAddress address, std::span<Byte const, bytes_in_word> word);
+
+    std::array<Byte, bytes_in_word> read_word(ValidatedAddress address) const;
+
+    // Loads consecutive words starting from origin, and sets pc to the entry point
+    Result<void> load_program(ValidatedAddress origin, std::span<std::array<Byte, bytes_in_word> const> words, ValidatedAddress entry_point);
+
+    // Decodes every cell that is not decoded yet, as running it would, e.g. so that machines forked from this one
+    // share the decoded cells rather than each decoding the cells that it runs
+    void predecode_all();
+
+    void set_breakpoint(ValidatedAddress address);
+
+    void clear_breakpoint(ValidatedAddress address);
+
+    // Records the handler sequences that later runs execute in profile, or stops recording with nullptr.
+    // Superinstructions are not used while recording, so that the profile sees every instruction.
+    void set_sequence_profile(SequenceProfile *profile);
+
+    // The I/O instruction that the last run stopped on with StopReason::io_wait.
+    // The host carries it out through load_word and read_word before running again.
+    std::optional<IoRequest> const &io_request() const
+    {
+        return pending_io;
+    }
+
+    // Tells the machine that the host has carried out io_request, so that a snapshot taken before the next run does not carry it
+    void clear_io_request()
+    {
+        pending_io.reset();
+    }
+
+    // The trap that the last run stopped on with StopReason::trap
+    Trap const &last_trap() const
+    {
+        return trap_record;
+    }
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -1,17 +1,27 @@
 #pragma once
 #include <base/base.h>
+#include <vm/aot.defn.h>
+#include <vm/jit.defn.h>
 #include <vm/machine.defn.h>
+#include <vm/memory.h>
+#include <vm/register.h>
+#include <vm/superinstruction.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 void Machine::update_current_instruction()
 {
-    inst.update_by_pc();
+    DecodedInstruction &decoded = decoded_instructions[pc];
+    // pc is within memory here, since the entry past the end of memory is never undecoded
+    if (decoded.handler == h_undecoded) [[unlikely]]
+        predecode(pc);
+    inst.decoded = &decoded;
 }
 
 void Machine::increment_pc()
 {
-    pc += bytes_in_word;
+    pc++;
 }
 
 IndexRegister &Machine::get_index_register(ValidatedRegisterIndex index)
@@ -19,9 +29,36 @@ IndexRegister &Machine::get_index_register(ValidatedRegisterIndex index)
     return index_registers[index - 1];
 }
 
-Word<OwnershipKind::mutable_view> Machine::get_memory_word(ValidatedAddress address)
+template <Machine::RegisterIdx reg_idx>
+auto &Machine::get_register()
 {
-    return {std::span<Byte, bytes_in_word>{memory.begin() + address * bytes_in_word, bytes_in_word}};
+    if constexpr (reg_idx == idx_rA)
+        return rA;
+    else if constexpr (reg_idx == idx_rX)
+        return rX;
+    else if constexpr (reg_idx == idx_rJ)
+        return rJ;
+    else if constexpr (reg_idx == idx_rZ)
+        return rZ;
+    else
+        return index_registers[reg_idx - idx_rI1];
 }
 
+void Machine::invalidate_decoded_instruction(ValidatedAddress address)
+{
+    dirty_cells[address / 64] |= std::uint64_t(1) << address % 64;
+    decoded_instructions[address] = {};
+    if constexpr (superinstruction_count > 0)
+    {
+        // Superinstructions that the cell is part of
+        for (NativeByte before = 1; before < max_superinstruction_length && before <= address; before++)
+            decoded_instructions[address - before] = {};
+    }
+    if (jit) [[unlikely]]
+        jit->invalidate(address);
+    if (aot) [[unlikely]]
+        aot->invalidate(address);
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
 }
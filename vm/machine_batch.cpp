@@ -0,0 +1,500 @@
+#include <base/base.h>
+#include <vm/machine.h>
+#include <vm/machine_batch.h>
+
+#include <algorithm>
+#include <bit>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+constexpr NativeInt word_limit = lut[numerical_bytes_in_word];
+constexpr NativeInt index_limit = lut[2];
+
+PackedField const &full_field = packed_fields[full_word_field];
+
+// One bit per lane, lane 0 being the least significant
+[[gnu::always_inline]] inline
+unsigned lane_bits(LaneInts const &mask)
+{
+    unsigned bits = 0;
+    for (size_t l = 0; l < batch_lanes; l++)
+        bits |= unsigned(mask[l] & 1) << l;
+    return bits;
+}
+
+// Native values of the numerical bytes of packed words, which are shifted to the right end already
+[[gnu::always_inline]] inline
+void lane_magnitudes(LaneWords const &bytes, LaneInts &magnitudes)
+{
+    if constexpr (packed_magnitude_is_native)
+        magnitudes = LaneInts(bytes);
+    else
+        for (size_t l = 0; l < batch_lanes; l++)
+            magnitudes[l] = unpack_magnitude(bytes[l]);
+}
+
+// The field of packed words as native values, which are positive unless the field has the sign
+[[gnu::always_inline]] inline
+void lane_field_values(LaneWords const &words, PackedField const &field, LaneInts &values)
+{
+    lane_magnitudes((words >> field.shift) & field.magnitude_mask, values);
+    LaneInts const negative = (words & (field.has_sign ? packed_sign_bit : 0)) != 0;
+    values = (values ^ negative) - negative;
+}
+
+// Packs magnitudes that fit in a word with the sign of the lanes in negative
+[[gnu::always_inline]] inline
+void lane_pack(LaneInts const &negative, LaneInts const &magnitudes, LaneWords &words)
+{
+    if constexpr (packed_magnitude_is_native)
+        words = LaneWords(magnitudes);
+    else
+        for (size_t l = 0; l < batch_lanes; l++)
+            words[l] = pack_magnitude(magnitudes[l]);
+    words |= LaneWords(negative) & packed_sign_bit;
+}
+
+// The lanes whose value meets condition 0 to 5 of index_condition_holds
+[[gnu::always_inline]] inline
+void lane_condition(NativeByte condition, LaneInts const &values, LaneInts &holds)
+{
+    switch (condition)
+    {
+    case 0:
+        holds = values < 0;
+        break;
+    case 1:
+        holds = values == 0;
+        break;
+    case 2:
+        holds = values > 0;
+        break;
+    case 3:
+        holds = values >= 0;
+        break;
+    case 4:
+        holds = values != 0;
+        break;
+    default:
+        holds = values <= 0;
+        break;
+    }
+}
+
+template <class Reg>
+void to_register(Reg &reg, PackedWord word)
+{
+    (void)reg.load(packed_field_sign(word, full_field), packed_field_magnitude(word, full_field));
+}
+
+}
+
+MachineBatch::MachineBatch()
+    : memory(std::make_unique<std::array<LaneWords, main_memory_size>>())
+    , scratch(std::make_unique<Machine>())
+{
+    scratch->set_code_cache(nullptr);
+    if constexpr (!batch_vectors)
+        scratch->set_dispatch_engine(DispatchEngine::tiered);
+}
+
+MachineBatch::~MachineBatch() = default;
+
+DecodedInstruction const &MachineBatch::decode(NativeByte const address, PackedWord const word)
+{
+    DecodedInstruction &cell = decoded[address];
+    if (cell.handler == h_undecoded || decoded_words[address] != word) [[unlikely]]
+    {
+        cell = decode_instruction(word);
+        decoded_words[address] = word;
+    }
+    return cell;
+}
+
+void MachineBatch::addresses(DecodedInstruction const &d, LaneInts const &lanes, LaneInts &M, LaneInts &addressed) const
+{
+    NativeInt const i = d.I().value();
+    if (i == 0)
+    {
+        M = LaneInts{} + (d.direct_M() ? NativeInt(d.direct_M().value()) : 0);
+        addressed = d.direct_M() ? lanes : LaneInts{};
+        return;
+    }
+    lane_field_values(registers[i], full_field, M);
+    M += NativeInt(d.A());
+    addressed = lanes & (M >= 0) & (M < NativeInt(main_memory_size));
+    M &= addressed;
+}
+
+void MachineBatch::execute(DecodedInstruction const &d, NativeInt const address, LaneInts const &lanes, LaneInts &done)
+{
+    done = LaneInts{};
+    if (d.handler >= h_invalid || !d.I())
+        return;
+    NativeByte const C = handler_op_codes[d.handler];
+    NativeByte const F = d.F();
+    PackedField const &field = packed_fields[F];
+    // FADD, FSUB and FCMP read no field
+    bool const has_field = handler_reads_field[d.handler] && field.valid;
+    bool const is_direct = d.I().value() == 0;
+    NativeInt const next = address + 1;
+
+    LaneInts M;
+    LaneInts addressed;
+    addresses(d, lanes, M, addressed);
+    // The word at M of every lane, or at 0 where M is not an address
+    auto const load_operand = [this, is_direct, &M](LaneWords &operand) {
+        if (is_direct)
+            operand = (*memory)[M[0]];
+        else
+            for (size_t l = 0; l < batch_lanes; l++)
+                operand[l] = (*memory)[M[l]][l];
+    };
+
+    if (C == op_nop)
+        done = lanes;
+    else if (C >= op_lda && C <= op_ldxn && has_field)
+    {
+        // LDA, LD1 to LD6 and LDX, then the same with N, follow the order of registers
+        size_t const r = (C - op_lda) % 8;
+        LaneWords operand;
+        load_operand(operand);
+        LaneWords const magnitudes = (operand >> field.shift) & field.magnitude_mask;
+        LaneWords const loaded = (magnitudes | (operand & (field.has_sign ? packed_sign_bit : 0))) ^ (C >= op_ldan ? packed_sign_bit : 0);
+        done = addressed;
+        if (r != rA && r != rX)
+        {
+            // An index register that overflows traps on the scratch machine
+            LaneInts values;
+            lane_magnitudes(magnitudes, values);
+            done &= values < index_limit;
+        }
+        registers[r] = done ? loaded : registers[r];
+    }
+    else if (C >= op_sta && C <= op_stz && has_field)
+    {
+        // STA, ST1 to ST6, STX, STJ and STZ follow the order of registers
+        LaneWords const &from = registers[C - op_sta];
+        LaneWords const shifted = (from & ~packed_sign_bit) << field.shift | (from & packed_sign_bit);
+        done = addressed;
+        if (is_direct)
+        {
+            LaneWords &cell = (*memory)[M[0]];
+            cell = done ? (cell & ~field.store_mask) | (shifted & field.store_mask) : cell;
+        }
+        else
+            for (size_t l = 0; l < batch_lanes; l++)
+                if (done[l])
+                {
+                    PackedWord &cell = (*memory)[M[l]][l];
+                    cell = (cell & ~field.store_mask) | (shifted[l] & field.store_mask);
+                }
+    }
+    else if ((C == op_add || C == op_sub) && has_field)
+    {
+        LaneWords operand;
+        load_operand(operand);
+        LaneInts V;
+        lane_field_values(operand, field, V);
+        LaneInts sum;
+        lane_field_values(registers[rA], full_field, sum);
+        sum = C == op_add ? sum + V : sum - V;
+        LaneInts const negative = sum < 0;
+        LaneInts magnitudes = (sum ^ negative) - negative;
+        // Both operands are less than word_limit, so one subtraction brings the sum back into a word
+        LaneInts const overflows = magnitudes >= word_limit;
+        magnitudes -= overflows & word_limit;
+        LaneWords result;
+        lane_pack(negative, magnitudes, result);
+        done = addressed;
+        registers[rA] = done ? result : registers[rA];
+        overflow |= done & overflows;
+    }
+    else if (C >= op_cmpa && has_field)
+    {
+        // CMPA, CMP1 to CMP6 and CMPX follow the order of registers
+        LaneWords operand;
+        load_operand(operand);
+        LaneInts a;
+        LaneInts b;
+        lane_field_values(registers[C - op_cmpa], field, a);
+        lane_field_values(operand, field, b);
+        done = addressed;
+        // A true comparison is -1
+        comparison = done ? LaneInts((a < b) - (a > b)) : comparison;
+    }
+    else if (C >= op_inca && C <= op_incx)
+    {
+        // INC, DEC, ENT and ENN of rA, rI1 to rI6 and rX
+        size_t const r = C - op_inca;
+        bool const is_index = r != rA && r != rX;
+        NativeInt const limit = is_index ? index_limit : word_limit;
+        LaneInts value;
+        lane_field_values(registers[r], full_field, value);
+        value = F == 0 ? value + M : F == 1 ? value - M : F == 2 ? M : -M;
+        LaneInts negative = value < 0;
+        if (F >= 2)
+        {
+            // Zero has the sign of the instruction, negated by ENN
+            NativeInt const zero_negative = (d.sign() == s_minus) == (F == 2) ? -1 : 0;
+            negative = value == 0 ? zero_negative : negative;
+        }
+        LaneInts magnitudes = (value ^ negative) - negative;
+        LaneInts const overflows = magnitudes >= limit;
+        magnitudes -= overflows & limit;
+        LaneWords result;
+        lane_pack(negative, magnitudes, result);
+        // An index register that overflows traps on the scratch machine
+        done = is_index ? addressed & ~overflows : addressed;
+        registers[r] = done ? result : registers[r];
+        overflow |= done & overflows;
+    }
+    else if (C == op_jmp || (C >= op_jan && C <= op_jxn))
+    {
+        LaneInts condition;
+        if (C != op_jmp)
+        {
+            // JrN, JrZ, JrP, JrNN, JrNZ and JrNP of rA, rI1 to rI6 and rX
+            LaneInts values;
+            lane_field_values(registers[C - op_jan], full_field, values);
+            lane_condition(F, values, condition);
+        }
+        else if (F <= 1)
+            condition = LaneInts{} - 1;
+        else if (F <= 3)
+            condition = F == 2 ? overflow : ~overflow;
+        else
+            // JL, JE, JG, JGE, JNE and JLE are the conditions of JrN to JrNP on the comparison indicator
+            lane_condition(F - 4, comparison, condition);
+        LaneInts const jumps = addressed & condition;
+        pc = jumps ? M : addressed ? next : pc;
+        // JSJ does not save rJ
+        if (C != op_jmp || F != 1)
+            registers[rJ] = jumps ? pack_magnitude(next) : registers[rJ];
+        // JOV and JNOV turn the toggle off
+        if (C == op_jmp && (F == 2 || F == 3))
+            overflow &= ~addressed;
+        done = addressed;
+        return;
+    }
+    pc = done ? next : pc;
+}
+
+std::optional<StopReason> MachineBatch::execute_on_scratch(size_t const lane, DecodedInstruction const &d)
+{
+    Machine &m = *scratch;
+    m.pc = pc[lane];
+    to_register(m.rA, registers[rA][lane]);
+    for (size_t i = 0; i < m.index_registers.size(); i++)
+        to_register(m.index_registers[i], registers[1 + i][lane]);
+    to_register(m.rX, registers[rX][lane]);
+    to_register(m.rJ, registers[rJ][lane]);
+    m.overflow = overflow[lane] != 0;
+    m.comparison = comparison[lane] <=> 0;
+    m.pending_stop.reset();
+    m.pending_io.reset();
+    m.trap_record = {.code = TrapCode::none, .pc = 0};
+    m.inst.decoded = &d;
+
+    // The cells that the instruction reads or writes, as [first, last), which is all of the lane's memory that the scratch machine needs.
+    // I/O instructions leave the transfer to the host.
+    std::array<std::pair<NativeInt, NativeInt>, 2> cells{};
+    if (d.handler < h_invalid)
+    {
+        Result<ValidatedAddress> const M = m.inst.native_M();
+        if (M && handler_reads_field[d.handler])
+            cells[0] = {M.value(), M.value() + 1};
+        else if (M && handler_op_codes[d.handler] == op_move)
+        {
+            NativeInt const count = d.F();
+            NativeInt const target = m.index_registers[0].native_value();
+            cells[0] = {M.value(), M.value() + count};
+            cells[1] = {target, target + count};
+        }
+    }
+    for (auto &[first, last] : cells)
+    {
+        first = std::clamp<NativeInt>(first, 0, main_memory_size);
+        last = std::clamp<NativeInt>(last, first, main_memory_size);
+        for (NativeInt a = first; a < last; a++)
+            m.memory.store(ValidatedAddress::trusted_constructor(a).value(), (*memory)[a][lane]);
+    }
+
+    Result<void> const result = d.handler < h_invalid ? (m.*Machine::handler_functions[d.handler])() : Result<void>::failure();
+
+    // A failed instruction may have changed some of the state before it trapped, just as on a Machine
+    pc[lane] = m.pc;
+    registers[rA][lane] = m.rA.packed_word();
+    for (size_t i = 0; i < m.index_registers.size(); i++)
+        registers[1 + i][lane] = m.index_registers[i].packed_word();
+    registers[rX][lane] = m.rX.packed_word();
+    registers[rJ][lane] = m.rJ.packed_word();
+    overflow[lane] = m.overflow ? -1 : 0;
+    comparison[lane] = m.comparison < 0 ? -1 : m.comparison > 0 ? 1 : 0;
+    for (auto const &[first, last] : cells)
+        for (NativeInt a = first; a < last; a++)
+            (*memory)[a][lane] = m.memory.load(ValidatedAddress::trusted_constructor(a).value());
+
+    if (!result)
+    {
+        trap_records[lane] = m.record_trap();
+        return StopReason::trap;
+    }
+    if (m.pending_stop)
+    {
+        pending_io[lane] = m.pending_io;
+        return m.pending_stop;
+    }
+    return std::nullopt;
+}
+
+std::array<RunResult, batch_lanes> MachineBatch::run_in_turn(size_t const budget)
+{
+    std::array<RunResult, batch_lanes> results;
+    Machine &m = *scratch;
+    for (size_t lane = 0; lane < batch_lanes; lane++)
+    {
+        m.restore(snapshot(lane));
+        results[lane] = m.run(budget);
+
+        pc[lane] = m.pc;
+        registers[rA][lane] = m.rA.packed_word();
+        for (size_t i = 0; i < m.index_registers.size(); i++)
+            registers[1 + i][lane] = m.index_registers[i].packed_word();
+        registers[rX][lane] = m.rX.packed_word();
+        registers[rJ][lane] = m.rJ.packed_word();
+        overflow[lane] = m.overflow ? -1 : 0;
+        comparison[lane] = m.comparison < 0 ? -1 : m.comparison > 0 ? 1 : 0;
+        pending_io[lane] = m.pending_io;
+        trap_records[lane] = results[lane].reason == StopReason::trap ? results[lane].trap : Trap{.code = TrapCode::none, .pc = 0};
+        // restore leaves the machine keeping track of the cells written since
+        for (size_t i = 0; i < m.dirty_cells.size(); i++)
+            for (std::uint64_t cells = m.dirty_cells[i]; cells != 0; cells &= cells - 1)
+            {
+                size_t const cell = i * 64 + std::countr_zero(cells);
+                (*memory)[cell][lane] = m.memory.load(ValidatedAddress::trusted_constructor(cell).value());
+            }
+    }
+    return results;
+}
+
+std::array<RunResult, batch_lanes> MachineBatch::run(size_t const budget)
+{
+    if constexpr (!batch_vectors)
+        return run_in_turn(budget);
+
+    std::array<RunResult, batch_lanes> results;
+    results.fill(RunResult{.reason = StopReason::budget, .trap = {}, .instructions = 0, .cycles = 0});
+    pending_io = {};
+    trap_records.fill(Trap{.code = TrapCode::none, .pc = 0});
+
+    LaneInts instructions{};
+    LaneInts cycles{};
+    LaneInts running = LaneInts{} - (budget > 0);
+    while (lane_bits(running) != 0)
+    {
+        // The lanes furthest behind go first, so that lanes that took different branches run together again where the paths join
+        NativeInt address = main_memory_size;
+        for (size_t l = 0; l < batch_lanes; l++)
+            address = running[l] ? std::min(address, pc[l]) : address;
+        LaneInts lanes = running & (pc == address);
+
+        if (address == main_memory_size) [[unlikely]]
+        {
+            // Running off the end of memory, which a Machine decodes as h_invalid
+            for (unsigned rest = lane_bits(lanes); rest != 0; rest &= rest - 1)
+            {
+                size_t const lane = std::countr_zero(rest);
+                trap_records[lane] = {.code = TrapCode::invalid_instruction, .pc = NativeByte(address)};
+                results[lane].reason = StopReason::trap;
+                results[lane].trap = trap_records[lane];
+            }
+            running &= ~lanes;
+            continue;
+        }
+
+        // Lanes that hold other code at address run it in a later step
+        PackedWord const word = (*memory)[address][std::countr_zero(lane_bits(lanes))];
+        lanes &= (*memory)[address] == word;
+        DecodedInstruction const &d = decode(address, word);
+
+        LaneInts done;
+        execute(d, address, lanes, done);
+        LaneInts stopped{};
+        for (unsigned rest = lane_bits(lanes & ~done); rest != 0; rest &= rest - 1)
+        {
+            size_t const lane = std::countr_zero(rest);
+            std::optional<StopReason> const stop = execute_on_scratch(lane, d);
+            if (stop)
+            {
+                results[lane].reason = *stop;
+                results[lane].trap = trap_records[lane];
+                stopped[lane] = -1;
+            }
+            if (stop != StopReason::trap)
+                done[lane] = -1;
+        }
+        instructions -= done;
+        cycles += done & NativeInt(d.cycles);
+        stopped |= done & (instructions == NativeInt(budget));
+        running &= ~stopped;
+    }
+    for (size_t l = 0; l < batch_lanes; l++)
+    {
+        results[l].instructions = instructions[l];
+        results[l].cycles = cycles[l];
+    }
+    return results;
+}
+
+void MachineBatch::load_word(size_t const lane, ValidatedAddress const address, std::span<Byte const, bytes_in_word> const word)
+{
+    (*memory)[address][lane] = pack(word);
+}
+
+std::array<Byte, bytes_in_word> MachineBatch::read_word(size_t const lane, ValidatedAddress const address) const
+{
+    return unpack((*memory)[address][lane]);
+}
+
+MachineSnapshot MachineBatch::snapshot(size_t const lane) const
+{
+    MachineSnapshot snapshot{
+        .serial = 0,
+        .pc = NativeByte(pc[lane]),
+        .rA = {},
+        .index_registers = {},
+        .rX = {},
+        .rJ = {},
+        .overflow = overflow[lane] != 0,
+        .comparison = comparison[lane] <=> 0,
+        .pending_io = pending_io[lane],
+        .memory = {},
+        .shared_segments = {},
+    };
+    to_register(snapshot.rA, registers[rA][lane]);
+    for (size_t i = 0; i < snapshot.index_registers.size(); i++)
+        to_register(snapshot.index_registers[i], registers[1 + i][lane]);
+    to_register(snapshot.rX, registers[rX][lane]);
+    to_register(snapshot.rJ, registers[rJ][lane]);
+    for (NativeByte address = 0; address < main_memory_size; address++)
+        snapshot.memory.store(ValidatedAddress::trusted_constructor(address).value(), (*memory)[address][lane]);
+    return snapshot;
+}
+
+Result<void> MachineBatch::load_program(ValidatedAddress const origin, std::span<std::array<Byte, bytes_in_word> const> const words, ValidatedAddress const entry_point)
+{
+    if (words.size() > main_memory_size - origin)
+        return Result<void>::failure();
+    for (size_t i = 0; i < words.size(); i++)
+        (*memory)[origin + i] = LaneWords{} + pack(words[i]);
+    pc = LaneInts{} + NativeInt(entry_point);
+    return Result<void>::success();
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <base/base.h>
+#include <vm/instruction.defn.h>
+#include <vm/machine.decl.h>
+#include <vm/packed_word.h>
+
+#include <array>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <span>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Lanes of a MachineBatch, i.e. machines that it runs side by side: as many words as a vector of the target holds,
+// which is 2 for SSE2, the baseline of x86-64, unless MIX_BATCH_LANES says otherwise. GCC splits vectors wider
+// than the target's into element-wise code, which is slower than running the lanes one by one.
+#if defined(__AVX512F__)
+constexpr size_t target_batch_lanes = 8;
+#elif defined(__AVX2__)
+constexpr size_t target_batch_lanes = 4;
+#else
+constexpr size_t target_batch_lanes = 2;
+#endif
+constexpr size_t batch_lanes = configured_batch_lanes != 0 ? configured_batch_lanes : target_batch_lanes;
+
+// Whether the lanes run as vectors at all, rather than in turn on one Machine, unless MIX_BATCH_VECTORS says otherwise.
+// On SSE2, masking and merging two words at a time costs more than it saves: bench/interpreter ran a batch at 49 million
+// instructions/s against 85 for the threaded engine. With AVX2 and AVX-512 it ran at 122 and 174, which beats the threaded
+// engine, although not the JIT, which a batch running in turn gets from DispatchEngine::tiered.
+constexpr bool batch_vectors = configured_batch_vectors && target_batch_lanes >= 4;
+
+// Up to 32, so that a mask of lanes fits in an unsigned
+static_assert(std::has_single_bit(batch_lanes) && batch_lanes <= 32);
+
+// A word, or register, of every lane side by side, as a vector of GCC's vector extensions,
+// so that an operation on it compiles to one vector instruction, or a few when MIX_BATCH_LANES is wider than the target
+using LaneWords [[gnu::vector_size(sizeof(PackedWord) * batch_lanes)]] = PackedWord;
+
+// A signed value of every lane, or a mask of lanes, all of whose bits are set in the lanes it selects
+using LaneInts [[gnu::vector_size(sizeof(NativeInt) * batch_lanes)]] = NativeInt;
+
+// Runs the same program on batch_lanes machines at once, e.g. on as many inputs, one decoded instruction for all of them at a time.
+//
+// Memory and registers are laid out as structures of arrays: each word holds the packed word of every lane side by side,
+// so that loads, stores, ADD, SUB, CMP, address transfers and jumps run as a few vector operations for all of the lanes.
+// Every other instruction, and every lane that would trap or overflow an index register, runs one lane at a time
+// on a scratch Machine, so that each lane ends up exactly as a Machine would.
+//
+// Lanes that take different branches carry on at different addresses. Each step runs the lanes that are furthest behind,
+// masking off the others, so that lanes that split at a branch run in lockstep again from where their paths join.
+// A lane that has written different code into the cell being run is masked off too, and runs with the lanes that share its code.
+// Breakpoints and the code cache, superinstructions, idioms and translated code of Machine are not used.
+//
+// Without batch_vectors, each lane runs in turn on the scratch Machine, with DispatchEngine::tiered, from the state kept for it here.
+// Only the cells that differ from the lane before are written into the machine, so the code that it has decoded or translated
+// for the program carries over from lane to lane.
+//
+// Vectors are passed by reference, since passing them by value depends on the vectors of the target.
+class MachineBatch
+{
+    // Registers in the order of Machine's REGISTER_LIST: rA, rI1 to rI6, rX, rJ, then rZ, which stays +0
+    static constexpr size_t register_count = 10;
+    static constexpr size_t rA = 0;
+    static constexpr size_t rX = 7;
+    static constexpr size_t rJ = 8;
+    static constexpr size_t rZ = 9;
+
+    LaneInts pc{};
+
+    std::array<LaneWords, register_count> registers{};
+
+    // A mask of the lanes whose overflow toggle is on
+    LaneInts overflow{};
+
+    // -1, 0 or 1 for less, equal or greater
+    LaneInts comparison{};
+
+    std::unique_ptr<std::array<LaneWords, main_memory_size>> memory;
+
+    // The plain decoded form of the word each cell held when it was last run by any lane
+    std::array<DecodedInstruction, main_memory_size> decoded;
+    std::array<PackedWord, main_memory_size> decoded_words{};
+
+    std::array<std::optional<IoRequest>, batch_lanes> pending_io;
+
+    std::array<Trap, batch_lanes> trap_records{};
+
+    // Runs the instructions that have no vector form, one lane at a time, or every lane without batch_vectors
+    std::unique_ptr<Machine> scratch;
+
+    // The decoded form of the word at address
+    DecodedInstruction const &decode(NativeByte address, PackedWord word);
+
+    // Works out M for the lanes, and the lanes for which it is an address, leaving 0 in M for the others
+    void addresses(DecodedInstruction const &d, LaneInts const &lanes, LaneInts &M, LaneInts &addressed) const;
+
+    // Runs the instruction at address for the lanes with vector operations where it can,
+    // and sets done to the lanes that it ran; the others are left for execute_on_scratch
+    void execute(DecodedInstruction const &d, NativeInt address, LaneInts const &lanes, LaneInts &done);
+
+    // Runs the instruction for one lane on the scratch machine.
+    // Returns why the lane stops there, if it does: a trap if the instruction failed, which does not count as run,
+    // or, once it has run, HLT or an I/O instruction.
+    std::optional<StopReason> execute_on_scratch(size_t lane, DecodedInstruction const &d);
+
+    // Same as run, without batch_vectors
+    std::array<RunResult, batch_lanes> run_in_turn(size_t budget);
+
+public:
+    MachineBatch();
+    ~MachineBatch();
+
+    // Runs every lane for up to budget instructions, stopping each lane as Machine::run would stop it.
+    // A lane that stops early sits out the rest of the run.
+    std::array<RunResult, batch_lanes> run(size_t budget);
+
+    // Writes a word into the memory of one lane
+    void load_word(size_t lane, ValidatedAddress address, std::span<Byte const, bytes_in_word> word);
+
+    std::array<Byte, bytes_in_word> read_word(size_t lane, ValidatedAddress address) const;
+
+    // Loads consecutive words into every lane starting from origin, and sets the pc of every lane to the entry point
+    Result<void> load_program(ValidatedAddress origin, std::span<std::array<Byte, bytes_in_word> const> words, ValidatedAddress entry_point);
+
+    // The state of one lane, as Machine::snapshot would take it of a Machine that had run the lane.
+    // The snapshot keeps track of no cells, so Machine::restore copies back every cell that differs.
+    MachineSnapshot snapshot(size_t lane) const;
+
+    // The I/O instruction that the last run of a lane stopped on with StopReason::io_wait
+    std::optional<IoRequest> const &io_request(size_t lane) const
+    {
+        return pending_io[lane];
+    }
+
+    // The trap that the last run of a lane stopped on with StopReason::trap
+    Trap const &last_trap(size_t lane) const
+    {
+        return trap_records[lane];
+    }
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,2 @@
+#pragma once
+#include <vm/machine_batch.defn.h>
@@ -0,0 +1,14 @@
+#pragma once
+#include <base/base.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+struct ByteMemory;
+struct PackedMemory;
+
+// The main memory layout selected by MIX_PACKED_MEMORY
+using Memory = std::conditional_t<packed_memory, PackedMemory, ByteMemory>;
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
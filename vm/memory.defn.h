@@ -0,0 +1,52 @@
+#pragma once
+#include <base/base.h>
+#include <vm/memory.decl.h>
+#include <vm/packed_word.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Both layouts are accessed one whole word at a time, as a PackedWord.
+
+// Each word is stored as 6 MIX bytes
+struct ByteMemory
+{
+    std::array<Byte, main_memory_size * bytes_in_word> bytes;
+
+    [[gnu::always_inline]] inline
+    PackedWord load(ValidatedAddress address) const;
+
+    [[gnu::always_inline]] inline
+    void store(ValidatedAddress address, PackedWord word);
+
+    // Stores word into count consecutive cells from first
+    inline
+    void fill(ValidatedAddress first, size_t count, PackedWord word);
+
+    // Copies count consecutive cells from source to target, as std::memmove would
+    inline
+    void move(ValidatedAddress target, ValidatedAddress source, size_t count);
+};
+
+// Each word is stored as one PackedWord, so that a load or store is a single host access
+struct PackedMemory
+{
+    std::array<PackedWord, main_memory_size> words{};
+
+    [[gnu::always_inline]] inline
+    PackedWord load(ValidatedAddress address) const;
+
+    [[gnu::always_inline]] inline
+    void store(ValidatedAddress address, PackedWord word);
+
+    // Stores word into count consecutive cells from first
+    inline
+    void fill(ValidatedAddress first, size_t count, PackedWord word);
+
+    // Copies count consecutive cells from source to target, as std::memmove would
+    inline
+    void move(ValidatedAddress target, ValidatedAddress source, size_t count);
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
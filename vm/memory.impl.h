@@ -0,0 +1,60 @@
+#pragma once
+#include <base/base.h>
+#include <vm/memory.defn.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+PackedWord ByteMemory::load(ValidatedAddress address) const
+{
+    return pack(std::span<Byte const, bytes_in_word>(bytes.begin() + address * bytes_in_word, bytes_in_word));
+}
+
+void ByteMemory::store(ValidatedAddress address, PackedWord word)
+{
+    std::array<Byte, bytes_in_word> const unpacked = unpack(word);
+    std::copy(unpacked.begin(), unpacked.end(), bytes.begin() + address * bytes_in_word);
+}
+
+void ByteMemory::fill(ValidatedAddress first, size_t count, PackedWord word)
+{
+    std::array<Byte, bytes_in_word> const unpacked = unpack(word);
+    for (size_t i = 0; i < count; i++)
+        std::copy(unpacked.begin(), unpacked.end(), bytes.begin() + (first + i) * bytes_in_word);
+}
+
+void ByteMemory::move(ValidatedAddress target, ValidatedAddress source, size_t count)
+{
+    auto const from = bytes.begin() + source * bytes_in_word;
+    auto const to = bytes.begin() + target * bytes_in_word;
+    if (target <= source)
+        std::copy(from, from + count * bytes_in_word, to);
+    else
+        std::copy_backward(from, from + count * bytes_in_word, to + count * bytes_in_word);
+}
+
+PackedWord PackedMemory::load(ValidatedAddress address) const
+{
+    return words[address];
+}
+
+void PackedMemory::store(ValidatedAddress address, PackedWord word)
+{
+    words[address] = word;
+}
+
+void PackedMemory::fill(ValidatedAddress first, size_t count, PackedWord word)
+{
+    std::fill(words.begin() + first, words.begin() + first + count, word);
+}
+
+void PackedMemory::move(ValidatedAddress target, ValidatedAddress source, size_t count)
+{
+    if (target <= source)
+        std::copy(words.begin() + source, words.begin() + source + count, words.begin() + target);
+    else
+        std::copy_backward(words.begin() + source, words.begin() + source + count, words.begin() + target + count);
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
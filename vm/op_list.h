@@ -0,0 +1,332 @@
+#pragma once
+#include <base/base.h>
+#include <vm/superinstruction_list.h>
+
+#include <cstdint>
+#include <string_view>
+namespace mix
+{
+
+// Each entry ends with the operand kind of the op, which decides its handler variants (see Addressing):
+//   none: the handler does not read M
+//   M:    the handler reads M
+//   MF:   the handler reads or writes the field F of M
+#define OP_LIST(IT, IT_FIELD, IT_REGISTER, IT_FIELD_REGISTER, ...) /* ... are additional args */ \
+    IT(nop, 0, do_nop, none, __VA_ARGS__) \
+    IT_FIELD(fadd, 1, 6, do_fadd, none, __VA_ARGS__) IT(add, 1, do_add, MF, __VA_ARGS__) \
+    IT_FIELD(fsub, 2, 6, do_fsub, none, __VA_ARGS__) IT(sub, 2, do_sub, MF, __VA_ARGS__) \
+    IT_FIELD(fmul, 3, 6, do_fmul, none, __VA_ARGS__) IT(mul, 3, do_mul, MF, __VA_ARGS__) \
+    IT_FIELD(fdiv, 4, 6, do_fdiv, none, __VA_ARGS__) IT(div, 4, do_div, MF, __VA_ARGS__) \
+    IT_FIELD(num, 5, 0, do_num, none, __VA_ARGS__) IT_FIELD(char, 5, 1, do_char, none, __VA_ARGS__) IT_FIELD(hlt, 5, 2, do_hlt, none, __VA_ARGS__) \
+    IT_FIELD(sla, 6, 0, do_sla, M, __VA_ARGS__) IT_FIELD(sra, 6, 1, do_sra, M, __VA_ARGS__) IT_FIELD(slax, 6, 2, do_slax, M, __VA_ARGS__) IT_FIELD(srax, 6, 3, do_srax, M, __VA_ARGS__) IT_FIELD(slc, 6, 4, do_slc, M, __VA_ARGS__) IT_FIELD(src, 6, 5, do_src, M, __VA_ARGS__) \
+    IT(move, 7, do_move, M, __VA_ARGS__) \
+    IT_REGISTER(lda, 8, do_ld, rA, MF, __VA_ARGS__) \
+    IT_REGISTER(ld1, 9, do_ld, rI1, MF, __VA_ARGS__) \
+    IT_REGISTER(ld2, 10, do_ld, rI2, MF, __VA_ARGS__) \
+    IT_REGISTER(ld3, 11, do_ld, rI3, MF, __VA_ARGS__) \
+    IT_REGISTER(ld4, 12, do_ld, rI4, MF, __VA_ARGS__) \
+    IT_REGISTER(ld5, 13, do_ld, rI5, MF, __VA_ARGS__) \
+    IT_REGISTER(ld6, 14, do_ld, rI6, MF, __VA_ARGS__) \
+    IT_REGISTER(ldx, 15, do_ld, rX, MF, __VA_ARGS__) \
+    IT_REGISTER(ldan, 16, do_ldn, rA, MF, __VA_ARGS__) \
+    IT_REGISTER(ld1n, 17, do_ldn, rI1, MF, __VA_ARGS__) \
+    IT_REGISTER(ld2n, 18, do_ldn, rI2, MF, __VA_ARGS__) \
+    IT_REGISTER(ld3n, 19, do_ldn, rI3, MF, __VA_ARGS__) \
+    IT_REGISTER(ld4n, 20, do_ldn, rI4, MF, __VA_ARGS__) \
+    IT_REGISTER(ld5n, 21, do_ldn, rI5, MF, __VA_ARGS__) \
+    IT_REGISTER(ld6n, 22, do_ldn, rI6, MF, __VA_ARGS__) \
+    IT_REGISTER(ldxn, 23, do_ldn, rX, MF, __VA_ARGS__) \
+    IT_REGISTER(sta, 24, do_st, rA, MF, __VA_ARGS__) \
+    IT_REGISTER(st1, 25, do_st, rI1, MF, __VA_ARGS__) \
+    IT_REGISTER(st2, 26, do_st, rI2, MF, __VA_ARGS__) \
+    IT_REGISTER(st3, 27, do_st, rI3, MF, __VA_ARGS__) \
+    IT_REGISTER(st4, 28, do_st, rI4, MF, __VA_ARGS__) \
+    IT_REGISTER(st5, 29, do_st, rI5, MF, __VA_ARGS__) \
+    IT_REGISTER(st6, 30, do_st, rI6, MF, __VA_ARGS__) \
+    IT_REGISTER(stx, 31, do_st, rX, MF, __VA_ARGS__) \
+    IT_REGISTER(stj, 32, do_st, rJ, MF, __VA_ARGS__) \
+    IT_REGISTER(stz, 33, do_st, rZ, MF, __VA_ARGS__) \
+    IT(jbus, 34, do_jbus, M, __VA_ARGS__) \
+    IT(ioc, 35, do_ioc, M, __VA_ARGS__) \
+    IT(in, 36, do_in, M, __VA_ARGS__) \
+    IT(out, 37, do_out, M, __VA_ARGS__) \
+    IT(jred, 38, do_jred, M, __VA_ARGS__) \
+    IT_FIELD(jmp, 39, 0, do_jmp, M, __VA_ARGS__) IT_FIELD(jsj, 39, 1, do_jsj, M, __VA_ARGS__) IT_FIELD(jov, 39, 2, do_jov, M, __VA_ARGS__) IT_FIELD(jnov, 39, 3, do_jnov, M, __VA_ARGS__) \
+    IT_FIELD(jl, 39, 4, do_jl, M, __VA_ARGS__) IT_FIELD(je, 39, 5, do_je, M, __VA_ARGS__) IT_FIELD(jg, 39, 6, do_jg, M, __VA_ARGS__) IT_FIELD(jge, 39, 7, do_jge, M, __VA_ARGS__) IT_FIELD(jne, 39, 8, do_jne, M, __VA_ARGS__) IT_FIELD(jle, 39, 9, do_jle, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(jan, 40, 0, do_jn, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(jaz, 40, 1, do_jz, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(jap, 40, 2, do_jp, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(jann, 40, 3, do_jnn, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(janz, 40, 4, do_jnz, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(janp, 40, 5, do_jnp, rA, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j1n, 41, 0, do_jn, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(j1z, 41, 1, do_jz, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(j1p, 41, 2, do_jp, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(j1nn, 41, 3, do_jnn, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(j1nz, 41, 4, do_jnz, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(j1np, 41, 5, do_jnp, rI1, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j2n, 42, 0, do_jn, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(j2z, 42, 1, do_jz, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(j2p, 42, 2, do_jp, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(j2nn, 42, 3, do_jnn, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(j2nz, 42, 4, do_jnz, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(j2np, 42, 5, do_jnp, rI2, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j3n, 43, 0, do_jn, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(j3z, 43, 1, do_jz, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(j3p, 43, 2, do_jp, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(j3nn, 43, 3, do_jnn, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(j3nz, 43, 4, do_jnz, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(j3np, 43, 5, do_jnp, rI3, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j4n, 44, 0, do_jn, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(j4z, 44, 1, do_jz, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(j4p, 44, 2, do_jp, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(j4nn, 44, 3, do_jnn, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(j4nz, 44, 4, do_jnz, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(j4np, 44, 5, do_jnp, rI4, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j5n, 45, 0, do_jn, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(j5z, 45, 1, do_jz, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(j5p, 45, 2, do_jp, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(j5nn, 45, 3, do_jnn, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(j5nz, 45, 4, do_jnz, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(j5np, 45, 5, do_jnp, rI5, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(j6n, 46, 0, do_jn, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(j6z, 46, 1, do_jz, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(j6p, 46, 2, do_jp, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(j6nn, 46, 3, do_jnn, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(j6nz, 46, 4, do_jnz, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(j6np, 46, 5, do_jnp, rI6, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(jxn, 47, 0, do_jn, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(jxz, 47, 1, do_jz, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(jxp, 47, 2, do_jp, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(jxnn, 47, 3, do_jnn, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(jxnz, 47, 4, do_jnz, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(jxnp, 47, 5, do_jnp, rX, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inca, 48, 0, do_inc, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(deca, 48, 1, do_dec, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(enta, 48, 2, do_ent, rA, M, __VA_ARGS__) IT_FIELD_REGISTER(enna, 48, 3, do_enn, rA, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc1, 49, 0, do_inc, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(dec1, 49, 1, do_dec, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(ent1, 49, 2, do_ent, rI1, M, __VA_ARGS__) IT_FIELD_REGISTER(enn1, 49, 3, do_enn, rI1, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc2, 50, 0, do_inc, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(dec2, 50, 1, do_dec, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(ent2, 50, 2, do_ent, rI2, M, __VA_ARGS__) IT_FIELD_REGISTER(enn2, 50, 3, do_enn, rI2, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc3, 51, 0, do_inc, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(dec3, 51, 1, do_dec, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(ent3, 51, 2, do_ent, rI3, M, __VA_ARGS__) IT_FIELD_REGISTER(enn3, 51, 3, do_enn, rI3, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc4, 52, 0, do_inc, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(dec4, 52, 1, do_dec, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(ent4, 52, 2, do_ent, rI4, M, __VA_ARGS__) IT_FIELD_REGISTER(enn4, 52, 3, do_enn, rI4, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc5, 53, 0, do_inc, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(dec5, 53, 1, do_dec, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(ent5, 53, 2, do_ent, rI5, M, __VA_ARGS__) IT_FIELD_REGISTER(enn5, 53, 3, do_enn, rI5, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(inc6, 54, 0, do_inc, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(dec6, 54, 1, do_dec, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(ent6, 54, 2, do_ent, rI6, M, __VA_ARGS__) IT_FIELD_REGISTER(enn6, 54, 3, do_enn, rI6, M, __VA_ARGS__) \
+    IT_FIELD_REGISTER(incx, 55, 0, do_inc, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(decx, 55, 1, do_dec, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(entx, 55, 2, do_ent, rX, M, __VA_ARGS__) IT_FIELD_REGISTER(ennx, 55, 3, do_enn, rX, M, __VA_ARGS__) \
+    IT_FIELD(fcmp, 56, 6, do_fcmp, none, __VA_ARGS__) IT_REGISTER(cmpa, 56, do_cmp, rA, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp1, 57, do_cmp, rI1, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp2, 58, do_cmp, rI2, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp3, 59, do_cmp, rI3, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp4, 60, do_cmp, rI4, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp5, 61, do_cmp, rI5, MF, __VA_ARGS__) \
+    IT_REGISTER(cmp6, 62, do_cmp, rI6, MF, __VA_ARGS__) \
+    IT_REGISTER(cmpx, 63, do_cmp, rX, MF, __VA_ARGS__) 
+
+enum OpCode : NativeByte 
+{
+#define OP_LIST_ENUM_ITERATOR(OP_NAME, OP_CODE, ...) op_##OP_NAME = OP_CODE,
+    OP_LIST(OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR, OP_LIST_ENUM_ITERATOR)
+#undef OP_LIST_ENUM_ITERATOR
+    op_max,
+};
+
+static_assert(op_max == minimum_byte_size);
+
+// How a handler variant reaches its operand.
+// Handlers that read M or M(F) are instantiated once per addressing mode, and the decoder picks the mode once per instruction word,
+// so that the common unindexed and full-word forms skip the general computation.
+enum Addressing : NativeByte
+{
+    // M is A, and F is the full word (0:5)
+    a_direct_full,
+    // M is A
+    a_direct,
+    // M is A + rIi, and F is the full word (0:5)
+    a_indexed_full,
+    // M is A + rIi
+    a_indexed,
+};
+
+constexpr bool is_indexed(Addressing addressing)
+{
+    return addressing == a_indexed_full || addressing == a_indexed;
+}
+
+constexpr bool is_full_word(Addressing addressing)
+{
+    return addressing == a_direct_full || addressing == a_indexed_full;
+}
+
+// F of the full word (0:5)
+constexpr NativeByte full_word_field = 5;
+
+// OP_VARIANTS_<kind>(IT_VARIANT, OP_NAME, FUNC, template args...) expands IT_VARIANT(HANDLER, CALLEE...) for each handler variant of an op,
+// HANDLER being the OpHandler of the variant and CALLEE the member function implementing it.
+#define OP_VARIANTS_none(IT_VARIANT, OP_NAME, FUNC, ...) \
+    IT_VARIANT(h_##OP_NAME, FUNC __VA_OPT__(<__VA_ARGS__>))
+
+#define OP_VARIANTS_M(IT_VARIANT, OP_NAME, FUNC, ...) \
+    IT_VARIANT(h_##OP_NAME##_direct, FUNC<__VA_ARGS__ __VA_OPT__(,) a_direct>) \
+    IT_VARIANT(h_##OP_NAME##_indexed, FUNC<__VA_ARGS__ __VA_OPT__(,) a_indexed>)
+
+#define OP_VARIANTS_MF(IT_VARIANT, OP_NAME, FUNC, ...) \
+    IT_VARIANT(h_##OP_NAME##_direct_full, FUNC<__VA_ARGS__ __VA_OPT__(,) a_direct_full>) \
+    IT_VARIANT(h_##OP_NAME##_direct, FUNC<__VA_ARGS__ __VA_OPT__(,) a_direct>) \
+    IT_VARIANT(h_##OP_NAME##_indexed_full, FUNC<__VA_ARGS__ __VA_OPT__(,) a_indexed_full>) \
+    IT_VARIANT(h_##OP_NAME##_indexed, FUNC<__VA_ARGS__ __VA_OPT__(,) a_indexed>)
+
+#define OP_VARIANTS_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND, IT_VARIANT) \
+    OP_VARIANTS_##KIND(IT_VARIANT, OP_NAME, FUNC)
+#define OP_VARIANTS_FIELD_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND, IT_VARIANT) \
+    OP_VARIANTS_##KIND(IT_VARIANT, OP_NAME, FUNC)
+#define OP_VARIANTS_REGISTER_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER, KIND, IT_VARIANT) \
+    OP_VARIANTS_##KIND(IT_VARIANT, OP_NAME, FUNC, idx_##REGISTER)
+#define OP_VARIANTS_FIELD_REGISTER_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER, KIND, IT_VARIANT) \
+    OP_VARIANTS_##KIND(IT_VARIANT, OP_NAME, FUNC, idx_##REGISTER)
+
+// Expands IT_VARIANT(HANDLER, CALLEE...) for every handler variant of every op, in OpHandler order
+#define OP_VARIANT_LIST(IT_VARIANT) \
+    OP_LIST(OP_VARIANTS_ITERATOR, OP_VARIANTS_FIELD_ITERATOR, OP_VARIANTS_REGISTER_ITERATOR, OP_VARIANTS_FIELD_REGISTER_ITERATOR, IT_VARIANT)
+
+// Identifies the handler variant that an instruction word decodes to.
+// Unlike OpCode, each field variant of an op code (e.g. NUM, CHAR, HLT) has its own value,
+// so that dispatching on an OpHandler never needs to re-examine the F field.
+enum OpHandler : std::uint16_t
+{
+#define OP_VARIANT_HANDLER_ENUM_ITERATOR(HANDLER, ...) HANDLER,
+    OP_VARIANT_LIST(OP_VARIANT_HANDLER_ENUM_ITERATOR)
+#undef OP_VARIANT_HANDLER_ENUM_ITERATOR
+    h_invalid,
+    // Stands in for the handler of an instruction that has a breakpoint on it
+    h_breakpoint,
+    // Stands in for the handler of the first instruction of a loop that runs in bulk (see vm/idiom.h)
+    h_idiom,
+    // Superinstructions, which the predecoder swaps in for runs of instructions (see vm/superinstruction.h)
+#define SUPERINSTRUCTION_HANDLER_ENUM_ITERATOR(NAME, ...) h_##NAME,
+    SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_HANDLER_ENUM_ITERATOR)
+#undef SUPERINSTRUCTION_HANDLER_ENUM_ITERATOR
+    // Marks a cell of a decoded table that has not been decoded yet, which is never dispatched on
+    h_undecoded,
+};
+
+// The name of every handler variant, as in OpHandler
+constexpr std::string_view handler_names[] = {
+#define OP_VARIANT_NAME_ITERATOR(HANDLER, ...) #HANDLER,
+    OP_VARIANT_LIST(OP_VARIANT_NAME_ITERATOR)
+#undef OP_VARIANT_NAME_ITERATOR
+};
+static_assert(std::size(handler_names) == h_invalid);
+
+// The op code of every handler variant
+#define OP_CODES_none(OP_CODE) OP_CODE,
+#define OP_CODES_M(OP_CODE) OP_CODE, OP_CODE,
+#define OP_CODES_MF(OP_CODE) OP_CODE, OP_CODE, OP_CODE, OP_CODE,
+#define OP_LIST_OP_CODE_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND, ...) OP_CODES_##KIND(OP_CODE)
+#define OP_LIST_FIELD_OP_CODE_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND, ...) OP_CODES_##KIND(OP_CODE)
+#define OP_LIST_REGISTER_OP_CODE_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER, KIND, ...) OP_CODES_##KIND(OP_CODE)
+#define OP_LIST_FIELD_REGISTER_OP_CODE_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER, KIND, ...) OP_CODES_##KIND(OP_CODE)
+constexpr NativeByte handler_op_codes[] = {
+    OP_LIST(OP_LIST_OP_CODE_ITERATOR, OP_LIST_FIELD_OP_CODE_ITERATOR, OP_LIST_REGISTER_OP_CODE_ITERATOR, OP_LIST_FIELD_REGISTER_OP_CODE_ITERATOR)
+};
+#undef OP_LIST_FIELD_REGISTER_OP_CODE_ITERATOR
+#undef OP_LIST_REGISTER_OP_CODE_ITERATOR
+#undef OP_LIST_FIELD_OP_CODE_ITERATOR
+#undef OP_LIST_OP_CODE_ITERATOR
+#undef OP_CODES_MF
+#undef OP_CODES_M
+#undef OP_CODES_none
+static_assert(std::size(handler_op_codes) == h_invalid);
+
+// The variant of every handler that checks M and F when it runs: the indexed variant of a direct one, and the handler itself otherwise.
+// With I = 0 an indexed variant finds the same M as the direct one, and traps on it in the same way.
+#define OP_CHECKED_none(OP_NAME) h_##OP_NAME,
+#define OP_CHECKED_M(OP_NAME) h_##OP_NAME##_indexed, h_##OP_NAME##_indexed,
+#define OP_CHECKED_MF(OP_NAME) h_##OP_NAME##_indexed_full, h_##OP_NAME##_indexed, h_##OP_NAME##_indexed_full, h_##OP_NAME##_indexed,
+#define OP_LIST_CHECKED_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND, ...) OP_CHECKED_##KIND(OP_NAME)
+#define OP_LIST_FIELD_CHECKED_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND, ...) OP_CHECKED_##KIND(OP_NAME)
+#define OP_LIST_REGISTER_CHECKED_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER, KIND, ...) OP_CHECKED_##KIND(OP_NAME)
+#define OP_LIST_FIELD_REGISTER_CHECKED_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER, KIND, ...) OP_CHECKED_##KIND(OP_NAME)
+constexpr OpHandler handler_checked_variants[] = {
+    OP_LIST(OP_LIST_CHECKED_ITERATOR, OP_LIST_FIELD_CHECKED_ITERATOR, OP_LIST_REGISTER_CHECKED_ITERATOR, OP_LIST_FIELD_REGISTER_CHECKED_ITERATOR)
+};
+#undef OP_LIST_FIELD_REGISTER_CHECKED_ITERATOR
+#undef OP_LIST_REGISTER_CHECKED_ITERATOR
+#undef OP_LIST_FIELD_CHECKED_ITERATOR
+#undef OP_LIST_CHECKED_ITERATOR
+#undef OP_CHECKED_MF
+#undef OP_CHECKED_M
+#undef OP_CHECKED_none
+static_assert(std::size(handler_checked_variants) == h_invalid);
+
+// Whether every handler variant reads or writes the field F of M, rather than taking F as part of the op
+#define OP_READS_FIELD_none false,
+#define OP_READS_FIELD_M false, false,
+#define OP_READS_FIELD_MF true, true, true, true,
+#define OP_LIST_READS_FIELD_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND, ...) OP_READS_FIELD_##KIND
+#define OP_LIST_FIELD_READS_FIELD_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND, ...) OP_READS_FIELD_##KIND
+#define OP_LIST_REGISTER_READS_FIELD_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER, KIND, ...) OP_READS_FIELD_##KIND
+#define OP_LIST_FIELD_REGISTER_READS_FIELD_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER, KIND, ...) OP_READS_FIELD_##KIND
+constexpr bool handler_reads_field[] = {
+    OP_LIST(OP_LIST_READS_FIELD_ITERATOR, OP_LIST_FIELD_READS_FIELD_ITERATOR, OP_LIST_REGISTER_READS_FIELD_ITERATOR, OP_LIST_FIELD_REGISTER_READS_FIELD_ITERATOR)
+};
+#undef OP_LIST_FIELD_REGISTER_READS_FIELD_ITERATOR
+#undef OP_LIST_REGISTER_READS_FIELD_ITERATOR
+#undef OP_LIST_FIELD_READS_FIELD_ITERATOR
+#undef OP_LIST_READS_FIELD_ITERATOR
+#undef OP_READS_FIELD_MF
+#undef OP_READS_FIELD_M
+#undef OP_READS_FIELD_none
+static_assert(std::size(handler_reads_field) == h_invalid);
+
+// Picks the handler variant of an op for the I and F of an instruction word
+#define OP_SELECT_none(OP_NAME) \
+    h_##OP_NAME
+#define OP_SELECT_M(OP_NAME) \
+    (I == 0 ? h_##OP_NAME##_direct : h_##OP_NAME##_indexed)
+#define OP_SELECT_MF(OP_NAME) \
+    (I == 0 \
+        ? (F == full_word_field ? h_##OP_NAME##_direct_full : h_##OP_NAME##_direct) \
+        : (F == full_word_field ? h_##OP_NAME##_indexed_full : h_##OP_NAME##_indexed))
+
+// Maps (C, F) to a handler, and I and F to its variant.
+// OP_LIST is searched in order, so when several entries share an op code the first one wins,
+// just as in the original op code dispatch.
+constexpr
+OpHandler
+decode_handler(NativeByte C, NativeByte F, NativeByte I)
+{
+#define OP_LIST_DECODE_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND, ...) \
+    if (C == OP_CODE) \
+        return OP_SELECT_##KIND(OP_NAME);
+
+#define OP_LIST_FIELD_DECODE_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND, ...) \
+    if (C == OP_CODE && F == OP_FIELD) \
+        return OP_SELECT_##KIND(OP_NAME);
+
+#define OP_LIST_REGISTER_DECODE_ITERATOR(OP_NAME, OP_CODE, FUNC, REGISTER, KIND, ...) \
+    OP_LIST_DECODE_ITERATOR(OP_NAME, OP_CODE, FUNC, KIND)
+
+#define OP_LIST_FIELD_REGISTER_DECODE_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, REGISTER, KIND, ...) \
+    OP_LIST_FIELD_DECODE_ITERATOR(OP_NAME, OP_CODE, OP_FIELD, FUNC, KIND)
+
+    OP_LIST(OP_LIST_DECODE_ITERATOR, OP_LIST_FIELD_DECODE_ITERATOR, OP_LIST_REGISTER_DECODE_ITERATOR, OP_LIST_FIELD_REGISTER_DECODE_ITERATOR)
+
+#undef OP_LIST_FIELD_REGISTER_DECODE_ITERATOR
+#undef OP_LIST_REGISTER_DECODE_ITERATOR
+#undef OP_LIST_FIELD_DECODE_ITERATOR
+#undef OP_LIST_DECODE_ITERATOR
+    return h_invalid;
+}
+
+// Verifies an instruction word once, when it is decoded, for the handler variant that runs it.
+// A direct variant takes M and F as proven valid and checks neither, so a direct instruction whose M is not an address,
+// or whose F is not a field when the op reads one, runs the checked variant instead and traps there.
+// Indexed variants keep checking I and M, since rIi can change between runs.
+constexpr
+OpHandler
+verified_handler(OpHandler handler, bool M_is_address, bool F_is_field)
+{
+    if (handler >= h_invalid || (M_is_address && (F_is_field || !handler_reads_field[handler])))
+        return handler;
+    return handler_checked_variants[handler];
+}
+
+// Execution time of an instruction in units of u, as tabulated by Knuth
+constexpr
+NativeByte
+execution_time(NativeByte C, NativeByte F)
+{
+    switch (C)
+    {
+    case op_mul:
+        return 10;
+    case op_div:
+        return 12;
+    case op_hlt:
+        // Same for NUM and CHAR
+        return 10;
+    case op_move:
+        return 1 + 2 * F;
+    case op_add:
+    case op_sub:
+    case op_sla:
+        return 2;
+    default:
+        // Loads, stores and comparisons take 2, jumps, I/O and address transfers take 1
+        return (C >= op_lda && C <= op_stz) || C >= op_cmpa ? 2 : 1;
+    }
+}
+
+static_assert(decode_handler(op_hlt, 2, 0) == h_hlt);
+static_assert(decode_handler(op_hlt, 3, 0) == h_invalid);
+static_assert(decode_handler(op_add, 6, 0) == h_fadd);
+static_assert(decode_handler(op_add, 7, 0) == h_add_direct);
+static_assert(decode_handler(op_add, full_word_field, 0) == h_add_direct_full);
+static_assert(decode_handler(op_lda, full_word_field, 2) == h_lda_indexed_full);
+static_assert(decode_handler(op_ent1, 2, 3) == h_ent1_indexed);
+static_assert(handler_op_codes[h_lda_indexed_full] == op_lda);
+static_assert(handler_op_codes[h_hlt] == op_hlt);
+static_assert(handler_op_codes[h_cmpx_indexed] == op_cmpx);
+static_assert(verified_handler(h_add_direct, true, false) == h_add_indexed);
+static_assert(verified_handler(h_lda_direct_full, false, true) == h_lda_indexed_full);
+static_assert(verified_handler(h_move_direct, true, false) == h_move_direct);
+static_assert(verified_handler(h_jmp_direct, false, true) == h_jmp_indexed);
+static_assert(verified_handler(h_hlt, false, false) == h_hlt);
+
+}
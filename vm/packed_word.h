@@ -0,0 +1,180 @@
+#pragma once
+#include <base/base.h>
+#include <base/validation/constants.h>
+
+#include <bit>
+#include <cstdint>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// A MIX word packed into one native integer.
+// Numerical byte i (1 to 5) takes packed_byte_bits bits, byte 5 being the least significant,
+// and the sign takes the most significant bit.
+// Any field (L:R) is then a shift and a mask away.
+using PackedWord = std::uint64_t;
+
+// The fewest bits that hold every value of a MIX byte
+constexpr size_t packed_byte_bits = std::bit_width(byte_size - 1);
+
+constexpr PackedWord packed_sign_bit = PackedWord(1) << 63;
+
+// When byte_size is a power of 2, the numerical bytes of a packed word are its native magnitude
+constexpr bool packed_magnitude_is_native = std::has_single_bit(byte_size);
+
+static_assert(numerical_bytes_in_word * packed_byte_bits < 63);
+
+// Mask of the rightmost `count` bytes of a packed word
+constexpr PackedWord packed_low_bytes_mask(size_t count)
+{
+    return (PackedWord(1) << (count * packed_byte_bits)) - 1;
+}
+
+// Bit offset of the right end of numerical byte i, i.e. how far to shift so that byte i becomes the rightmost
+constexpr size_t packed_byte_shift(size_t i)
+{
+    return (numerical_bytes_in_word - i) * packed_byte_bits;
+}
+
+constexpr Sign packed_sign(PackedWord word)
+{
+    return Sign(word >> 63);
+}
+
+constexpr PackedWord pack_sign(Sign sign)
+{
+    return PackedWord(sign) << 63;
+}
+
+// Converts the rightmost packed bytes to the native value they represent
+constexpr NativeInt unpack_magnitude(PackedWord bytes)
+{
+    if constexpr (packed_magnitude_is_native)
+        return bytes;
+    else
+    {
+        NativeInt magnitude = 0;
+        for (size_t i = numerical_bytes_in_word; i --> 0;)
+            magnitude = magnitude * byte_size + ((bytes >> (i * packed_byte_bits)) & packed_low_bytes_mask(1));
+        return magnitude;
+    }
+}
+
+// Converts a non-negative native value to its rightmost packed bytes
+constexpr PackedWord pack_magnitude(NativeInt magnitude)
+{
+    if constexpr (packed_magnitude_is_native)
+        return magnitude;
+    else
+    {
+        PackedWord bytes = 0;
+        for (size_t i = 0; magnitude > 0; i++, magnitude /= byte_size)
+            bytes |= PackedWord(magnitude % byte_size) << (i * packed_byte_bits);
+        return bytes;
+    }
+}
+
+// Returns numerical byte i (1 to 5)
+[[gnu::always_inline]] inline
+ValidatedByte packed_byte(PackedWord word, size_t i)
+{
+    NativeInt const bits = (word >> packed_byte_shift(i)) & packed_low_bytes_mask(1);
+    return ValidatedUtils::from_mod<byte_size>(std::get<1>(ValidatedUtils::from_abs(bits)));
+}
+
+[[gnu::always_inline]] inline
+PackedWord pack(std::span<Byte const, bytes_in_word> word)
+{
+    PackedWord result = pack_sign(word[0].sign);
+    for (size_t i = 1; i < bytes_in_word; i++)
+        result |= PackedWord(word[i].byte) << packed_byte_shift(i);
+    return result;
+}
+
+[[gnu::always_inline]] inline
+std::array<Byte, bytes_in_word> unpack(PackedWord word)
+{
+    std::array<Byte, bytes_in_word> result;
+    result[0] = packed_sign(word);
+    for (size_t i = 1; i < bytes_in_word; i++)
+        result[i] = packed_byte(word, i);
+    return result;
+}
+
+// How to reach the field (L:R) of a packed word, where F = 8L + R
+struct PackedField
+{
+    // L <= R <= 5
+    bool valid;
+    // L is 0
+    bool has_sign;
+    // Brings byte R to the right end of the word
+    NativeByte shift;
+    // The numerical bytes of the field, once shifted
+    PackedWord magnitude_mask;
+    // The bits replaced when storing into the field, the sign bit included when L is 0
+    PackedWord store_mask;
+};
+
+constexpr PackedField make_packed_field(NativeByte F)
+{
+    NativeByte const L = F / 8;
+    NativeByte const R = F % 8;
+    if (L > R || R > numerical_bytes_in_word)
+        return PackedField{.valid = false, .has_sign = false, .shift = 0, .magnitude_mask = 0, .store_mask = 0};
+
+    NativeByte const first_numerical = std::max<NativeByte>(L, 1);
+    PackedWord const magnitude_mask = packed_low_bytes_mask(R + 1 - first_numerical);
+    NativeByte const shift = packed_byte_shift(R);
+    return PackedField{
+        .valid = true,
+        .has_sign = L == 0,
+        .shift = shift,
+        .magnitude_mask = magnitude_mask,
+        .store_mask = magnitude_mask << shift | (L == 0 ? packed_sign_bit : 0),
+    };
+}
+
+// Indexed by F. Only the first 64 entries can be valid, since L and R are at most 7.
+constexpr std::array<PackedField, byte_size> packed_fields = []{
+    std::array<PackedField, byte_size> fields;
+    for (NativeByte F = 0; F < byte_size; F++)
+        fields[F] = make_packed_field(F);
+    return fields;
+}();
+
+static_assert(packed_fields[5].valid && packed_fields[5].has_sign && packed_fields[5].shift == 0);
+static_assert(!packed_fields[8 * 3 + 2].valid && !packed_fields[6].valid);
+
+[[gnu::always_inline]] inline
+Sign packed_field_sign(PackedWord word, PackedField const &field)
+{
+    return field.has_sign ? packed_sign(word) : s_plus;
+}
+
+// Returns the numerical bytes of a field as a native value
+[[gnu::always_inline]] inline
+ValidatedNonNegative packed_field_magnitude(PackedWord word, PackedField const &field)
+{
+    NativeInt const magnitude = unpack_magnitude((word >> field.shift) & field.magnitude_mask);
+    return std::get<1>(ValidatedUtils::from_abs(magnitude));
+}
+
+// Returns a field as a native value, which is positive unless the field has the sign
+[[gnu::always_inline]] inline
+NativeInt packed_field_value(PackedWord word, PackedField const &field)
+{
+    NativeInt const magnitude = packed_field_magnitude(word, field);
+    return packed_field_sign(word, field) == s_minus ? -magnitude : magnitude;
+}
+
+// Replaces a field of `into` with the rightmost bytes of `from`, and with its sign when the field has the sign
+[[gnu::always_inline]] inline
+PackedWord packed_store_field(PackedWord into, PackedWord from, PackedField const &field)
+{
+    PackedWord const shifted = (from & ~packed_sign_bit) << field.shift | (from & packed_sign_bit);
+    return (into & ~field.store_mask) | (shifted & field.store_mask);
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
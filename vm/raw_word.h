@@ -0,0 +1,35 @@
+#pragma once
+#include <base/base.h>
+#include <vm/engine.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Fails on a word with a sign other than + and -, or with a byte that does not fit in a MIX byte
+inline Result<std::array<Byte, bytes_in_word>> to_word(RawWord const &raw)
+{
+    std::array<Byte, bytes_in_word> word;
+    if (raw[0] != s_plus && raw[0] != s_minus)
+        return Result<std::array<Byte, bytes_in_word>>::failure();
+    word[0] = Sign(raw[0]);
+    for (size_t i = 1; i < bytes_in_word; i++)
+    {
+        Result<ValidatedByte> const byte = ValidatedByte::constructor(raw[i]);
+        if (!byte)
+            return Result<std::array<Byte, bytes_in_word>>::failure();
+        word[i].byte = byte.value();
+    }
+    return Result<std::array<Byte, bytes_in_word>>::success(word);
+}
+
+inline RawWord to_raw_word(std::array<Byte, bytes_in_word> const &word)
+{
+    RawWord raw;
+    raw[0] = word[0].sign;
+    for (size_t i = 1; i < bytes_in_word; i++)
+        raw[i] = word[i].byte;
+    return raw;
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
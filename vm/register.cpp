@@ -3,6 +3,7 @@
 #include <vm/register.h>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 Sign ZeroRegister::sign() const
 {
@@ -24,22 +25,16 @@ NativeInt ZeroRegister::native_unsigned_value() const
     return 0;
 }
 
-void ZeroRegister::store(SliceMutable slice) const
+PackedWord ZeroRegister::packed_word() const
 {
-    std::fill(
-        slice.sp.begin(), slice.sp.end(), 
-        deduce<IsMixByte>(zero)
-    );
+    return 0;
 }
 
-void ExtendedRegister::load(NativeInt value)
+void ExtendedRegister::load(Sign sign, NativeExtendedUInt magnitude)
 {
-    ByteConversionResult<bytes_in_extended_word> const result = as_bytes<bytes_in_extended_word>(value);
-    if (result.overflow)
-        throw std::runtime_error("Unexpected overflow during multiplication");
-    Sign const sign = result.bytes[0].sign;
-    rA.load(sign, std::span<Byte const, numerical_bytes_in_word>(result.bytes.begin() + 1, numerical_bytes_in_word));
-    rX.load(sign, std::span<Byte const, numerical_bytes_in_word>(result.bytes.begin() + bytes_in_word + 1, numerical_bytes_in_word));
+    rA.sign() = sign;
+    rX.sign() = sign;
+    load_unsigned(magnitude);
 }
 
 Sign ExtendedRegister::sign() const
@@ -47,63 +42,50 @@ Sign ExtendedRegister::sign() const
     return rA.sign();
 }
 
-NativeInt ExtendedRegister::native_value() const
+NativeExtendedUInt ExtendedRegister::native_unsigned_value() const
+{
+    return shift_bytes_up<NativeExtendedUInt>(rA.native_unsigned_value(), numerical_bytes_in_word) + rX.native_unsigned_value();
+}
+
+void ExtendedRegister::load_unsigned(NativeExtendedUInt magnitude)
 {
-    NativeInt const unsigned_rAX_value = rA.native_unsigned_value() * lut[numerical_bytes_in_word] + rX.native_unsigned_value();
-    NativeInt const sign = rA.native_sign();
-    return sign * unsigned_rAX_value;
+    rA.load(rA.sign(), NumberRegister::to_magnitude(NativeInt(shift_bytes_down(magnitude, numerical_bytes_in_word))));
+    rX.load(rX.sign(), NumberRegister::to_magnitude(NativeInt(low_bytes(magnitude, numerical_bytes_in_word))));
 }
 
+// As with Register, shifting by one byte is a multiplication or division by byte_size.
+// The signs of rA and rX are unaffected.
 void ExtendedRegister::shift_left(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Shift should be non-negative");
-    Register<false, NumberRegister::unsigned_size_v * 2> reg;
-    reg.shift_left(shift_by);
-    for (size_t i = 0; i < NumberRegister::unsigned_size_v; i++)
-    {
-        rA.reg[i + 1].byte = reg.reg[i].byte;
-        rX.reg[i + 1].byte = reg.reg[i + NumberRegister::unsigned_size_v].byte;
-    }
+    if (shift_by >= NativeInt(numerical_bytes_in_extended_word))
+        load_unsigned(0);
+    else
+        load_unsigned(shift_bytes_up(low_bytes(native_unsigned_value(), numerical_bytes_in_extended_word - shift_by), shift_by));
 }
 
 void ExtendedRegister::shift_right(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Shift should be non-negative");
-    Register<false, NumberRegister::unsigned_size_v * 2> reg;
-    reg.shift_right(shift_by);
-    for (size_t i = 0; i < NumberRegister::unsigned_size_v; i++)
-    {
-        rA.reg[i + 1].byte = reg.reg[i].byte;
-        rX.reg[i + 1].byte = reg.reg[i + NumberRegister::unsigned_size_v].byte;
-    }
+    if (shift_by >= NativeInt(numerical_bytes_in_extended_word))
+        load_unsigned(0);
+    else
+        load_unsigned(shift_bytes_down(native_unsigned_value(), shift_by));
 }
 
 void ExtendedRegister::shift_left_circular(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Shift should be non-negative");
-    Register<false, NumberRegister::unsigned_size_v * 2> reg;
-    reg.shift_left_circular(shift_by);
-    for (size_t i = 0; i < NumberRegister::unsigned_size_v; i++)
-    {
-        rA.reg[i + 1].byte = reg.reg[i].byte;
-        rX.reg[i + 1].byte = reg.reg[i + NumberRegister::unsigned_size_v].byte;
-    }
+    shift_by %= numerical_bytes_in_extended_word;
+    NativeExtendedUInt const magnitude = native_unsigned_value();
+    load_unsigned(
+        shift_bytes_up(low_bytes(magnitude, numerical_bytes_in_extended_word - shift_by), shift_by)
+        + shift_bytes_down(magnitude, numerical_bytes_in_extended_word - shift_by)
+    );
 }
 
 void ExtendedRegister::shift_right_circular(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Shift should be non-negative");
-    Register<false, NumberRegister::unsigned_size_v * 2> reg;
-    reg.shift_right_circular(shift_by);
-    for (size_t i = 0; i < NumberRegister::unsigned_size_v; i++)
-    {
-        rA.reg[i + 1].byte = reg.reg[i].byte;
-        rX.reg[i + 1].byte = reg.reg[i + NumberRegister::unsigned_size_v].byte;
-    }
+    shift_by %= numerical_bytes_in_extended_word;
+    shift_left_circular(numerical_bytes_in_extended_word - shift_by);
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -1,11 +1,12 @@
 #pragma once
+#include <config.h>
+
 #include <cstddef>
 namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
     
 struct TypeErasedRegister;
-template <size_t size>
-struct RegisterWithoutSign;
 template <bool is_signed, size_t size>
 struct Register;
 
@@ -15,4 +16,5 @@ struct JumpRegister;
 
 struct ExtendedRegister;
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
@@ -2,9 +2,11 @@
 #include "base/validation/validator.impl.h"
 #include <base/base.h>
 #include <base/validation/constants.h>
+#include <vm/packed_word.h>
 #include <vm/register.decl.h>
-namespace mix 
+namespace mix
 {
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 struct ZeroRegister final
 {
@@ -12,69 +14,65 @@ struct ZeroRegister final
     ValidatedInt<IsInClosedInterval<-1, 1>> native_sign() const;
     NativeInt native_value() const;
     NativeInt native_unsigned_value() const;
-    void store(SliceMutable slice) const;
+    PackedWord packed_word() const;
 };
 
+// A register is kept as a sign and a native magnitude instead of an array of bytes,
+// since nearly every instruction wants its native value.
+// The bytes are only materialised by `word()` when a partial field needs them.
 template <bool is_signed, size_t size>
-struct Register 
+struct Register
 {
     static constexpr bool is_signed_v = is_signed;
     static constexpr size_t size_v = size;
     static constexpr size_t unsigned_size_v = is_signed ? size - 1 : size;
     static constexpr size_t numerical_first_idx = is_signed ? 1 : 0;
+    static_assert(unsigned_size_v <= numerical_bytes_in_word);
 
-    std::array<Byte, size> reg = { { [0] = is_signed ? s_plus : zero_byte } };
+    using Magnitude = ValidatedInt<IsInClosedInterval<0, lut[unsigned_size_v] - 1>>;
+
+    // Always s_plus for an unsigned register.
+    // Kept separately from the magnitude so that -0 is preserved.
+    Sign sign_ = s_plus;
+    Magnitude magnitude_ = deduce<IsInClosedInterval<0, lut[unsigned_size_v] - 1>>(to_interval(zero));
 
     Register() = default;
-    
-    Register(std::array<Byte, size> reg)
-        : reg(reg)
-    {}
-   
-    template <typename = void>
-    requires (is_signed)
-    RegisterWithoutSign<size - 1> unsigned_register() const;
 
-    std::span<Byte> get_span() { return reg; }
+    // Keeps the rightmost bytes of a non-negative value, i.e. the value modulo the register's range
+    static Magnitude to_magnitude(NativeInt value);
 
     std::conditional_t<is_signed, Sign &, Sign> sign();
     Sign sign() const;
     ValidatedInt<IsInClosedInterval<-1, 1>> native_sign() const;
 
-    IntMutable<is_signed, size> value();
-    IntMutable<false, unsigned_size_v> unsigned_value();
+    ValidatedInt<IsInClosedInterval<-(lut[unsigned_size_v] - 1), lut[unsigned_size_v] - 1>> native_value() const;
+    Magnitude native_unsigned_value() const;
+
+    // Returns the register as a MIX word, with the unused leading bytes set to zero.
+    std::array<Byte, bytes_in_word> word() const;
 
-    IntView<is_signed, size> value() const;
-    IntView<false, unsigned_size_v> unsigned_value() const;
+    // Same as word(), packed
+    PackedWord packed_word() const;
 
-    ValidatedInt<IsInClosedInterval<-(lut[unsigned_size_v] - 1), lut[unsigned_size_v] - 1>> native_value() const;
-    ValidatedInt<IsInClosedInterval<0, lut[unsigned_size_v] - 1>> native_unsigned_value() const;
+    // Loads the sign and the rightmost bytes of a MIX word.
+    void load(std::span<Byte const, bytes_in_word> word);
 
-    void load(std::span<Byte const, size> sp);
+    void load(Sign sign, Magnitude magnitude);
 
-    template <typename = void>
-    requires (is_signed)
-    void load(Sign sign, std::span<Byte const, size - 1> sp);
+    // Returns whether the load overflows, in which case only the rightmost bytes are kept
+    bool load(Sign sign, ValidatedNonNegative magnitude);
 
-    // Returns whether the load overflows
-    template <bool throw_on_overflow>
-    std::conditional_t<throw_on_overflow, void, bool> load(NativeInt value);
+    // Returns whether the load overflows, in which case only the rightmost bytes are kept
+    bool load(NativeInt value);
 
     void load_zero(Sign sign)
-    { 
+    {
         if constexpr (is_signed)
-        {
-            reg[0].sign = sign; 
-            std::fill(reg.begin() + 1, reg.end(), deduce<IsInClosedInterval<0, byte_size - 1>>(to_interval(zero)));
-        }
-        else
-        {
-            std::fill(reg.begin(), reg.end(), deduce<IsInClosedInterval<0, byte_size - 1>>(to_interval(zero)));
-        }
+            sign_ = sign;
+        magnitude_ = deduce<IsInClosedInterval<0, lut[unsigned_size_v] - 1>>(to_interval(zero));
     }
 
-    void store(SliceMutable slice) const;
-
+    // shift_by must be non-negative, which it is when it comes from M
     void shift_left(NativeInt shift_by);
 
     void shift_right(NativeInt shift_by);
@@ -82,49 +80,22 @@ struct Register
     void shift_left_circular(NativeInt shift_by);
 
     void shift_right_circular(NativeInt shift_by);
-
-    operator IntegralContainer<OwnershipKind::mutable_view, is_signed, size>()
-    {
-        return IntegralContainer<OwnershipKind::mutable_view, is_signed, size>(reg);
-    }
-
-    operator IntegralContainer<OwnershipKind::view, is_signed, size>() const
-    {
-        return IntegralContainer<OwnershipKind::view, is_signed, size>(reg);
-    }
-};
-
-template <size_t size>
-struct RegisterWithoutSign final
-{
-    std::span<Byte, size> reg;
-
-    RegisterWithoutSign(Register<true, size> register_storage)
-        : reg(register_storage.reg.begin(), register_storage.reg.end())
-    {}
-
-    IntMutable<false, size> unsigned_value();
-    IntView<false, size> unsigned_value() const;
-
-    ValidatedInt<IsInClosedInterval<0, lut[size] - 1>> native_unsigned_value() const;
-
-    void store(Sign sign, SliceMutable slice) const;
 };
 
 struct NumberRegister final : public Register<true, 6>
-{ 
-    bool increment(NativeInt addend) 
-    { 
-        return load<false>(native_value() + addend); 
+{
+    bool increment(NativeInt addend)
+    {
+        return load(native_value() + addend);
     };
 };
 
 struct IndexRegister final : public Register<true, 3>
 {
+    // Returns whether the result does not fit, which MIX leaves undefined
     bool increment(NativeInt addend)
     {
-        load<true>(native_value() + addend);
-        return false;
+        return load(native_value() + addend);
     }
 };
 
@@ -137,10 +108,15 @@ struct ExtendedRegister final
     NumberRegister &rA, &rX;
 
     Sign sign() const;
-    NativeInt native_value() const;
 
-    void load(NativeInt value);
+    // rA and rX side by side, as one unsigned magnitude of 10 bytes
+    NativeExtendedUInt native_unsigned_value() const;
+
+    // Sets the signs of both rA and rX.
+    // The magnitude must fit in 10 bytes, which the product of two words does.
+    void load(Sign sign, NativeExtendedUInt magnitude);
 
+    // shift_by must be non-negative, which it is when it comes from M
     void shift_left(NativeInt shift_by);
 
     void shift_right(NativeInt shift_by);
@@ -148,6 +124,10 @@ struct ExtendedRegister final
     void shift_left_circular(NativeInt shift_by);
 
     void shift_right_circular(NativeInt shift_by);
+
+    // Leaves the signs of rA and rX as they are
+    void load_unsigned(NativeExtendedUInt magnitude);
 };
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
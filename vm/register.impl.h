@@ -3,46 +3,21 @@
 #include "config.impl.h"
 #include <vm/register.defn.h>
 
-#include <stdexcept>
 namespace mix
 {
-
-template <size_t size>
-IntMutable<false, size> RegisterWithoutSign<size>::unsigned_value() 
-{
-    return IntMutable<false, size>(std::span<Byte, size>(reg.begin(), reg.end()));
-}
-
-template <size_t size>
-IntView<false, size> RegisterWithoutSign<size>::unsigned_value() const
-{
-    return REMOVE_CONST_FROM_PTR(this)->unsigned_value();
-}
-
-template <size_t size>
-ValidatedInt<IsInClosedInterval<0, lut[size] - 1>> RegisterWithoutSign<size>::native_unsigned_value() const
-{
-    return unsigned_value().native_value();
-}
-
-template <size_t size>
-void RegisterWithoutSign<size>::store(Sign sign, SliceMutable slice) const
-{
-}
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
 
 template <bool is_signed, size_t size>
-template <typename>
-requires (is_signed)
-RegisterWithoutSign<size - 1> Register<is_signed, size>::unsigned_register() const
+typename Register<is_signed, size>::Magnitude Register<is_signed, size>::to_magnitude(NativeInt value)
 {
-    return RegisterWithoutSign<size - 1>(std::span<Byte, size - 1>(reg.begin() + 1, reg.end()));
+    return ValidatedUtils::from_mod<lut[unsigned_size_v]>(std::get<1>(ValidatedUtils::from_abs(value)));
 }
 
 template <bool is_signed, size_t size>
 std::conditional_t<is_signed, Sign &, Sign> Register<is_signed, size>::sign()
 {
     if constexpr (is_signed)
-        return reg[0].sign;
+        return sign_;
     else
         return s_plus;
 }
@@ -60,143 +35,103 @@ ValidatedInt<IsInClosedInterval<-1, 1>> Register<is_signed, size>::native_sign()
 }
 
 template <bool is_signed, size_t size>
-IntMutable<is_signed, size>
-Register<is_signed, size>::value()
-{
-    return IntMutable<is_signed, size>(reg);
-}
-
-template <bool is_signed, size_t size>
-IntMutable<false, Register<is_signed, size>::unsigned_size_v>
-Register<is_signed, size>::unsigned_value()
-{
-    return IntMutable<false, Register<is_signed, size>::unsigned_size_v>(std::span<Byte, unsigned_size_v>(reg.begin() + (is_signed ? 1 : 0), reg.end()));
-}
-
-template <bool is_signed, size_t size>
-IntView<is_signed, size>
-Register<is_signed, size>::value() const
+ValidatedInt<IsInClosedInterval<-(lut[Register<is_signed, size>::unsigned_size_v] - 1), lut[Register<is_signed, size>::unsigned_size_v] - 1>> 
+Register<is_signed, size>::native_value() const
 {
-    return REMOVE_CONST_FROM_PTR(this)->value();
+    return native_sign() * magnitude_;
 }
 
 template <bool is_signed, size_t size>
-IntView<false, Register<is_signed, size>::unsigned_size_v>
-Register<is_signed, size>::unsigned_value() const
+typename Register<is_signed, size>::Magnitude
+Register<is_signed, size>::native_unsigned_value() const
 {
-    return REMOVE_CONST_FROM_PTR(this)->unsigned_value();
+    return magnitude_;
 }
 
 template <bool is_signed, size_t size>
-ValidatedInt<IsInClosedInterval<-(lut[Register<is_signed, size>::unsigned_size_v] - 1), lut[Register<is_signed, size>::unsigned_size_v] - 1>> 
-Register<is_signed, size>::native_value() const
+std::array<Byte, bytes_in_word> Register<is_signed, size>::word() const
 {
-    return value().native_value();
+    // Through the packed form, which takes shifts rather than divisions when byte_size is a power of 2
+    return unpack(packed_word());
 }
 
 template <bool is_signed, size_t size>
-ValidatedInt<IsInClosedInterval<0, lut[Register<is_signed, size>::unsigned_size_v] - 1>> 
-Register<is_signed, size>::native_unsigned_value() const
+void Register<is_signed, size>::load(std::span<Byte const, bytes_in_word> word)
 {
-    return unsigned_value().native_value();
+    if constexpr (is_signed)
+        sign_ = word[0].sign;
+    magnitude_ = IntView<false, unsigned_size_v>(word.template last<unsigned_size_v>()).native_value();
 }
 
 template <bool is_signed, size_t size>
-void Register<is_signed, size>::load(std::span<Byte const, size> sp)
+void Register<is_signed, size>::load(Sign sign, Magnitude magnitude)
 {
-    std::copy(sp.begin(), sp.end(), reg.begin());
+    if constexpr (is_signed)
+        sign_ = sign;
+    magnitude_ = magnitude;
 }
 
 template <bool is_signed, size_t size>
-template <bool throw_on_overflow>
-std::conditional_t<throw_on_overflow, void, bool> Register<is_signed, size>::load(NativeInt value)
+PackedWord Register<is_signed, size>::packed_word() const
 {
-    ByteConversionResult<size> const result = as_bytes<size>(value);
-    
-    if constexpr (throw_on_overflow)
-    {
-        if (result.overflow)
-            throw std::runtime_error("overflow after conversion to bytes");
-    }
-
-    load(result.bytes);
-    if constexpr (!throw_on_overflow)
-        return result.overflow;
+    return pack_sign(sign()) | pack_magnitude(magnitude_);
 }
 
 template <bool is_signed, size_t size>
-template <typename>
-requires (is_signed)
-void Register<is_signed, size>::load(Sign sign, std::span<Byte const, size - 1> sp)
+bool Register<is_signed, size>::load(Sign sign, ValidatedNonNegative magnitude)
 {
-    reg[0].sign = sign;
-    std::copy(sp.begin(), sp.end(), reg.begin() + 1);
+    if constexpr (is_signed)
+        sign_ = sign;
+    magnitude_ = ValidatedUtils::from_mod<lut[unsigned_size_v]>(magnitude);
+    return magnitude >= lut[unsigned_size_v];
 }
 
 template <bool is_signed, size_t size>
-void Register<is_signed, size>::store(SliceMutable slice) const
+bool Register<is_signed, size>::load(NativeInt value)
 {
-    if (slice.is_signed())
-    {
-        slice.sp[0].sign = reg.sign();
-        std::copy(reg.end() - (slice.length() - 1), reg.end(), slice.sp.begin() + 1);
-    }
-    else
-    {
-        std::copy(reg.end() - slice.length(), reg.end(), slice.sp.begin());
-    }
+    auto const [
+        value_sign,
+        abs_value
+    ] = ValidatedUtils::from_abs(value);
+    return load(value_sign, abs_value);
 }
 
+// Shifts work on the magnitude directly, a shift by one byte being a multiplication or division by byte_size.
 template <bool is_signed, size_t size>
 void Register<is_signed, size>::shift_left(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Should be non-negative");
-
-    size_t i;
-    for (i = numerical_first_idx; i < size - shift_by; i++)
-        reg[i] = reg[i + shift_by];
-
-    for (; i < size;)
-        reg[i] = zero_byte;
+    if (shift_by >= NativeInt(unsigned_size_v))
+        load_zero(sign());
+    else
+        magnitude_ = to_magnitude(shift_bytes_up<NativeInt>(low_bytes<NativeInt>(magnitude_, unsigned_size_v - shift_by), shift_by));
 }
 
 template <bool is_signed, size_t size>
 void Register<is_signed, size>::shift_right(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Should be non-negative");
-
-    size_t i;
-    for (i = size; i --> shift_by + numerical_first_idx;)
-        reg[i] = reg[i - shift_by];
-
-    for (; i --> numerical_first_idx;)
-        reg[i] = zero_byte;
+    if (shift_by >= NativeInt(unsigned_size_v))
+        load_zero(sign());
+    else
+        magnitude_ = to_magnitude(shift_bytes_down<NativeInt>(magnitude_, shift_by));
 }
 
 template <bool is_signed, size_t size>
 void Register<is_signed, size>::shift_left_circular(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Should be non-negative");
-    
     shift_by %= unsigned_size_v;
-    std::reverse(reg.begin() + numerical_first_idx, reg.end());
-    std::reverse(reg.begin(), reg.end() - shift_by);
-    std::reverse(reg.end() - shift_by, reg.end());
+    NativeInt const magnitude = magnitude_;
+    magnitude_ = to_magnitude(
+        shift_bytes_up(low_bytes(magnitude, unsigned_size_v - shift_by), shift_by)
+        + shift_bytes_down(magnitude, unsigned_size_v - shift_by)
+    );
 }
 
 template <bool is_signed, size_t size>
 void Register<is_signed, size>::shift_right_circular(NativeInt shift_by)
 {
-    if (shift_by < 0)
-        throw std::runtime_error("Should be non-negative");
-
     shift_by %= unsigned_size_v;
-    std::reverse(reg.begin() + numerical_first_idx, reg.end());
-    std::reverse(reg.begin(), reg.begin() + shift_by);
-    std::reverse(reg.begin() + shift_by, reg.end());
+    shift_left_circular(unsigned_size_v - shift_by);
 }
 
+MIX_END_BYTE_SIZE_NAMESPACE
 }
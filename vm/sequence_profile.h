@@ -0,0 +1,113 @@
+#pragma once
+#include <base/base.h>
+#include <vm/op_list.h>
+#include <vm/superinstruction.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string_view>
+#include <vector>
+namespace mix
+{
+
+// Counts how often each sequence of 2 or 3 handlers ran straight through consecutive cells,
+// i.e. how often a superinstruction for it would have run (see vm/superinstruction.h).
+// Filled in by Machine::run while set with Machine::set_sequence_profile, across as many runs and programs as it is given.
+class SequenceProfile
+{
+public:
+    using Sequence = std::vector<OpHandler>;
+
+    std::map<Sequence, std::uint64_t> counts;
+
+private:
+    // The instructions that ran last, which the next one may extend into a sequence
+    std::array<OpHandler, max_superinstruction_length - 1> window;
+    size_t window_length = 0;
+    NativeByte last_address = 0;
+
+public:
+    // Forgets the instructions that ran last, so that the next one does not extend them
+    void break_sequence()
+    {
+        window_length = 0;
+    }
+
+    // Called after each instruction that completes
+    void record(NativeByte address, OpHandler handler)
+    {
+        if (window_length > 0 && address != last_address + 1)
+            window_length = 0;
+        for (size_t start = 0; start < window_length; start++)
+        {
+            Sequence sequence(window.begin() + start, window.begin() + window_length);
+            sequence.push_back(handler);
+            counts[sequence]++;
+        }
+        if (!fuses_with_next(handler))
+        {
+            window_length = 0;
+            return;
+        }
+        if (window_length == window.size())
+        {
+            std::copy(window.begin() + 1, window.end(), window.begin());
+            window_length--;
+        }
+        window[window_length++] = handler;
+        last_address = address;
+    }
+
+    // One line per sequence: its count, then the names of its handlers
+    void write(std::FILE *file) const
+    {
+        for (auto const &[sequence, count] : counts)
+        {
+            std::fprintf(file, "%llu", static_cast<unsigned long long>(count));
+            for (OpHandler const handler : sequence)
+                std::fprintf(file, " %.*s", int(handler_names[handler].size()), handler_names[handler].data());
+            std::fprintf(file, "\n");
+        }
+    }
+
+    // Adds the counts written by write.
+    // Fails on a line that is not a count followed by 2 or 3 handler names.
+    Result<void> read(std::FILE *file)
+    {
+        unsigned long long count;
+        char line[256];
+        while (std::fgets(line, sizeof(line), file) != nullptr)
+        {
+            int consumed = 0;
+            if (std::sscanf(line, "%llu%n", &count, &consumed) != 1)
+                return Result<void>::failure();
+            Sequence sequence;
+            std::string_view rest(line + consumed);
+            while (true)
+            {
+                size_t const start = rest.find_first_not_of(" \t\r\n");
+                if (start == std::string_view::npos)
+                    break;
+                rest.remove_prefix(start);
+                std::string_view const name = rest.substr(0, rest.find_first_of(" \t\r\n"));
+                rest.remove_prefix(name.size());
+                OpHandler handler = h_invalid;
+                for (size_t h = 0; h < h_invalid; h++)
+                    if (handler_names[h] == name)
+                        handler = OpHandler(h);
+                if (handler == h_invalid)
+                    return Result<void>::failure();
+                sequence.push_back(handler);
+            }
+            if (sequence.size() < 2 || sequence.size() > max_superinstruction_length)
+                return Result<void>::failure();
+            counts[sequence] += count;
+        }
+        return Result<void>::success();
+    }
+};
+
+}
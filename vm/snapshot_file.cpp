@@ -0,0 +1,160 @@
+#include <base/base.h>
+#include <vm/atomic_file.h>
+#include <vm/fnv1a.h>
+#include <vm/machine.h>
+#include <vm/snapshot_file.h>
+
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+namespace
+{
+
+constexpr size_t snapshot_file_size = snapshot_file_memory_offset + main_memory_size * sizeof(PackedWord);
+
+// fnv1a over the header, then over the memory a word at a time, in 4 interleaved lanes that are folded together at the end,
+// so that the multiplications do not wait on one another and mapping a file stays within microseconds
+std::uint64_t snapshot_file_checksum(SnapshotFileHeader header, std::span<PackedWord const, main_memory_size> memory)
+{
+    static_assert(main_memory_size % 4 == 0);
+    header.checksum = 0;
+    std::uint64_t const h = fnv1a(fnv1a_basis, std::as_bytes(std::span(&header, 1)));
+    std::array<std::uint64_t, 4> lanes{h, h + 1, h + 2, h + 3};
+    for (size_t i = 0; i < main_memory_size; i += lanes.size())
+    {
+        for (size_t k = 0; k < lanes.size(); k++)
+        {
+            lanes[k] ^= memory[i + k];
+            lanes[k] *= 0x100000001b3;
+        }
+    }
+    return fnv1a(h, std::as_bytes(std::span(lanes)));
+}
+
+// Whether a packed word has a sign and bytes rightmost bytes, each of which fits in a MIX byte, and nothing else
+bool is_packed_word_of(PackedWord const word, size_t const bytes)
+{
+    PackedWord const magnitude = word & ~packed_sign_bit;
+    if ((magnitude & ~packed_low_bytes_mask(bytes)) != 0)
+        return false;
+    if constexpr (!packed_magnitude_is_native)
+    {
+        for (size_t i = 0; i < bytes; i++)
+            if (((magnitude >> (i * packed_byte_bits)) & packed_low_bytes_mask(1)) >= byte_size)
+                return false;
+    }
+    return true;
+}
+
+bool is_valid_snapshot(SnapshotFileHeader const &header, std::span<PackedWord const, main_memory_size> memory)
+{
+    if (std::memcmp(header.magic, SnapshotFileHeader::expected_magic, sizeof header.magic) != 0
+        || header.version != SnapshotFileHeader::current_version
+        || header.byte_size != byte_size
+        || header.checksum != snapshot_file_checksum(header, memory))
+        return false;
+    // pc may be just past the end of memory, where running traps
+    if (header.pc > main_memory_size || header.overflow > 1 || header.comparison < -1 || header.comparison > 1)
+        return false;
+    if (header.io_op == 0 ? header.io_unit != 0 || header.io_M != 0
+            : (header.io_op != op_ioc && header.io_op != op_in && header.io_op != op_out) || header.io_unit >= byte_size || header.io_M >= main_memory_size)
+        return false;
+    for (size_t i = 0; i < header.registers.size(); i++)
+    {
+        bool const index_or_jump = i >= 1 && i != 7;
+        if (!is_packed_word_of(header.registers[i], index_or_jump ? 2 : numerical_bytes_in_word))
+            return false;
+    }
+    if (packed_sign(header.registers[8]) != s_plus)
+        return false;
+    for (PackedWord const word : memory)
+        if (!is_packed_word_of(word, numerical_bytes_in_word))
+            return false;
+    return true;
+}
+
+}
+
+Result<void, Error> write_snapshot_file(std::filesystem::path const &path, MachineSnapshot const &snapshot, SnapshotCounters const &counters)
+{
+    using ResultType = Result<void, Error>;
+    std::vector<PackedWord> memory(main_memory_size);
+    for (size_t cell = 0; cell < main_memory_size; cell++)
+        memory[cell] = snapshot.memory.load(ValidatedAddress::trusted_constructor(cell).value());
+
+    SnapshotFileHeader header{};
+    std::memcpy(header.magic, SnapshotFileHeader::expected_magic, sizeof header.magic);
+    header.version = SnapshotFileHeader::current_version;
+    header.byte_size = byte_size;
+    header.pc = snapshot.pc;
+    header.registers[0] = snapshot.rA.packed_word();
+    for (size_t i = 0; i < snapshot.index_registers.size(); i++)
+        header.registers[1 + i] = snapshot.index_registers[i].packed_word();
+    header.registers[7] = snapshot.rX.packed_word();
+    header.registers[8] = snapshot.rJ.packed_word();
+    header.overflow = snapshot.overflow;
+    header.comparison = snapshot.comparison < 0 ? -1 : snapshot.comparison > 0 ? 1 : 0;
+    if (snapshot.pending_io)
+    {
+        header.io_op = snapshot.pending_io->op;
+        header.io_unit = snapshot.pending_io->unit;
+        header.io_M = snapshot.pending_io->M;
+    }
+    header.counters = counters;
+    header.checksum = snapshot_file_checksum(header, std::span<PackedWord const, main_memory_size>(memory.data(), main_memory_size));
+
+    std::vector<std::byte> file(snapshot_file_size);
+    std::memcpy(file.data(), &header, sizeof header);
+    std::memcpy(file.data() + snapshot_file_memory_offset, memory.data(), main_memory_size * sizeof(PackedWord));
+
+    if (!write_file_atomically(path, file))
+        return ResultType::failure(err_io);
+    return ResultType::success();
+}
+
+Result<std::shared_ptr<SnapshotFile const>, Error> SnapshotFile::map(std::filesystem::path const &path)
+{
+    using ResultType = Result<std::shared_ptr<SnapshotFile const>, Error>;
+    int const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return ResultType::failure(err_io);
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        return ResultType::failure(err_io);
+    }
+    if (size_t(status.st_size) != snapshot_file_size)
+    {
+        close(fd);
+        return ResultType::failure(err_invalid_input);
+    }
+    // write_snapshot_file replaces a file rather than writing into it, so the mapping keeps the snapshot that was checked
+    void *const mapping = mmap(nullptr, snapshot_file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return ResultType::failure(err_io);
+
+    SnapshotFileHeader header;
+    std::memcpy(&header, mapping, sizeof header);
+    std::shared_ptr<SnapshotFile const> file(new SnapshotFile(mapping, header));
+    if (!is_valid_snapshot(header, file->memory()))
+        return ResultType::failure(err_invalid_input);
+    return ResultType::success(std::move(file));
+}
+
+SnapshotFile::~SnapshotFile()
+{
+    munmap(mapping, snapshot_file_size);
+}
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <base/base.h>
+#include <base/error.h>
+#include <vm/machine.defn.h>
+#include <vm/packed_word.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+namespace mix
+{
+MIX_BEGIN_BYTE_SIZE_NAMESPACE
+
+// Where the memory of a machine starts in a snapshot file, a page boundary so that it is mapped on pages of its own
+constexpr size_t snapshot_file_memory_offset = 4096;
+
+// A snapshot file, in native byte order: the header, zeros up to snapshot_file_memory_offset,
+// and then main_memory_size PackedWords, one for each cell.
+// Every field is 8 bytes wide after the first 16, so that the layout has no padding.
+struct SnapshotFileHeader
+{
+    static constexpr char expected_magic[8] = {'M', 'I', 'X', 'S', 'N', 'A', 'P', '\0'};
+    // Changed whenever the layout of a file, or what a file means, changes
+    static constexpr std::uint32_t current_version = 2;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_size;
+    std::uint64_t pc;
+    // rA, rI1 to rI6, rX and rJ
+    std::array<PackedWord, 9> registers;
+    std::uint64_t overflow;
+    // -1, 0 or 1 for less, equal or greater
+    std::int64_t comparison;
+    // The I/O instruction that the machine was stopped on and that is yet to be carried out, with io_op 0 for none
+    std::uint64_t io_op;
+    std::uint64_t io_unit;
+    std::uint64_t io_M;
+    SnapshotCounters counters;
+    // Over the header, with checksum 0, and then the memory (see snapshot_file_checksum)
+    std::uint64_t checksum;
+};
+
+static_assert(sizeof(SnapshotFileHeader) <= snapshot_file_memory_offset);
+
+// Writes a snapshot of a machine, e.g. of a long job that is moved to another process, or of a program just loaded.
+// Written with write_file_atomically.
+// Fails with err_io if the file cannot be written.
+Result<void, Error> write_snapshot_file(std::filesystem::path const &path, MachineSnapshot const &snapshot, SnapshotCounters const &counters);
+
+// A snapshot file mapped into memory, which Machine::restore reads the memory of in place, as many times as it is restored.
+// Mapping a file checks it once, so that restoring it never has to.
+class SnapshotFile
+{
+    void *mapping;
+    SnapshotFileHeader header_;
+    std::uint64_t serial_ = new_snapshot_serial();
+
+    SnapshotFile(void *mapping, SnapshotFileHeader const &header) : mapping(mapping), header_(header) {}
+
+public:
+    // Fails with err_io if the file cannot be mapped, and with err_invalid_input unless it has the magic, version
+    // and byte size of this build, the size of a snapshot file and a checksum that holds, and every word in it
+    // fits where it is loaded.
+    static Result<std::shared_ptr<SnapshotFile const>, Error> map(std::filesystem::path const &path);
+
+    SnapshotFile(SnapshotFile const &) = delete;
+    SnapshotFile &operator=(SnapshotFile const &) = delete;
+    ~SnapshotFile();
+
+    SnapshotFileHeader const &header() const
+    {
+        return header_;
+    }
+
+    // Of the mapping, like the serial of a MachineSnapshot (see Machine::restore)
+    std::uint64_t serial() const
+    {
+        return serial_;
+    }
+
+    std::span<PackedWord const, main_memory_size> memory() const
+    {
+        return std::span<PackedWord const, main_memory_size>(
+            reinterpret_cast<PackedWord const *>(static_cast<std::byte const *>(mapping) + snapshot_file_memory_offset), main_memory_size);
+    }
+};
+
+MIX_END_BYTE_SIZE_NAMESPACE
+}
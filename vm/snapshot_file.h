@@ -0,0 +1,2 @@
+#pragma once
+#include <vm/snapshot_file.defn.h>
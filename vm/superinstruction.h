@@ -0,0 +1,72 @@
+#pragma once
+#include <base/base.h>
+#include <vm/op_list.h>
+
+#include <array>
+#include <cstddef>
+namespace mix
+{
+
+// A superinstruction runs a sequence of instructions in consecutive cells with one dispatch.
+// The sequences come from vm/superinstruction_list.h, which tools/mix_superinstructions.cpp generates
+// from the handler sequences that profiled runs execute most (see vm/sequence_profile.h).
+//
+// Every instruction but the last of a sequence falls through to the next cell and leaves memory alone,
+// so a superinstruction can only stop partway through on a trap,
+// and the cells of a superinstruction cannot change while it runs.
+
+constexpr size_t max_superinstruction_length = 3;
+
+struct Superinstruction
+{
+    OpHandler handler;
+    NativeByte length;
+    std::array<OpHandler, max_superinstruction_length> handlers;
+};
+
+// Whether a handler can be followed by another one in a superinstruction
+constexpr bool fuses_with_next(OpHandler handler)
+{
+    if (handler >= h_invalid)
+        return false;
+    NativeByte const C = handler_op_codes[handler];
+    // Jumps, I/O, stores, MOVE and HLT
+    return !(C >= op_sta && C <= op_jxn) && C != op_move && handler != h_hlt;
+}
+
+#define SUPERINSTRUCTION_COUNT_ITERATOR(NAME, ...) + 1
+constexpr size_t superinstruction_count = 0 SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_COUNT_ITERATOR);
+#undef SUPERINSTRUCTION_COUNT_ITERATOR
+
+#define SUPERINSTRUCTION_ITERATOR(NAME, ...) \
+    Superinstruction{ \
+        .handler = h_##NAME, \
+        .length = NativeByte(std::array{__VA_ARGS__}.size()), \
+        .handlers = {__VA_ARGS__}, \
+    },
+constexpr std::array<Superinstruction, superinstruction_count> superinstructions = {{
+    SUPERINSTRUCTION_LIST(SUPERINSTRUCTION_ITERATOR)
+}};
+#undef SUPERINSTRUCTION_ITERATOR
+
+constexpr bool superinstructions_are_valid()
+{
+    for (size_t i = 0; i < superinstructions.size(); i++)
+    {
+        Superinstruction const &s = superinstructions[i];
+        if (s.handler != h_idiom + 1 + i || s.length < 2 || s.length > max_superinstruction_length)
+            return false;
+        for (NativeByte k = 0; k + 1 < s.length; k++)
+            if (!fuses_with_next(s.handlers[k]))
+                return false;
+        if (s.handlers[s.length - 1] >= h_invalid)
+            return false;
+        // Longest first, so that the predecoder picks the longest match
+        if (i > 0 && superinstructions[i - 1].length < s.length)
+            return false;
+    }
+    return true;
+}
+static_assert(superinstructions_are_valid());
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+// Generated by tools/mix_superinstructions.cpp. Do not edit.
+
+// Expands IT(NAME, HANDLERS...) for every superinstruction, longest first
+#define SUPERINSTRUCTION_LIST(IT) \
+    /* saves 200000 dispatches */ IT(fused_add_indexed_full__dec1_direct__dec2_direct, h_add_indexed_full, h_dec1_direct, h_dec2_direct) \
+    /* saves 200000 dispatches */ IT(fused_mul_direct_full__slax_direct__add_indexed_full, h_mul_direct_full, h_slax_direct, h_add_indexed_full) \
+    /* saves 200000 dispatches */ IT(fused_slax_direct__add_indexed_full__dec1_direct, h_slax_direct, h_add_indexed_full, h_dec1_direct) \
+    /* saves 200000 dispatches */ IT(fused_dec1_direct__dec2_direct__j2nn_direct, h_dec1_direct, h_dec2_direct, h_j2nn_direct) \
+    /* saves 190760 dispatches */ IT(fused_entx_indexed__div_indexed_full__jxz_direct, h_entx_indexed, h_div_indexed_full, h_jxz_direct) \
+    /* saves 190760 dispatches */ IT(fused_enta_direct__entx_indexed__div_indexed_full, h_enta_direct, h_entx_indexed, h_div_indexed_full) \
+    /* saves 165040 dispatches */ IT(fused_cmpa_indexed_full__inc3_direct__jg_direct, h_cmpa_indexed_full, h_inc3_direct, h_jg_direct) \
+    /* saves 115920 dispatches */ IT(fused_enta_direct__ldx_direct_full__div_direct_full, h_enta_direct, h_ldx_direct_full, h_div_direct_full) \
+    /* saves 115920 dispatches */ IT(fused_ldx_direct_full__div_direct_full__jxz_direct, h_ldx_direct_full, h_div_direct_full, h_jxz_direct) \
+    /* saves 421680 dispatches */ IT(fused_cmpa_indexed_full__jge_direct, h_cmpa_indexed_full, h_jge_direct) \
+    /* saves 218960 dispatches */ IT(fused_dec2_direct__j2p_direct, h_dec2_direct, h_j2p_direct) \
+    /* saves 218960 dispatches */ IT(fused_ldx_indexed_full__stx_indexed_full, h_ldx_indexed_full, h_stx_indexed_full) \
+    /* saves 200000 dispatches */ IT(fused_dec3_direct__j3p_direct, h_dec3_direct, h_j3p_direct) \
+    /* saves 100000 dispatches */ IT(fused_dec2_direct__j2nn_direct, h_dec2_direct, h_j2nn_direct) \
+    /* saves 100000 dispatches */ IT(fused_add_indexed_full__dec1_direct, h_add_indexed_full, h_dec1_direct) \
+    /* saves 100000 dispatches */ IT(fused_mul_direct_full__slax_direct, h_mul_direct_full, h_slax_direct)
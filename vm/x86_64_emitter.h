@@ -0,0 +1,344 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+namespace mix
+{
+
+// Appends x86-64 machine code at a cursor, for the JIT (see vm/jit.h).
+// Only the few instructions that the JIT needs are supported.
+// Register operands are limited to rax, rcx, rdx, rbx, rsi and rdi,
+// and memory operands are [base + disp32] with rbx or r12 as the base, or [base + index + disp32] with an unscaled index.
+// Byte registers are the low bytes of rax, rcx, rdx and rbx, i.e. al, cl, dl and bl.
+// The caller makes sure that there is room for what it emits.
+class X86_64Emitter
+{
+public:
+    enum Reg : std::uint8_t
+    {
+        rax = 0,
+        rcx = 1,
+        rdx = 2,
+        rbx = 3,
+        rsi = 6,
+        rdi = 7,
+    };
+
+    enum Base : std::uint8_t
+    {
+        base_rbx,
+        base_r12,
+    };
+
+    enum Width : std::uint8_t
+    {
+        w8,
+        w16,
+        w32,
+        w64,
+    };
+
+    // The 4-bit condition code of a Jcc
+    enum Condition : std::uint8_t
+    {
+        c_below = 0x2,
+        c_above_or_equal = 0x3,
+        c_equal = 0x4,
+        c_not_equal = 0x5,
+        c_less = 0xC,
+        c_greater_or_equal = 0xD,
+        c_less_or_equal = 0xE,
+        c_greater = 0xF,
+    };
+
+    // Where the rel32 of an emitted jump lives, so that the jump can be pointed somewhere later
+    using JumpSite = std::uint8_t *;
+
+private:
+    std::uint8_t *cursor;
+
+    void byte(std::uint8_t b)
+    {
+        *cursor++ = b;
+    }
+
+    void imm32(std::uint32_t imm)
+    {
+        std::memcpy(cursor, &imm, sizeof(imm));
+        cursor += sizeof(imm);
+    }
+
+    void imm64(std::uint64_t imm)
+    {
+        std::memcpy(cursor, &imm, sizeof(imm));
+        cursor += sizeof(imm);
+    }
+
+    // Operand size and REX prefixes for a memory operand, the REX prefix left out when it would be empty
+    void rex(Width width, Base base)
+    {
+        if (width == w16)
+            byte(0x66);
+        std::uint8_t const prefix = 0x40 | (width == w64 ? 0x08 : 0) | (base == base_r12 ? 0x01 : 0);
+        if (prefix != 0x40)
+            byte(prefix);
+    }
+
+    void immediate(Width width, std::uint32_t imm)
+    {
+        if (width == w8)
+            byte(std::uint8_t(imm));
+        else if (width == w16)
+        {
+            byte(std::uint8_t(imm));
+            byte(std::uint8_t(imm >> 8));
+        }
+        else
+            imm32(imm);
+    }
+
+    // ModRM (and SIB) for [base + disp32]
+    void memory_operand(std::uint8_t reg_field, Base base, std::int32_t disp)
+    {
+        byte(0x80 | reg_field << 3 | (base == base_r12 ? 0x04 : 0x03));
+        if (base == base_r12)
+            byte(0x24);
+        imm32(std::uint32_t(disp));
+    }
+
+    // ModRM and SIB for [base + index + disp32]
+    void indexed_memory_operand(std::uint8_t reg_field, Base base, Reg index, std::int32_t disp)
+    {
+        byte(0x84 | reg_field << 3);
+        byte(index << 3 | (base == base_r12 ? 0x04 : rbx));
+        imm32(std::uint32_t(disp));
+    }
+
+    void register_operands(std::uint8_t opcode, Reg src, Reg dst)
+    {
+        byte(0x48);
+        byte(opcode);
+        byte(0xC0 | src << 3 | dst);
+    }
+
+public:
+    explicit X86_64Emitter(std::uint8_t *cursor)
+        : cursor(cursor)
+    {}
+
+    std::uint8_t *position() const
+    {
+        return cursor;
+    }
+
+    // Points the jump at site to target
+    static void patch(JumpSite site, std::uint8_t const *target)
+    {
+        std::int32_t const rel = std::int32_t(target - (site + sizeof(std::int32_t)));
+        std::memcpy(site, &rel, sizeof(rel));
+    }
+
+    void push_rbx() { byte(0x53); }
+    void pop_rbx() { byte(0x5B); }
+    void push_r12() { byte(0x41); byte(0x54); }
+    void pop_r12() { byte(0x41); byte(0x5C); }
+    void ret() { byte(0xC3); }
+
+    void sub_rsp(std::uint8_t imm) { byte(0x48); byte(0x83); byte(0xEC); byte(imm); }
+    void add_rsp(std::uint8_t imm) { byte(0x48); byte(0x83); byte(0xC4); byte(imm); }
+
+    // mov rbx, rdi and mov r12, rsi
+    void mov_rbx_rdi() { byte(0x48); byte(0x89); byte(0xFB); }
+    void mov_r12_rsi() { byte(0x49); byte(0x89); byte(0xF4); }
+
+    void mov_eax_imm(std::uint32_t imm) { byte(0xB8); imm32(imm); }
+
+    void call(Reg reg) { byte(0xFF); byte(0xD0 | reg); }
+    void jmp(Reg reg) { byte(0xFF); byte(0xE0 | reg); }
+
+    void cmp_al(std::uint8_t imm) { byte(0x3C); byte(imm); }
+    void test_al_al() { byte(0x84); byte(0xC0); }
+
+    // mov [base + disp], imm, with imm sign-extended for w64
+    void mov(Width width, Base base, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0xC6 : 0xC7);
+        memory_operand(0, base, disp);
+        immediate(width, imm);
+    }
+
+    // mov [base + index + disp], imm, with imm sign-extended for w64
+    void mov(Width width, Base base, Reg index, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0xC6 : 0xC7);
+        indexed_memory_operand(0, base, index, disp);
+        immediate(width, imm);
+    }
+
+    // mov reg, [base + disp], zero-extended for w8
+    void mov(Width width, Reg reg, Base base, std::int32_t disp)
+    {
+        rex(width, base);
+        if (width == w8)
+            byte(0x0F);
+        byte(width == w8 ? 0xB6 : 0x8B);
+        memory_operand(reg, base, disp);
+    }
+
+    // mov reg, [base + index + disp], zero-extended for w8
+    void mov(Width width, Reg reg, Base base, Reg index, std::int32_t disp)
+    {
+        rex(width, base);
+        if (width == w8)
+            byte(0x0F);
+        byte(width == w8 ? 0xB6 : 0x8B);
+        indexed_memory_operand(reg, base, index, disp);
+    }
+
+    // mov [base + disp], reg
+    void mov(Width width, Base base, std::int32_t disp, Reg reg)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0x88 : 0x89);
+        memory_operand(reg, base, disp);
+    }
+
+    // mov [base + index + disp], reg
+    void mov(Width width, Base base, Reg index, std::int32_t disp, Reg reg)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0x88 : 0x89);
+        indexed_memory_operand(reg, base, index, disp);
+    }
+
+    // mov reg, imm64
+    void mov(Reg reg, std::uint64_t imm)
+    {
+        byte(0x48);
+        byte(0xB8 | reg);
+        imm64(imm);
+    }
+
+    // mov dst, src
+    void mov(Reg dst, Reg src) { register_operands(0x89, src, dst); }
+
+    // cmp [base + disp], imm
+    void cmp(Width width, Base base, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0x80 : 0x81);
+        memory_operand(7, base, disp);
+        immediate(width, imm);
+    }
+
+    // cmp [base + index + disp], imm
+    void cmp(Width width, Base base, Reg index, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(width, base);
+        byte(width == w8 ? 0x80 : 0x81);
+        indexed_memory_operand(7, base, index, disp);
+        immediate(width, imm);
+    }
+
+    // bts [base + disp], imm (w64), which sets bit imm of the word at base + disp
+    void bts(Base base, std::int32_t disp, std::uint8_t imm)
+    {
+        rex(w64, base);
+        byte(0x0F);
+        byte(0xBA);
+        memory_operand(5, base, disp);
+        byte(imm);
+    }
+
+    // bts [base + disp], reg (w64), which sets bit reg of the bit string at base + disp
+    void bts(Base base, std::int32_t disp, Reg reg)
+    {
+        rex(w64, base);
+        byte(0x0F);
+        byte(0xAB);
+        memory_operand(reg, base, disp);
+    }
+
+    // add [base + disp], imm (w64)
+    void add(Base base, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(w64, base);
+        byte(0x81);
+        memory_operand(0, base, disp);
+        imm32(imm);
+    }
+
+    // sub [base + disp], imm (w64)
+    void sub(Base base, std::int32_t disp, std::uint32_t imm)
+    {
+        rex(w64, base);
+        byte(0x81);
+        memory_operand(5, base, disp);
+        imm32(imm);
+    }
+
+    // add reg, imm (w64, imm sign-extended)
+    void add(Reg reg, std::int32_t imm)
+    {
+        byte(0x48);
+        byte(0x81);
+        byte(0xC0 | reg);
+        imm32(std::uint32_t(imm));
+    }
+
+    // and reg, imm and cmp reg, imm (w64, imm sign-extended)
+    void and_(Reg reg, std::int32_t imm) { byte(0x48); byte(0x81); byte(0xE0 | reg); imm32(std::uint32_t(imm)); }
+    void cmp(Reg reg, std::int32_t imm) { byte(0x48); byte(0x81); byte(0xF8 | reg); imm32(std::uint32_t(imm)); }
+
+    // imul dst, src, imm (w64)
+    void imul(Reg dst, Reg src, std::int32_t imm) { byte(0x48); byte(0x69); byte(0xC0 | dst << 3 | src); imm32(std::uint32_t(imm)); }
+
+    void add(Reg dst, Reg src) { register_operands(0x01, src, dst); }
+    void or_(Reg dst, Reg src) { register_operands(0x09, src, dst); }
+    void and_(Reg dst, Reg src) { register_operands(0x21, src, dst); }
+    void sub(Reg dst, Reg src) { register_operands(0x29, src, dst); }
+    void xor_(Reg dst, Reg src) { register_operands(0x31, src, dst); }
+    void cmp(Reg dst, Reg src) { register_operands(0x39, src, dst); }
+    void test(Reg dst, Reg src) { register_operands(0x85, src, dst); }
+
+    void neg(Reg reg) { byte(0x48); byte(0xF7); byte(0xD8 | reg); }
+    void shl(Reg reg, std::uint8_t imm) { byte(0x48); byte(0xC1); byte(0xE0 | reg); byte(imm); }
+    void shr(Reg reg, std::uint8_t imm) { byte(0x48); byte(0xC1); byte(0xE8 | reg); byte(imm); }
+    void sar(Reg reg, std::uint8_t imm) { byte(0x48); byte(0xC1); byte(0xF8 | reg); byte(imm); }
+
+    // and reg32, imm8 and xor reg32, imm8
+    void and_32(Reg reg, std::uint8_t imm) { byte(0x83); byte(0xE0 | reg); byte(imm); }
+    void xor_32(Reg reg, std::uint8_t imm) { byte(0x83); byte(0xF0 | reg); byte(imm); }
+
+    // setcc reg8, and sub dst8, src8
+    void setcc(Condition condition, Reg reg) { byte(0x0F); byte(0x90 | condition); byte(0xC0 | reg); }
+    void sub_8(Reg dst, Reg src) { byte(0x28); byte(0xC0 | src << 3 | dst); }
+
+    // Jumps with a rel32 that is patched later
+    JumpSite jmp()
+    {
+        byte(0xE9);
+        JumpSite const site = cursor;
+        imm32(0);
+        return site;
+    }
+
+    JumpSite jcc(Condition condition)
+    {
+        byte(0x0F);
+        byte(0x80 | condition);
+        JumpSite const site = cursor;
+        imm32(0);
+        return site;
+    }
+
+    // Points the jump at site to the current position
+    void bind(JumpSite site)
+    {
+        patch(site, cursor);
+    }
+};
+
+}